@@ -0,0 +1,119 @@
+#include "storage/bill_json_reader.h"
+#include "storage/json_storage.h"
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <sys/resource.h>
+
+using namespace accounting;
+
+// 账单文件加载基准：对比 DOM 解析（json + get<T>()）、SAX 流式解析，
+// 以及 CBOR / MessagePack 编码下 SAX 解析的文件大小、耗时和峰值内存。
+//   json_load_benchmark [用户数] [每用户账单数]   生成数据并分别在子进程中测量各方式
+//   json_load_benchmark generate <目录> <用户数> <每用户账单数>
+//   json_load_benchmark load <dom|sax|cbor|msgpack> <目录>
+// 峰值内存取自子进程的 ru_maxrss，每种方式单独一个进程，互不影响。
+
+static long PeakRssKb() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;  // Linux 下单位为 KB
+}
+
+static int Generate(const std::string& dir, int users, int bills_per_user) {
+    std::map<int, std::vector<Bill>> data;
+    auto t0 = std::chrono::system_clock::from_time_t(1700000000);
+    for (int u = 1; u <= users; ++u) {
+        auto& bills = data[u];
+        bills.reserve(bills_per_user);
+        for (int i = 1; i <= bills_per_user; ++i) {
+            Bill bill(i, (i % 1000) * 0.5, nullptr, t0 + std::chrono::minutes(i),
+                      "benchmark bill " + std::to_string(i));
+            bill.SetCategoryId(i % 8);
+            bills.push_back(std::move(bill));
+        }
+    }
+    // 三种编码的文件扩展名不同，写在同一目录下
+    for (auto encoding : {JsonStorageOptions::Encoding::kText, JsonStorageOptions::Encoding::kCbor,
+                          JsonStorageOptions::Encoding::kMessagePack}) {
+        JsonStorageOptions options;
+        options.encoding = encoding;
+        JsonStorage storage(dir, options);
+        if (!storage.SaveBillsByUser(data)) {
+            std::cerr << "[错误] 写入 " << dir << " 失败\n";
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static int Load(const std::string& mode, const std::string& dir) {
+    const long rss_before = PeakRssKb();
+    auto start = std::chrono::steady_clock::now();
+
+    std::map<int, std::vector<Bill>> data;
+    const std::string extension = (mode == "dom" || mode == "sax") ? "json" : mode;
+    std::ifstream file(dir + "/bills." + extension, std::ios::binary);
+    if (!file.is_open()) return 1;
+    if (mode == "dom") {
+        try {
+            json j;
+            file >> j;
+            data = j.get<std::map<int, std::vector<Bill>>>();
+        } catch (...) {
+            return 1;
+        }
+    } else if (mode == "sax") {
+        if (!ReadBillsJson(file, data)) return 1;
+    } else if (mode == "cbor") {
+        if (!ReadBillsJson(file, data, json::input_format_t::cbor)) return 1;
+    } else if (mode == "msgpack") {
+        if (!ReadBillsJson(file, data, json::input_format_t::msgpack)) return 1;
+    } else {
+        return 2;
+    }
+
+    auto elapsed = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+    size_t count = 0;
+    for (const auto& [_, bills] : data) count += bills.size();
+    std::cout << mode << ": " << count << " bills, " << elapsed << " ms, peak RSS "
+              << PeakRssKb() << " KB (+" << PeakRssKb() - rss_before << " KB)\n";
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc == 5 && std::string(argv[1]) == "generate") {
+        return Generate(argv[2], std::atoi(argv[3]), std::atoi(argv[4]));
+    }
+    if (argc == 4 && std::string(argv[1]) == "load") {
+        return Load(argv[2], argv[3]);
+    }
+
+    const int users = argc > 1 ? std::atoi(argv[1]) : 10;
+    const int bills_per_user = argc > 2 ? std::atoi(argv[2]) : 20000;
+    const std::string dir =
+        (std::filesystem::temp_directory_path() / "accounting_json_load_benchmark").string();
+    std::filesystem::remove_all(dir);
+
+    const std::string self = argv[0];
+    int rc = std::system((self + " generate " + dir + " " + std::to_string(users) + " " +
+                          std::to_string(bills_per_user)).c_str());
+    if (rc == 0) {
+        for (const char* extension : {"json", "cbor", "msgpack"}) {
+            const std::string name = std::string("bills.") + extension;
+            std::cout << name << ": " << std::filesystem::file_size(dir + "/" + name) / 1024
+                      << " KB\n";
+        }
+        std::cout << std::flush;
+        for (const char* mode : {"dom", "sax", "cbor", "msgpack"}) {
+            rc = std::system((self + " load " + mode + " " + dir).c_str());
+            if (rc != 0) break;
+        }
+    }
+    std::filesystem::remove_all(dir);
+    return rc == 0 ? 0 : 1;
+}
@@ -0,0 +1,101 @@
+#include "managers/bill_manager.h"
+#include "managers/report_manager.h"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+using namespace accounting;
+
+// 报表生成基准：对比先把账单复制成 BillData 再 Report::Generate（旧做法），
+// 与 ReportManager 直接在账单视图上按分类 id 汇总的耗时和堆分配次数。
+//   report_benchmark [账单数]
+// 过滤条件为金额范围，不走按日汇总的快速路径；报表缓存关闭，每次都重新生成。
+
+static size_t g_allocations = 0;
+static size_t g_allocated_bytes = 0;
+
+void* operator new(std::size_t size) {
+    ++g_allocations;
+    g_allocated_bytes += size;
+    if (void* p = std::malloc(size == 0 ? 1 : size)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](std::size_t size) { return operator new(size); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+
+static Report FromBillData(const BillManager& bill_manager, const QueryCriteria& criteria,
+                           Period period) {
+    std::vector<BillData> bill_data_list;
+    bill_manager.ForEachBillMatching(1, criteria, [&bill_data_list](const BillView& bill) {
+        bill_data_list.emplace_back(bill.amount,
+                                    bill.category ? bill.category->GetName() : std::string(),
+                                    bill.category ? bill.category->GetType() : std::string(),
+                                    bill.time, std::string(bill.content));
+    });
+    return Report::Generate(bill_data_list, QueryCriteria(), period, ChartType::kBar);
+}
+
+template<typename Fn>
+static void Measure(const char* name, Fn&& fn) {
+    const size_t allocations_before = g_allocations;
+    const size_t bytes_before = g_allocated_bytes;
+    auto start = std::chrono::steady_clock::now();
+    Report report = fn();
+    auto elapsed = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+    std::cout << "  " << name << ": " << elapsed << " ms, " << g_allocations - allocations_before
+              << " allocations, " << (g_allocated_bytes - bytes_before) / 1024 << " KB, "
+              << report.GetCategorySummary().size() << " categories, "
+              << report.GetSeries().size() << " buckets\n";
+}
+
+int main(int argc, char* argv[]) {
+    const int bills = argc > 1 ? std::atoi(argv[1]) : 200000;
+
+    std::vector<std::shared_ptr<const Category>> categories;
+    for (int i = 0; i < 8; ++i) {
+        categories.push_back(std::make_shared<const Category>(
+            i + 1, "benchmark category " + std::to_string(i), i == 0 ? "income" : "expense",
+            "#000000"));
+    }
+    BillManager bill_manager;
+    std::vector<Bill> batch;
+    batch.reserve(bills);
+    auto t0 = std::chrono::system_clock::from_time_t(1700000000);
+    for (int i = 0; i < bills; ++i) {
+        Bill bill;
+        bill.SetMoney(Money::FromCents(100 + i % 5000));
+        bill.SetTime(t0 + std::chrono::minutes(i * 7));
+        bill.SetCategoryId(i % 8 + 1);
+        bill.SetCategory(categories[i % 8]);
+        bill.SetContent("benchmark bill " + std::to_string(i));
+        batch.push_back(std::move(bill));
+    }
+    bill_manager.AddBills(1, batch);
+    batch.clear();
+
+    ReportCacheOptions no_cache;
+    no_cache.max_entries = 0;
+    ReportManager report_manager(&bill_manager, no_cache);
+    QueryCriteria criteria;
+    criteria.SetAmountRange(Money::FromCents(200), Money::FromCents(4800));
+    // 先生成一次，建立 BillManager 的索引
+    report_manager.GenerateReport(1, criteria, Period::kCustom, ChartType::kBar);
+
+    std::cout << bills << " bills\n";
+    for (Period period : {Period::kCustom, Period::kMonthly}) {
+        std::cout << (period == Period::kCustom ? "custom" : "monthly") << ":\n";
+        Measure("bill_data", [&]() { return FromBillData(bill_manager, criteria, period); });
+        Measure("direct", [&]() {
+            return report_manager.GenerateReport(1, criteria, period, ChartType::kBar);
+        });
+    }
+    return 0;
+}
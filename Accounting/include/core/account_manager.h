@@ -1,8 +1,10 @@
 #ifndef ACCOUNTING_CORE_ACCOUNT_MANAGER_H_
 #define ACCOUNTING_CORE_ACCOUNT_MANAGER_H_
 
+#include <list>
 #include <memory>
 #include <optional>
+#include <unordered_map>
 #include <string>
 #include <vector>
 #include <chrono>
@@ -18,6 +20,21 @@
 
 namespace accounting {
 
+// AccountManager 的可选行为
+struct AccountManagerOptions {
+    // 懒加载：Initialize 只读取用户索引，用户的分类、预算、账单在登录或第一次修改时才加载。
+    // 存储按用户分片（JsonStorageOptions::Layout::kSharded）时只读取该用户的文件
+    bool lazy_load = false;
+    // 懒加载模式下常驻内存的用户数上限（0 表示不限）。超出时按 LRU 释放最久未访问、
+    // 且没有未保存修改的用户
+    size_t max_resident_users = 0;
+    // Initialize 时用户、分类、预算、账单四类数据在各自的线程中并行读取，
+    // 要求 Storage 的不同 Load* 方法可以并发调用
+    bool parallel_initialize = true;
+    // 报表缓存容量（见 ReportCacheOptions）；账单修改后缓存按版本号自动失效
+    ReportCacheOptions report_cache;
+};
+
 /**
  * @brief AccountManager 是系统的核心调度器（业务外观 Facade）。
  *
@@ -36,8 +53,10 @@ public:
     /**
      * @brief 构造函数，接受一个共享的 Storage 实例。
      * @param storage 统一的存储层，用于各 Manager 加载和保存数据。
+     * @param options 可选行为（懒加载等）
      */
-    explicit AccountManager(std::shared_ptr<Storage> storage);
+    explicit AccountManager(std::shared_ptr<Storage> storage,
+                            const AccountManagerOptions& options = AccountManagerOptions());
 
     /**
      * @brief 初始化系统，从存储中加载所有数据。
@@ -51,6 +70,11 @@ public:
      */
     bool SaveAll() const;
 
+    /**
+     * @brief 懒加载模式下当前常驻内存的用户，按最近访问排序（最近的在前）
+     */
+    std::vector<int> GetResidentUsers() const;
+
     // ========== 第一阶段：带错误处理的用户相关操作 ==========
 
     /**
@@ -85,6 +109,18 @@ public:
      */
     OperationResult<void> AddBillEx(int user_id, const Bill& bill);
 
+    /**
+     * @brief 批量添加账单（如导入账单流水）
+     *
+     * 逐行的验证和预算检查与 AddBillEx 相同，但预算只读取一次、容量只预留一次、
+     * 索引批量维护、报表缓存只清空一次。某行失败不影响其他行。
+     *
+     * @param user_id 用户 ID
+     * @param bills 待添加的账单，调用后内容不再有效
+     * @return 与 bills 等长的逐行结果
+     */
+    std::vector<OperationResult<void>> AddBillsEx(int user_id, std::vector<Bill>&& bills);
+
     /**
      * @brief 更新账单（带详细错误信息）
      * @param user_id 用户 ID
@@ -139,6 +175,8 @@ public:
     bool UpdateCategory(const User& user, const Category& category);
     bool DeleteCategory(const User& user, int category_id);
     std::vector<Category> GetCategories(const User& user) const;
+    // 分类管理器中共享的分类对象，用于设置账单分类（不复制分类）；不存在时返回 nullptr
+    std::shared_ptr<const Category> GetCategory(const User& user, int category_id) const;
 
     // ========== 第一阶段：带错误处理的预算相关操作 ==========
 
@@ -231,6 +269,18 @@ public:
      */
     PagedResult<Bill> GetBillsPaged(int user_id, int page_number, int page_size) const;
 
+    /**
+     * @brief 按游标获取下一页账单（按时间、账单 ID 升序）
+     *
+     * 通过时间索引直接定位到游标之后，不需要跳过前面的页
+     *
+     * @param user_id 用户 ID
+     * @param cursor 上一页返回的 next_cursor；默认值表示从第一个账单开始
+     * @param page_size 每页大小
+     * @return 当前页的账单和下一页的游标
+     */
+    CursorPage<Bill> GetBillsAfter(int user_id, const BillCursor& cursor, int page_size) const;
+
     /**
      * @brief 统计指定分类在日期范围内的总支出
      * @param user_id 用户 ID
@@ -324,6 +374,7 @@ public:
 private:
     // === 内部组件 ===
     std::shared_ptr<Storage> storage_;
+    AccountManagerOptions options_;
 
     UserManager user_manager_;
     BillManager bill_manager_;
@@ -331,11 +382,19 @@ private:
     CategoryManager category_manager_;
     std::unique_ptr<ReportManager> report_manager_;
 
+    // === 懒加载 ===
+    std::list<int> resident_users_;  // 常驻用户，最近访问的在前
+    std::unordered_map<int, std::list<int>::iterator> resident_index_;
+
     // === 内部逻辑 ===
     // 注意：此方法不修改对象状态，因此标记为 const，使得
     // 在 const 上下文（例如 CanAddBill）中可安全调用。
     bool CheckBudgetBeforeAdd(int user_id, const Bill& bill) const;
 
+    // 确保用户数据已加载并记为最近访问；懒加载模式下可能触发 LRU 释放
+    bool TouchUser(int user_id);
+    void EvictIdleUsers();
+
     // === 内部辅助方法 ===
     
     /**
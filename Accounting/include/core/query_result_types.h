@@ -1,6 +1,8 @@
 #ifndef ACCOUNTING_CORE_QUERY_RESULT_TYPES_H_
 #define ACCOUNTING_CORE_QUERY_RESULT_TYPES_H_
 
+#include <chrono>
+#include <limits>
 #include <vector>
 #include <string>
 
@@ -43,6 +45,28 @@ struct PagedResult {
     }
 };
 
+/**
+ * @brief 账单游标（键集分页的位置）
+ *
+ * 表示按 (时间, 账单 ID) 升序排列中的一个位置；默认值位于第一个账单之前
+ */
+struct BillCursor {
+    std::chrono::system_clock::time_point time = std::chrono::system_clock::time_point::min();
+    int bill_id = std::numeric_limits<int>::min();
+};
+
+/**
+ * @brief 游标分页查询结果
+ *
+ * 把 next_cursor 传回下一次查询即可取得下一页，翻页代价与页码无关
+ */
+template<typename T>
+struct CursorPage {
+    std::vector<T> items;           // 当前页的数据项
+    BillCursor next_cursor;         // 当前页最后一项的位置；没有数据时与请求的游标相同
+    bool has_more = false;          // 之后是否还有数据
+};
+
 // ============ 第四阶段：预算分析结果类型 ============
 
 /**
@@ -0,0 +1,111 @@
+#ifndef ACCOUNTING_MANAGERS_BILL_COLUMNS_H_
+#define ACCOUNTING_MANAGERS_BILL_COLUMNS_H_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "models/bill.h"
+#include "models/query_criteria.h"
+
+namespace accounting {
+
+/**
+ * @brief 只读账单视图，字段直接引用存储中的数据
+ *
+ * 由 BillManager::ForEachBill 等遍历接口传给回调，不复制备注文本、不增加分类指针的引用计数。
+ * 只在回调内有效，需要保留时用 ToBill() 复制（分类对象仍与存储共享，不复制）。
+ */
+struct BillView {
+    int bill_id = 0;
+    Money amount;
+    std::chrono::system_clock::time_point time;
+    int category_id = -1;
+    std::string_view content;
+    const Category* category = nullptr;  // 没有关联分类时为空
+    // 指向存储中该分类的共享指针，ToBill 时共享同一对象；没有关联分类时为空
+    const std::shared_ptr<const Category>* shared_category = nullptr;
+
+    static BillView FromBill(const Bill& bill);
+    Bill ToBill() const;
+    // 供 QueryCriteria / QueryPredicate 求值，引用本视图的数据
+    QueryRow ToQueryRow() const;
+};
+
+/**
+ * @brief 单个用户账单的列式（struct-of-arrays）内存存储
+ *
+ * 账单 id、金额、时间、分类 id 各自存放在连续数组中，聚合时只顺序读取需要的列；
+ * 备注文本集中存放在一块字符串区中，按 (偏移, 长度) 引用。
+ * 分类指针按分类 id 每个用户只保存一份，不随行复制。
+ * 行号在 SwapRemove 后会变化，外部应按账单 id 定位行。
+ */
+class BillColumns {
+public:
+    using TimePoint = std::chrono::system_clock::time_point;
+
+    BillColumns() = default;
+    explicit BillColumns(const std::vector<Bill>& bills);
+
+    size_t Size() const { return bill_id_.size(); }
+    bool Empty() const { return bill_id_.empty(); }
+    // 预留 rows 行、content_bytes 字节备注文本的容量（均为总量）
+    void Reserve(size_t rows, size_t content_bytes = 0);
+
+    // === 列访问 ===
+    const std::vector<int>& BillIds() const { return bill_id_; }
+    // 金额列，单位为分（见 Money），可直接交给 money_sum 的求和内核
+    const std::vector<int64_t>& AmountCents() const { return amount_; }
+    const std::vector<TimePoint>& Times() const { return time_; }
+    const std::vector<int>& CategoryIds() const { return category_id_; }
+    std::string_view Content(size_t row) const;
+    // 备注文本区当前占用的字节数（含已废弃的文本）
+    size_t ContentBytes() const { return content_.size(); }
+    // 某分类 id 对应的分类；没有关联分类时返回 nullptr
+    std::shared_ptr<const Category> GetCategory(int category_id) const;
+    const Category* FindCategory(int category_id) const;
+    // 同上，返回表中共享指针的地址（不增加引用计数），表中没有时返回 nullptr
+    const std::shared_ptr<const Category>* FindSharedCategory(int category_id) const;
+
+    // === 行操作 ===
+    void Append(const Bill& bill);
+    void Assign(size_t row, const Bill& bill);
+    // 用最后一行填补 row，不移动中间的行
+    void SwapRemove(size_t row);
+
+    // 按行构造 Bill（分类指针取自该用户的分类表）
+    Bill Materialize(size_t row) const;
+    std::vector<Bill> MaterializeAll() const;
+    // 按行构造只读视图，不复制备注文本
+    BillView View(size_t row) const;
+
+    // === 分类指针 ===
+    // 设置某分类 id 对应的分类；category 为空时取消关联（行上的分类 id 保留）
+    void SetCategory(int category_id, std::shared_ptr<const Category> category);
+    // 当前行中出现过的分类 id（去重）
+    std::vector<int> DistinctCategoryIds() const;
+
+private:
+    void RememberCategory(const Bill& bill);
+    void StoreContent(size_t row, const std::string& content);
+    // 废弃的文本超过一半时重建字符串区
+    void MaybeCompactContent();
+
+    std::vector<int> bill_id_;
+    std::vector<int64_t> amount_;
+    std::vector<TimePoint> time_;
+    std::vector<int> category_id_;
+    std::vector<size_t> content_offset_;
+    std::vector<size_t> content_length_;
+    std::string content_;             // 备注文本区
+    size_t dead_content_bytes_ = 0;   // 已删除/被覆盖行占用的字节数
+    std::unordered_map<int, std::shared_ptr<const Category>> categories_;  // category_id -> 分类
+};
+
+}  // namespace accounting
+
+#endif  // ACCOUNTING_MANAGERS_BILL_COLUMNS_H_
@@ -1,13 +1,22 @@
 #ifndef ACCOUNTING_MANAGERS_BILL_MANAGER_H_
 #define ACCOUNTING_MANAGERS_BILL_MANAGER_H_
 
+#include <chrono>
+#include <cstdint>
 #include <map>
+#include <set>
 #include <vector>
 #include <memory>
 #include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include "managers/bill_columns.h"
+#include "managers/bill_rollup.h"
 #include "models/bill.h"
 #include "models/query_criteria.h"
 #include "storage/storage.h"
+#include "storage/mapped_bill_snapshot.h"
 
 namespace accounting {
 
@@ -19,21 +28,384 @@ public:
     bool AddBill(int user_id, Bill bill);
     bool UpdateBill(int user_id, const Bill& updated_bill);
     bool DeleteBill(int user_id, int bill_id);
+    // 批量添加：一次预留容量、一次批量维护索引。返回与 bills 等长的结果，
+    // false 表示该行未添加（bill_id 与已有账单或本批中前面的行重复、或写日志失败）。
+    // 自动分配的 id 写回 bills 中对应的行
+    std::vector<bool> AddBills(int user_id, std::vector<Bill>& bills);
 
     // === 查询接口 ===
     std::vector<Bill> GetBillsByUser(int user_id) const;
+    // 按条件查询，结果按 criteria 的排序字段排序并截断到 limit 条。
+    // 常驻内存的用户先由查询计划选出候选行（见 PlanQuery），再逐行检查全部条件
     std::vector<Bill> QueryBillsByCriteria(int user_id, const QueryCriteria& criteria) const;
 
+    // 查询计划可选的访问路径
+    enum class QueryAccessPath {
+        kBillId,         // 按账单 id 直接定位
+        kCategoryIndex,  // 分类索引中时间范围内的账单
+        kTimeIndex,      // 时间索引中时间范围内的账单
+        kScan,           // 在时间列、金额列、分类列上批量过滤全部行
+    };
+    // 常驻内存的用户执行该条件时选用的访问路径：估算各索引的候选行数，取最少的一个。
+    // 其他用户没有索引，总是返回 kScan
+    QueryAccessPath PlanQuery(int user_id, const QueryCriteria& criteria) const;
+    // 时间在 [start, end] 内的账单，按 (时间, bill_id) 升序。常驻内存的用户通过时间索引
+    // 二分定位，不扫描其余账单
+    std::vector<Bill> GetBillsInTimeRange(int user_id,
+                                          const std::chrono::system_clock::time_point& start,
+                                          const std::chrono::system_clock::time_point& end) const;
+    // 某分类的账单（可限定时间范围），按 (时间, bill_id) 升序；常驻内存的用户只访问该分类的账单
+    std::vector<Bill> GetBillsByCategory(int user_id, int category_id) const;
+    std::vector<Bill> GetBillsByCategoryInTimeRange(
+        int user_id, int category_id, const std::chrono::system_clock::time_point& start,
+        const std::chrono::system_clock::time_point& end) const;
+    // 金额合计（可限定时间范围 [start, end]），按分精确累加；
+    // 常驻内存的用户只顺序扫描时间列和金额列
+    Money SumAmount(int user_id) const;
+    Money SumAmountInTimeRange(int user_id, const std::chrono::system_clock::time_point& start,
+                               const std::chrono::system_clock::time_point& end) const;
+    // 账单数量，以及按存储顺序的第 [offset, offset + limit) 个账单（只构造这一段）
+    size_t CountBills(int user_id) const;
+    std::vector<Bill> GetBillsByUser(int user_id, size_t offset, size_t limit) const;
+    // 键集分页：按 (时间, bill_id) 升序，排在 (after_time, after_bill_id) 之后的至多 limit 个账单。
+    // 常驻内存的用户在时间索引上二分定位，代价为 O(log N + limit)，与已翻过的页数无关
+    std::vector<Bill> GetBillsAfter(int user_id,
+                                    const std::chrono::system_clock::time_point& after_time,
+                                    int after_bill_id, size_t limit) const;
+
+    // === 遍历接口 ===
+    // 逐个把账单的只读视图传给 fn（签名 void(const BillView&)），不复制账单。
+    // 常驻内存的用户直接读取列式存储；其余用户临时读取后遍历。
+    // 视图只在回调内有效，回调中不得修改本 BillManager 的账单
+    template<typename Fn>
+    void ForEachBill(int user_id, Fn&& fn) const;
+    // 时间在 [start, end] 内的账单，按 (时间, bill_id) 升序
+    template<typename Fn>
+    void ForEachBillInTimeRange(int user_id, const std::chrono::system_clock::time_point& start,
+                                const std::chrono::system_clock::time_point& end, Fn&& fn) const;
+    // 某分类（可限定时间范围）的账单，按 (时间, bill_id) 升序
+    template<typename Fn>
+    void ForEachBillInCategory(int user_id, int category_id, Fn&& fn) const;
+    template<typename Fn>
+    void ForEachBillInCategory(int user_id, int category_id,
+                               const std::chrono::system_clock::time_point& start,
+                               const std::chrono::system_clock::time_point& end, Fn&& fn) const;
+    // 满足 criteria 的账单，顺序与条数同 QueryBillsByCriteria
+    template<typename Fn>
+    void ForEachBillMatching(int user_id, const QueryCriteria& criteria, Fn&& fn) const;
+
+    // === 分类 / 按日汇总 ===
+    // 常驻内存的用户读取随增删改按差值维护的按日汇总（见 BillRollup），不访问账单；
+    // 其余用户使用已保存的汇总（第一次使用前与账单核对一次），没有时才临时遍历账单计算。
+    // 日期均为本地日期（见 time_utils::LocalDayNumber），区间含两端
+    using CategoryTotal = BillRollup::Total;
+    // 逐个分类把 (分类 id, 分类, 汇总) 传给 fn（签名 void(int, const Category*, const CategoryTotal&)），
+    // 没有关联分类时分类为 nullptr。分类顺序不固定
+    template<typename Fn>
+    void ForEachCategoryTotal(int user_id, Fn&& fn) const;
+    // 同上，只统计 [first_day, last_day] 内的账单；代价与分类数 × log(天数) 相关
+    template<typename Fn>
+    void ForEachCategoryTotalInDays(int user_id, int64_t first_day, int64_t last_day,
+                                    Fn&& fn) const;
+    // 按分类、按日期升序把 [first_day, last_day] 内有账单的每一天传给 fn，
+    // 签名 void(int category_id, const Category*, int64_t day, const CategoryTotal&)
+    template<typename Fn>
+    void ForEachDailyTotal(int user_id, int64_t first_day, int64_t last_day, Fn&& fn) const;
+    // 某分类 / 全部账单在 [first_day, last_day] 内的汇总
+    CategoryTotal SumCategoryInDays(int user_id, int category_id, int64_t first_day,
+                                    int64_t last_day) const;
+    CategoryTotal SumInDays(int user_id, int64_t first_day, int64_t last_day) const;
+
+    // === 数据版本 ===
+    // 某用户账单的版本号：该用户每次增删改、以及重新从存储加载后都会变大，
+    // 供报表缓存等派生数据判断是否过期
+    uint64_t DataVersion(int user_id) const;
+
     // === 存储操作 ===
     // LoadFromStorage will restore category pointers using the provided CategoryManager
+    // （category_manager 需在 BillManager 使用期间保持有效）。
+    // 若 storage 支持按用户读取，启动时不加载任何账单，用户在 LoadUser 或第一次修改时才加载；
+    // 否则若 storage 提供内存映射快照，则不反序列化账单：未修改过的用户直接从快照读取，
+    // 某用户第一次被修改时才把其账单复制到内存中的增量层。
+    // 若 storage 启用了账单变更日志，加载快照后会重放日志，并把之后的增删改追加到日志
     bool LoadFromStorage(std::shared_ptr<Storage> storage, const class CategoryManager& category_manager);
+    // LoadFromStorage 的两个阶段，供并行初始化使用：
+    // ReadFromStorage 只读取存储、不访问 CategoryManager，可与其他 Manager 的加载并行执行；
+    // FinishLoad 在 CategoryManager 加载完成后重放日志并按用户并行恢复分类指针
+    bool ReadFromStorage(std::shared_ptr<Storage> storage);
+    bool FinishLoad(const class CategoryManager& category_manager);
+    // 只写入自上次加载/保存以来修改过的用户（存储支持按用户保存时），没有修改则不写入
     bool SaveToStorage(std::shared_ptr<Storage> storage) const;
+    bool IsDirty() const { return !dirty_users_.empty(); }
+
+    // === 按用户加载 ===
+    // 按用户加载模式（SetLazyLoading(true) 或 storage 支持 SupportsPerUserLoad）下，
+    // LoadFromStorage 不读取账单。须在 LoadFromStorage 之前设置
+    void SetLazyLoading(bool enabled) { lazy_loading_ = enabled; }
+    // 把某用户的账单读入内存，通常在用户登录时调用；未加载的用户每次查询都会临时读取存储。
+    // 其他模式下直接返回 true
+    bool LoadUser(int user_id);
+    // 释放某用户的账单；该用户有未保存的修改时不释放并返回 false。
+    // 日志模式下修改已在日志中，先 checkpoint 合并进快照再释放
+    bool EvictUser(int user_id);
+    // EvictUser 是否会释放该用户（不修改状态；日志模式下释放时的 checkpoint 仍可能失败）
+    bool CanEvictUser(int user_id) const;
+    bool IsUserLoaded(int user_id) const;
+
+    // === 变更日志 ===
+    // 日志累积多少条后自动写快照并清空日志
+    static constexpr size_t kDefaultCheckpointInterval = 1000;
+    void SetCheckpointInterval(size_t interval);
+    // 立即把当前账单写成快照并清空日志
+    bool Checkpoint();
 
 private:
-    std::map<int, std::vector<Bill>> bills_;   // user_id -> bills
+    // 记录某用户的账单已修改：标记为脏并增大版本号
+    void MarkChanged(int user_id);
+    // 重放一条日志记录（不会再次写日志）
+    bool ApplyLogRecord(const BillLogRecord& record);
+    // 写日志；未启用日志时直接返回 true
+    bool AppendLog(const BillLogRecord& record);
+    void MaybeCheckpoint();
+
+    // 返回某用户的可修改账单；该用户只在快照中或尚未从存储加载时先读入内存。
+    // 用户不存在且 create 为 false、或读取存储失败时返回 nullptr
+    BillColumns* MutableUserBills(int user_id, bool create);
+    // 不在 bills_ 中的用户：从快照或来源存储读取并恢复分类，不常驻
+    std::vector<Bill> LoadUncachedBills(int user_id) const;
+
+    // bill_id -> 在该用户列式存储中的行号，使更新/删除/重复检查为 O(1)。
+    // 某用户第一次增删改时按当前账单建立，之后随修改同步维护
+    using BillSlots = std::unordered_map<int, size_t>;
+    BillSlots& SlotsFor(int user_id, const BillColumns& columns) const;
+
+    // 按 (时间, bill_id) 排序的时间索引。某用户第一次按时间查询时建立，之后随增删改同步维护
+    using TimeKey = std::pair<std::chrono::system_clock::time_point, int>;
+    using TimeIndex = std::vector<TimeKey>;
+    const TimeIndex& TimeIndexFor(int user_id, const BillColumns& columns) const;
+    // category_id -> 该分类账单的时间索引（无分类的账单在 -1 下）。建立和维护方式同时间索引
+    using CategoryIndex = std::unordered_map<int, TimeIndex>;
+    const TimeIndex& CategoryTimeIndex(int user_id, const BillColumns& columns,
+                                       int category_id) const;
+    // ForEachDailyTotal / ForEachCategoryTotalInDays 的共同实现：day_fn 或 category_fn 为 nullptr 时不调用
+    template<typename DayFn, typename CategoryFn>
+    void ForEachDailyTotal(int user_id, int64_t first_day, int64_t last_day, DayFn&& day_fn,
+                           CategoryFn&& category_fn) const;
+    // 某用户的按日汇总。第一次读取时建立（存储中保存的汇总与账单一致时直接使用），
+    // 之后每次增删改只加减该账单
+    const BillRollup& RollupFor(int user_id, const BillColumns& columns) const;
+    // 在已建立的汇总中计入 / 扣除 columns 的第 row 行或 bill
+    void RollupAdd(int user_id, const Bill& bill);
+    void RollupRemove(int user_id, const BillColumns& columns, size_t row);
+    // 不在 bills_ 中的用户：已核对的保存汇总直接展开；否则读取账单核对或重新计算一次，
+    // 结果留在 stored_rollups_ 中并记为已核对
+    BillRollup UncachedRollup(int user_id) const;
+    // 按分类 id 取分类管理器中的分类（找不到时为 nullptr）
+    std::unordered_map<int, std::shared_ptr<const Category>> ResolveCategories(
+        int user_id, const std::vector<int>& category_ids) const;
+    // 按用户加载时读取该用户保存的汇总到 stored_rollups_（已有时不读取）
+    void LoadStoredRollup(int user_id) const;
+    // 把已建立的汇总与尚未使用的已保存汇总写入 storage（存储支持且有变化或 force 时）；
+    // 存储支持增量保存且非 force 时只写 dirty_rollups_ 中的用户
+    bool WriteRollups(const std::shared_ptr<Storage>& storage, bool force) const;
+    // 在已建立的时间索引和分类索引中加入/移除一个账单
+    void IndexRow(int user_id, const TimeKey& key, int category_id);
+    // 批量加入 (时间键, 分类 id)：新键排序后与已有索引归并，而不是逐个插入
+    void IndexRows(int user_id, std::vector<std::pair<TimeKey, int>> rows);
+    static void MergeTimeKeys(TimeIndex& index, TimeIndex keys);
+    void UnindexRow(int user_id, const TimeKey& key, int category_id);
+    static void InsertTimeKey(TimeIndex& index, const TimeKey& key);
+    static void EraseTimeKey(TimeIndex& index, const TimeKey& key);
+    // index 中时间在 [start, end] 内的区间
+    static std::pair<TimeIndex::const_iterator, TimeIndex::const_iterator> KeysInTimeRange(
+        const TimeIndex& index, const std::chrono::system_clock::time_point& start,
+        const std::chrono::system_clock::time_point& end);
+    // 按 index 中时间在 [start, end] 内的顺序遍历 columns 的行，fn 签名 void(size_t row)
+    template<typename Fn>
+    void ForEachRowInTimeRange(int user_id, const BillColumns& columns, const TimeIndex& index,
+                               const std::chrono::system_clock::time_point& start,
+                               const std::chrono::system_clock::time_point& end, Fn&& fn) const;
+    // columns 为 bills_ 中该用户的账单，返回 index 中时间在 [start, end] 内的行号，按时间升序
+    std::vector<size_t> RowsInTimeRange(int user_id, const BillColumns& columns,
+                                        const TimeIndex& index,
+                                        const std::chrono::system_clock::time_point& start,
+                                        const std::chrono::system_clock::time_point& end) const;
+    // 查询计划：选定的访问路径及其所需的分类 id / 时间范围
+    struct QueryPlan {
+        QueryAccessPath path = QueryAccessPath::kScan;
+        std::vector<int> category_ids;  // 条件中的分类全部解析为 id 时有效（已排序）
+        bool category_ids_resolved = false;
+    };
+    QueryPlan MakeQueryPlan(int user_id, const BillColumns& columns,
+                            const QueryCriteria& criteria) const;
+    // columns 为 bills_ 中该用户的账单：按计划取候选行、检查全部条件、排序并截断，返回行号
+    std::vector<size_t> SelectRows(int user_id, const BillColumns& columns,
+                                   const QueryCriteria& criteria) const;
+    // 调用方传入的分类指针可能是副本，写入后换成 CategoryManager 中的共享对象（存在时）
+    void ShareCategory(int user_id, BillColumns& columns, int category_id) const;
+    void RestoreCategories(int user_id, std::vector<Bill>& bills) const;
+    void RestoreCategories(int user_id, BillColumns& columns) const;
+    // 合并快照与增量层后整体写入 storage
+    bool SaveAllBills(Storage& storage) const;
+    // storage 为已同步的存储时只写入 dirty_users_ 和 unmerged_users_（存储支持时），否则整体写入
+    bool WriteBills(const std::shared_ptr<Storage>& storage) const;
+
+    std::map<int, BillColumns> bills_;         // user_id -> 列式账单（使用快照时仅包含修改过的用户）
     std::map<int, int> next_bill_id_;          // user_id -> next id
+    mutable std::unordered_map<int, BillSlots> bill_slots_;  // user_id -> 账单下标索引（只含 bills_ 中的用户）
+    mutable std::unordered_map<int, TimeIndex> time_index_;  // user_id -> 时间索引（只含 bills_ 中的用户）
+    mutable std::unordered_map<int, CategoryIndex> category_index_;  // user_id -> 分类索引（同上）
+    mutable std::unordered_map<int, BillRollup> rollups_;  // user_id -> 按日汇总（同上）
+    mutable std::map<int, BillRollupSnapshot> stored_rollups_;  // 从存储读出或卸载时留下、尚未使用的汇总
+    mutable std::set<int> verified_rollups_;  // stored_rollups_ 中已确认与该用户存储中账单一致的用户
+    mutable std::set<int> dirty_rollups_;  // 汇总自上次读取 / 保存后有变化的用户
+
+    std::shared_ptr<const MappedBillSnapshot> base_;  // 只读快照，未使用时为空
+    std::shared_ptr<Storage> lazy_source_;            // 按用户加载账单的存储，未使用时为空
+    bool lazy_loading_ = false;
+    const class CategoryManager* category_manager_ = nullptr;
+
+    // ===== 版本号 =====
+    std::unordered_map<int, uint64_t> data_versions_;  // user_id -> 最近一次修改时的版本号
+    uint64_t version_counter_ = 0;
+    uint64_t base_version_ = 0;  // 未修改过的用户的版本号（最近一次加载时的值）
+
+    // ===== 脏数据跟踪 =====
+    mutable std::shared_ptr<Storage> synced_storage_;  // 除 dirty_users_ 外与内存数据一致的存储
+    mutable std::set<int> dirty_users_;
+    mutable std::set<int> unmerged_users_;  // 日志模式下修改已写入并同步到日志、尚未合并进快照的用户
+
+    std::vector<BillLogRecord> pending_replay_;  // ReadFromStorage 读出、等待 FinishLoad 重放的日志
+    std::shared_ptr<Storage> bill_log_;        // 启用日志模式时指向 storage，否则为空
+    size_t pending_log_records_ = 0;           // 上次快照之后写入的日志条数
+    size_t checkpoint_interval_ = kDefaultCheckpointInterval;
 };
 
+// ========================== 遍历接口实现 ==========================
+template<typename Fn>
+void BillManager::ForEachBill(int user_id, Fn&& fn) const {
+    auto it = bills_.find(user_id);
+    if (it != bills_.end()) {
+        const BillColumns& columns = it->second;
+        for (size_t row = 0; row < columns.Size(); ++row) fn(columns.View(row));
+        return;
+    }
+    for (const auto& bill : LoadUncachedBills(user_id)) fn(BillView::FromBill(bill));
+}
+
+template<typename Fn>
+void BillManager::ForEachBillInTimeRange(int user_id,
+                                         const std::chrono::system_clock::time_point& start,
+                                         const std::chrono::system_clock::time_point& end,
+                                         Fn&& fn) const {
+    auto it = bills_.find(user_id);
+    if (it != bills_.end()) {
+        const BillColumns& columns = it->second;
+        ForEachRowInTimeRange(user_id, columns, TimeIndexFor(user_id, columns), start, end,
+                              [&](size_t row) { fn(columns.View(row)); });
+        return;
+    }
+    for (const auto& bill : GetBillsInTimeRange(user_id, start, end)) fn(BillView::FromBill(bill));
+}
+
+template<typename Fn>
+void BillManager::ForEachBillInCategory(int user_id, int category_id, Fn&& fn) const {
+    ForEachBillInCategory(user_id, category_id, std::chrono::system_clock::time_point::min(),
+                          std::chrono::system_clock::time_point::max(), std::forward<Fn>(fn));
+}
+
+template<typename Fn>
+void BillManager::ForEachBillInCategory(int user_id, int category_id,
+                                        const std::chrono::system_clock::time_point& start,
+                                        const std::chrono::system_clock::time_point& end,
+                                        Fn&& fn) const {
+    auto it = bills_.find(user_id);
+    if (it != bills_.end()) {
+        const BillColumns& columns = it->second;
+        ForEachRowInTimeRange(user_id, columns, CategoryTimeIndex(user_id, columns, category_id),
+                              start, end, [&](size_t row) { fn(columns.View(row)); });
+        return;
+    }
+    for (const auto& bill : GetBillsByCategoryInTimeRange(user_id, category_id, start, end)) {
+        fn(BillView::FromBill(bill));
+    }
+}
+
+template<typename Fn>
+void BillManager::ForEachBillMatching(int user_id, const QueryCriteria& criteria, Fn&& fn) const {
+    auto it = bills_.find(user_id);
+    if (it != bills_.end()) {
+        const BillColumns& columns = it->second;
+        for (size_t row : SelectRows(user_id, columns, criteria)) fn(columns.View(row));
+        return;
+    }
+    for (const auto& bill : QueryBillsByCriteria(user_id, criteria)) fn(BillView::FromBill(bill));
+}
+
+template<typename Fn>
+void BillManager::ForEachCategoryTotal(int user_id, Fn&& fn) const {
+    ForEachCategoryTotalInDays(user_id, BillRollup::kFirstDay, BillRollup::kLastDay,
+                               std::forward<Fn>(fn));
+}
+
+template<typename Fn>
+void BillManager::ForEachCategoryTotalInDays(int user_id, int64_t first_day, int64_t last_day,
+                                             Fn&& fn) const {
+    ForEachDailyTotal(user_id, first_day, last_day, nullptr, std::forward<Fn>(fn));
+}
+
+template<typename Fn>
+void BillManager::ForEachDailyTotal(int user_id, int64_t first_day, int64_t last_day,
+                                    Fn&& fn) const {
+    ForEachDailyTotal(user_id, first_day, last_day, std::forward<Fn>(fn), nullptr);
+}
+
+template<typename DayFn, typename CategoryFn>
+void BillManager::ForEachDailyTotal(int user_id, int64_t first_day, int64_t last_day,
+                                    DayFn&& day_fn, CategoryFn&& category_fn) const {
+    // 常驻用户的分类指针取自列式存储的分类表；其余用户按分类 id 从分类管理器解析
+    auto it = bills_.find(user_id);
+    const BillColumns* columns = it != bills_.end() ? &it->second : nullptr;
+    BillRollup uncached;
+    std::unordered_map<int, std::shared_ptr<const Category>> uncached_categories;
+    if (!columns) {
+        uncached = UncachedRollup(user_id);
+        uncached_categories = ResolveCategories(user_id, uncached.CategoryIds());
+    }
+    const BillRollup& rollup = columns ? RollupFor(user_id, *columns) : uncached;
+
+    for (int category_id : rollup.CategoryIds()) {
+        const Category* category = nullptr;
+        if (columns) {
+            category = columns->FindCategory(category_id);
+        } else {
+            auto found = uncached_categories.find(category_id);
+            if (found != uncached_categories.end()) category = found->second.get();
+        }
+        if constexpr (!std::is_same_v<std::decay_t<DayFn>, std::nullptr_t>) {
+            rollup.ForEachDay(category_id, first_day, last_day,
+                              [&](int64_t day, const CategoryTotal& total) {
+                                  day_fn(category_id, category, day, total);
+                              });
+        }
+        if constexpr (!std::is_same_v<std::decay_t<CategoryFn>, std::nullptr_t>) {
+            const CategoryTotal total = rollup.SumCategory(category_id, first_day, last_day);
+            if (total.count > 0) category_fn(category_id, category, total);
+        }
+    }
+}
+
+template<typename Fn>
+void BillManager::ForEachRowInTimeRange(int user_id, const BillColumns& columns,
+                                        const TimeIndex& index,
+                                        const std::chrono::system_clock::time_point& start,
+                                        const std::chrono::system_clock::time_point& end,
+                                        Fn&& fn) const {
+    const BillSlots& slots = SlotsFor(user_id, columns);
+    auto range = KeysInTimeRange(index, start, end);
+    for (auto key = range.first; key != range.second; ++key) fn(slots.at(key->second));
+}
+
 }  // namespace accounting
 
 #endif  // ACCOUNTING_MANAGERS_BILL_MANAGER_H_
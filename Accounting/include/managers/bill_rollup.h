@@ -0,0 +1,120 @@
+#ifndef ACCOUNTING_MANAGERS_BILL_ROLLUP_H_
+#define ACCOUNTING_MANAGERS_BILL_ROLLUP_H_
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+#include "managers/bill_columns.h"
+#include "models/money.h"
+#include "storage/storage.h"
+
+namespace accounting {
+
+/**
+ * @brief 单个用户账单的按日汇总：(分类 id, 本地日期) -> 金额合计与账单数
+ *
+ * 每个分类按日期升序保存有账单的日子，并维护前缀和，因此任意日期区间的合计只需两次二分，
+ * 代价与区间内的天数、账单数都无关；按日遍历的代价与区间内有账单的天数成正比。
+ * 增删一个账单只修改一个 (分类, 日期) 项，前缀和从该项起失效，下次查询时再补算
+ * （新账单通常在最后一天，补算只涉及末尾）。
+ * 日期为本地日历日，1970-01-01 起的天数（见 time_utils::LocalDayNumber）。
+ */
+class BillRollup {
+public:
+    using TimePoint = std::chrono::system_clock::time_point;
+
+    // 金额合计与账单数
+    struct Total {
+        Money total;
+        size_t count = 0;
+    };
+
+    static constexpr int64_t kFirstDay = std::numeric_limits<int64_t>::min();
+    static constexpr int64_t kLastDay = std::numeric_limits<int64_t>::max();
+
+    BillRollup() = default;
+    // 由列式账单逐行计算
+    explicit BillRollup(const BillColumns& columns);
+    explicit BillRollup(const std::vector<Bill>& bills);
+
+    // === 持久化 ===
+    BillRollupSnapshot ToSnapshot() const;
+    // snapshot 与 columns 中的账单一致（条数、金额合计、校验和都相同），且写入时的本地日期划分
+    // 与当前时区相同时返回 true 并写入 out
+    static bool FromSnapshot(const BillRollupSnapshot& snapshot, const BillColumns& columns,
+                             BillRollup& out);
+    // 不与账单核对，只检查各项之和与 bill_count 一致；供调用方已确认与账单一致的快照使用，
+    // 代价与快照项数成正比
+    static bool FromVerifiedSnapshot(const BillRollupSnapshot& snapshot, BillRollup& out);
+
+    // === 修改 ===
+    void Add(int bill_id, const TimePoint& time, int category_id, int64_t amount_cents);
+    void Remove(int bill_id, const TimePoint& time, int category_id, int64_t amount_cents);
+
+    // === 查询 ===
+    size_t BillCount() const { return static_cast<size_t>(bill_count_); }
+    // 某分类在本地日期 [first_day, last_day] 内的汇总
+    Total SumCategory(int category_id, int64_t first_day = kFirstDay,
+                      int64_t last_day = kLastDay) const;
+    // 全部分类在 [first_day, last_day] 内的汇总
+    Total SumAll(int64_t first_day = kFirstDay, int64_t last_day = kLastDay) const;
+    // 出现过的分类 id（无分类的账单在 -1 下），顺序不固定
+    std::vector<int> CategoryIds() const;
+    // 按日期升序把某分类 [first_day, last_day] 内的 (日期, 汇总) 传给 fn，签名 void(int64_t, const Total&)
+    template<typename Fn>
+    void ForEachDay(int category_id, int64_t first_day, int64_t last_day, Fn&& fn) const;
+
+    // 一个账单在校验和中的分量；校验和为各账单分量之和，与顺序无关、可按差值维护
+    static uint64_t RowChecksum(int bill_id, const TimePoint& time, int category_id,
+                                int64_t amount_cents);
+    // entries 中各日期在当前时区下的起止时刻（本地 0 点）的指纹。时区或夏令时规则变化后，
+    // 只要某个日期的边界移动，指纹就不同；边界都不变时账单所属的本地日期也不变
+    static uint64_t DayFingerprint(const std::vector<BillRollupEntry>& entries);
+
+private:
+    struct Series {
+        std::vector<int64_t> days;  // 升序，只含有账单的日子
+        std::vector<int64_t> cents;
+        std::vector<int64_t> counts;
+        int64_t total_cents = 0;
+        int64_t total_count = 0;
+        // prefix_cents[i] 为前 i 天之和；前 prefix_valid + 1 项有效
+        mutable std::vector<int64_t> prefix_cents;
+        mutable std::vector<int64_t> prefix_counts;
+        mutable size_t prefix_valid = 0;
+    };
+
+    void AddDay(int category_id, int64_t day, int64_t cents, int64_t count);
+    static void EnsurePrefix(const Series& series);
+    static Total SumSeries(const Series& series, int64_t first_day, int64_t last_day);
+
+    std::unordered_map<int, Series> series_;  // category_id -> 按日汇总
+    int64_t bill_count_ = 0;
+    int64_t total_cents_ = 0;
+    uint64_t checksum_ = 0;
+};
+
+template<typename Fn>
+void BillRollup::ForEachDay(int category_id, int64_t first_day, int64_t last_day,
+                            Fn&& fn) const {
+    auto it = series_.find(category_id);
+    if (it == series_.end()) return;
+    const Series& series = it->second;
+    auto begin = std::lower_bound(series.days.begin(), series.days.end(), first_day);
+    auto end = std::upper_bound(begin, series.days.end(), last_day);
+    for (auto day = begin; day != end; ++day) {
+        const size_t i = static_cast<size_t>(day - series.days.begin());
+        Total total;
+        total.total = Money::FromCents(series.cents[i]);
+        total.count = static_cast<size_t>(series.counts[i]);
+        fn(*day, total);
+    }
+}
+
+}  // namespace accounting
+
+#endif  // ACCOUNTING_MANAGERS_BILL_ROLLUP_H_
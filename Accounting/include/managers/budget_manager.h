@@ -2,6 +2,7 @@
 #define ACCOUNTING_MANAGERS_BUDGET_MANAGER_H_
 
 #include <map>
+#include <set>
 #include <memory>
 #include "models/budget.h"
 #include "models/bill.h"
@@ -23,14 +24,38 @@ public:
     // 检查账单是否超过预算
     // 返回 true 表示在预算范围内，false 表示超出预算
     bool CheckLimit(int user_id, const Bill& bill) const;
+    // 同上，直接对给定预算检查（批量添加时只取一次预算）
+    static bool CheckLimit(const Budget& budget, const Bill& bill);
 
     // 存储操作
     bool LoadFromStorage(std::shared_ptr<Storage> storage);
+    // 目标是上次加载/保存的存储时只写入修改过的用户（存储支持时）或跳过未修改的数据
     bool SaveToStorage(std::shared_ptr<Storage> storage) const;
+    bool IsDirty() const { return !dirty_users_.empty(); }
+
+    // ===== 按用户加载（懒加载模式） =====
+    // 启用后 LoadFromStorage 不读取预算，LoadUser 时才读取；未加载用户的查询临时读取存储。
+    // 须在 LoadFromStorage 之前设置
+    void SetLazyLoading(bool enabled) { lazy_loading_ = enabled; }
+    bool LoadUser(int user_id);
+    // 释放某用户的预算；该用户有未保存的修改时不释放并返回 false
+    bool EvictUser(int user_id);
+    // EvictUser 是否会释放该用户（不修改状态）
+    bool CanEvictUser(int user_id) const;
+    bool IsUserLoaded(int user_id) const;
 
 private:
     // user_id -> Budget (使用 map 与 Storage API 返回类型一致)
     std::map<int, Budget> budgets_;
+
+    // ===== 懒加载 =====
+    bool lazy_loading_ = false;
+    std::shared_ptr<Storage> lazy_source_;
+    std::set<int> loaded_users_;  // 已加载的用户（包括没有预算的用户）
+
+    // ===== 脏数据跟踪 =====
+    mutable std::shared_ptr<Storage> synced_storage_;  // 除 dirty_users_ 外与内存数据一致的存储
+    mutable std::set<int> dirty_users_;
 };
 
 }  // namespace accounting
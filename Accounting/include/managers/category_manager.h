@@ -2,6 +2,7 @@
 #define ACCOUNTING_MANAGER_CATEGORY_MANAGER_H_
 
 #include <map>
+#include <set>
 #include <vector>
 #include <memory>
 #include <string>
@@ -13,6 +14,10 @@ namespace accounting {
 // CategoryManager 负责管理每个用户的分类集合。
 class CategoryManager {
 public:
+    // 每个分类只有一个对象，账单通过 shared_ptr<const Category> 共享；
+    // UpdateCategory 在原对象上修改，删除后仍被账单引用的对象保持有效
+    using CategoryList = std::vector<std::shared_ptr<Category>>;
+
     CategoryManager() = default;
     explicit CategoryManager(std::shared_ptr<class Storage> storage);
 
@@ -29,10 +34,25 @@ public:
     std::vector<Category> GetCategoriesForUser(const User& user) const;
     const Category* GetCategoryById(const User& user, int category_id) const;
     const Category* GetCategoryByName(const User& user, const std::string& name) const;
+    // 与 GetCategoryById 相同，但返回共享的分类对象，供账单引用；用户未加载或分类不存在时返回 nullptr
+    std::shared_ptr<const Category> GetSharedCategory(const User& user, int category_id) const;
 
     // 持久化接口（可选）
     bool LoadFromStorage();
+    // 只写入修改过的用户（存储支持时），没有修改则不写入
     bool SaveToStorage() const;
+    bool IsDirty() const { return !dirty_users_.empty(); }
+
+    // ===== 按用户加载（懒加载模式） =====
+    // 启用后 LoadFromStorage 不读取分类，LoadUser 或第一次修改时才读取该用户的分类；
+    // 未加载用户的 GetCategoryById / GetCategoryByName 返回 nullptr。须在 LoadFromStorage 之前设置
+    void SetLazyLoading(bool enabled) { lazy_loading_ = enabled; }
+    bool LoadUser(int user_id);
+    // 释放某用户的分类；该用户有未保存的修改时不释放并返回 false
+    bool EvictUser(int user_id);
+    // EvictUser 是否会释放该用户（不修改状态）
+    bool CanEvictUser(int user_id) const;
+    bool IsUserLoaded(int user_id) const;
 
     // 添加一个测试用的公开接口，临时用于测试
     bool TestIsDuplicateCategoryNameForTest(const User& user, const std::string& name) const {
@@ -44,8 +64,14 @@ private:
     bool IsDuplicateCategoryName(const User& user, const std::string& name) const;
 
     // 映射结构：一个用户对应若干分类
-    std::map<int, std::vector<Category>> categories_by_user_;
+    std::map<int, CategoryList> categories_by_user_;
     std::shared_ptr<Storage> storage_;  // 可选外部存储层
+
+    bool lazy_loading_ = false;  // true 时 categories_by_user_ 只包含已加载的用户
+
+    // ===== 脏数据跟踪 =====
+    mutable bool synced_ = false;        // storage_ 中除 dirty_users_ 外与内存一致
+    mutable std::set<int> dirty_users_;
 };
 
 }  // namespace accounting
@@ -1,6 +1,9 @@
 #ifndef ACCOUNTING_MANAGERS_REPORT_MANAGER_H_
 #define ACCOUNTING_MANAGERS_REPORT_MANAGER_H_
 
+#include <cstddef>
+#include <cstdint>
+#include <list>
 #include <unordered_map>
 #include <vector>
 #include <string>
@@ -13,11 +16,19 @@
 
 namespace accounting {
 
+// 报表缓存的容量；两项限制同时生效
+struct ReportCacheOptions {
+    size_t max_entries = 64;              // 最多缓存的报表数，0 表示不缓存
+    size_t max_bytes = 4 * 1024 * 1024;   // 按报表内容估算的内存上限（字节）
+};
+
 class ReportManager {
 public:
-    explicit ReportManager(BillManager* bill_manager);
+    explicit ReportManager(BillManager* bill_manager,
+                           const ReportCacheOptions& cache_options = ReportCacheOptions());
 
-    // 为指定用户生成报表
+    // 为指定用户生成报表。结果按 (用户, 条件, 周期, 图表类型) 缓存（LRU），
+    // 该用户的账单版本号（BillManager::DataVersion）未变时直接返回缓存的报表
     Report GenerateReport(int user_id,
                           const QueryCriteria& criteria,
                           Period period,
@@ -26,15 +37,41 @@ public:
     // 获取最近一次生成的报表（若存在）
     std::optional<Report> GetLastReport(int user_id) const;
 
-    // 获取某用户的所有历史报表
-    const std::vector<Report>& GetReportsByUser(int user_id) const;
-
-    // 清空某用户的报表缓存
+    // 清空某用户的报表缓存（账单以外影响报表的数据变化时调用，如分类改名）
     void ClearReports(int user_id);
 
+    // 缓存的报表数与估算占用的字节数
+    size_t CachedReportCount() const { return lru_.size(); }
+    size_t CachedReportBytes() const { return cache_bytes_; }
+
 private:
+    struct CacheEntry {
+        std::string key;
+        int user_id;
+        uint64_t version;  // 生成时该用户的账单版本号
+        Report report;
+        size_t bytes;
+    };
+    using CacheList = std::list<CacheEntry>;
+
+    Report BuildReport(int user_id, const QueryCriteria& criteria, Period period,
+                       ChartType chart_type) const;
+    // criteria 除排序外只限定了整天的本地日期范围（或没有任何条件）时返回 true，
+    // 并给出日期区间 [first_day, last_day]（不限时为 BillRollup::kFirstDay / kLastDay）。
+    // 终点不是当天最后一刻、但该用户在终点之后当天没有账单时也算整天
+    bool WholeDayRange(int user_id, const QueryCriteria& criteria,
+                       int64_t& first_day, int64_t& last_day) const;
+    static size_t EstimateBytes(const Report& report);
+    void EraseEntry(CacheList::iterator entry);
+    // 按 LRU 淘汰直到满足容量限制
+    void Shrink();
+
     BillManager* bill_manager_;  // 指向账单管理器，解耦依赖
-    std::unordered_map<int, std::vector<Report>> reports_; // user_id -> reports
+    ReportCacheOptions cache_options_;
+    CacheList lru_;  // 最近使用的在前
+    std::unordered_map<std::string, CacheList::iterator> cache_index_;  // 缓存键 -> lru_ 中的项
+    size_t cache_bytes_ = 0;
+    std::unordered_map<int, Report> last_reports_;  // user_id -> 最近一次生成的报表
 };
 
 }  // namespace accounting
@@ -29,7 +29,10 @@ public:
 
     // ==== 存储操作 ====
     bool LoadFromStorage(std::shared_ptr<Storage> storage);
+    // 未修改且目标就是上次加载/保存的存储时不写入
     bool SaveToStorage(std::shared_ptr<Storage> storage) const;
+    // 自上次加载/保存以来是否有修改
+    bool IsDirty() const { return dirty_; }
 
 private:
     // 用户名 -> User
@@ -39,6 +42,10 @@ private:
 
     // 为新用户生成唯一 ID
     int GenerateNextUserId() const;
+
+    // ===== 脏数据跟踪 =====
+    mutable std::shared_ptr<Storage> synced_storage_;  // 与内存数据一致的存储
+    mutable bool dirty_ = false;
 };
 
 }  // namespace accounting
@@ -2,6 +2,7 @@
 #define ACCOUNTING_MODELS_BILL_H_
 
 #include "models/category.h"
+#include "models/money.h"
 #include <chrono>
 #include <memory>
 #include <string>
@@ -19,7 +20,7 @@ public:
 
     // 带参构造
     Bill(int bill_id, double amount,
-        std::shared_ptr<Category> category,
+        std::shared_ptr<const Category> category,
         const std::chrono::system_clock::time_point& time,
         const std::string& content);
 
@@ -31,11 +32,14 @@ public:
     int GetBillId() const;
     void SetBillId(int id);
 
+    // 金额以分为单位存储；double 接口按四舍五入到分换算
     double GetAmount() const;
     void SetAmount(double amount);
+    Money GetMoney() const;
+    void SetMoney(Money amount);
 
-    std::shared_ptr<Category> GetCategory() const;
-    void SetCategory(const std::shared_ptr<Category>& category);
+    const std::shared_ptr<const Category>& GetCategory() const;
+    void SetCategory(const std::shared_ptr<const Category>& category);
     // category id helper (used during serialization / loading)
     int GetCategoryId() const;
     void SetCategoryId(int category_id);
@@ -55,14 +59,17 @@ public:
 
     private:
     int bill_id_;
-    double amount_;
-    std::shared_ptr<Category> category_;
+    Money amount_;
+    std::shared_ptr<const Category> category_;  // 通常与同分类的其他账单共享 CategoryManager 中的对象
     // persisted category id loaded from JSON; used to restore shared_ptr later
     int category_id_;
     std::chrono::system_clock::time_point time_;
     std::string content_;
 };
 
+// 账单时间与持久化字符串 "YYYY-MM-DD HH:MM:SS"（本地时间）之间的转换
+std::string BillTimeToString(const std::chrono::system_clock::time_point& tp);
+std::chrono::system_clock::time_point BillTimeFromString(const std::string& s);
 
 }  // namespace accounting
 
@@ -1,6 +1,7 @@
 #ifndef ACCOUNTING_MODELS_BILL_DATA_H_
 #define ACCOUNTING_MODELS_BILL_DATA_H_
 
+#include "models/money.h"
 #include <chrono>
 #include <string>
 
@@ -16,6 +17,10 @@ public:
              const std::string& category_type,
              const std::chrono::system_clock::time_point& time,
              const std::string& content);
+    BillData(Money amount, const std::string& category_name,
+             const std::string& category_type,
+             const std::chrono::system_clock::time_point& time,
+             const std::string& content);
 
     // 拷贝与赋值默认即可
     BillData(const BillData&) = default;
@@ -24,6 +29,8 @@ public:
     // Getter / Setter
     double GetAmount() const;
     void SetAmount(double amount);
+    Money GetMoney() const;
+    void SetMoney(Money amount);
 
     const std::string& GetCategoryName() const;
     void SetCategoryName(const std::string& category_name);
@@ -41,7 +48,7 @@ public:
     std::string ToString() const;
 
 private:
-    double amount_;
+    Money amount_;
     std::string category_name_;
     std::string category_type_;  // 分类类型 ("expense", "income", 等)
     std::chrono::system_clock::time_point time_;
@@ -2,6 +2,7 @@
 #define ACCOUNTING_MODELS_BUDGET_H_
 
 #include "models/category.h"
+#include "models/money.h"
 #include <unordered_map>
 #include <memory>
 #include <nlohmann/json.hpp>
@@ -26,9 +27,13 @@ public:
     double GetTotalLimit() const;
     void SetTotalLimit(double limit);
 
-    const std::unordered_map<int, double>& GetCategoryLimits() const;
+    // 额度按分存储，返回换算后的副本
+    std::unordered_map<int, double> GetCategoryLimits() const;
     void SetCategoryLimit(int category_id, double limit);
     double GetCategoryLimit(int category_id) const;
+    Money GetTotalLimitMoney() const;
+    Money GetCategoryLimitMoney(int category_id) const;
+    bool HasCategoryLimit(int category_id) const;
 
     // 调试输出
     std::string ToString() const;
@@ -38,8 +43,8 @@ public:
     friend void from_json(const json& j, Budget& b);
 
 private:
-    double total_limit_;
-    std::unordered_map<int, double> category_limits_;
+    Money total_limit_;
+    std::unordered_map<int, Money> category_limits_;
 };
 
 }  // namespace accounting
@@ -0,0 +1,62 @@
+#ifndef ACCOUNTING_MODELS_MONEY_H_
+#define ACCOUNTING_MODELS_MONEY_H_
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <nlohmann/json.hpp>
+
+namespace accounting {
+
+using nlohmann::json;
+
+/**
+ * @brief 以最小货币单位（分）存储的定点金额
+ *
+ * 内部为 int64 分，加减法精确且满足结合律，求和结果与累加顺序无关。
+ * 与 double 互转时四舍五入到分；JSON 中仍写成十进制数（如 12.5），与原有文件格式兼容。
+ */
+class Money {
+public:
+    static constexpr int64_t kMinorPerMajor = 100;
+
+    constexpr Money() = default;
+    static constexpr Money FromCents(int64_t cents) { return Money(cents); }
+    // 超出 int64 分的范围时取最接近的可表示值，NaN 取 0（由调用方的金额校验拒绝）
+    static Money FromDouble(double amount);
+    // 同上，但 NaN、无穷或超出范围时返回 false，不写入 out
+    static bool TryFromDouble(double amount, Money& out);
+    // 解析十进制字符串（"12.34"、"-0.5"、"7"），超过两位的小数四舍五入；格式错误返回 false
+    static bool Parse(std::string_view text, Money& out);
+
+    constexpr int64_t Cents() const { return cents_; }
+    double ToDouble() const { return static_cast<double>(cents_) / kMinorPerMajor; }
+    // 固定两位小数，如 "12.50"、"-0.05"
+    std::string ToString() const;
+
+    constexpr Money operator-() const { return Money(-cents_); }
+    constexpr Money operator+(Money other) const { return Money(cents_ + other.cents_); }
+    constexpr Money operator-(Money other) const { return Money(cents_ - other.cents_); }
+    Money& operator+=(Money other) { cents_ += other.cents_; return *this; }
+    Money& operator-=(Money other) { cents_ -= other.cents_; return *this; }
+
+    constexpr bool operator==(Money other) const { return cents_ == other.cents_; }
+    constexpr bool operator!=(Money other) const { return cents_ != other.cents_; }
+    constexpr bool operator<(Money other) const { return cents_ < other.cents_; }
+    constexpr bool operator<=(Money other) const { return cents_ <= other.cents_; }
+    constexpr bool operator>(Money other) const { return cents_ > other.cents_; }
+    constexpr bool operator>=(Money other) const { return cents_ >= other.cents_; }
+
+private:
+    explicit constexpr Money(int64_t cents) : cents_(cents) {}
+
+    int64_t cents_ = 0;
+};
+
+// JSON 中写成十进制数；读取整数或浮点数并四舍五入到分，超出范围时抛出 std::out_of_range
+void to_json(json& j, const Money& m);
+void from_json(const json& j, Money& m);
+
+}  // namespace accounting
+
+#endif  // ACCOUNTING_MODELS_MONEY_H_
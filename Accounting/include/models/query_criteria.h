@@ -2,12 +2,102 @@
 #define ACCOUNTING_MODELS_QUERY_CRITERIA_H_
 
 #include <chrono>
+#include <cstddef>
 #include <string>
+#include <string_view>
+#include <vector>
+
+#include "models/money.h"
 
 namespace accounting {
 
+/**
+ * @brief 条件求值时使用的账单字段
+ *
+ * 只引用调用方持有的数据，不复制字符串；没有分类时分类名称和类型为空、分类 id 为 -1
+ */
+struct QueryRow {
+    int bill_id = 0;
+    Money amount;
+    std::chrono::system_clock::time_point time;
+    int category_id = -1;
+    std::string_view category_name;
+    std::string_view category_type;
+    std::string_view content;
+};
+
+/**
+ * @brief 账单条件表达式树
+ *
+ * 叶子为单个字段上的条件，内部节点为与 / 或 / 非。默认构造的表达式匹配所有账单。
+ */
+class QueryPredicate {
+public:
+    enum class Op {
+        kAll,              // 恒为真
+        kAnd,
+        kOr,
+        kNot,
+        kTimeRange,        // 时间在 [start, end] 内
+        kAmountRange,      // 金额在 [min, max] 内
+        kCategoryIds,      // 分类 id 属于给定集合
+        kCategoryNames,    // 分类名称属于给定集合
+        kCategoryType,     // 分类类型等于给定值（"income" / "expense"）
+        kContentContains,  // 备注包含给定子串
+        kBillIds,          // 账单 id 属于给定集合
+    };
+
+    QueryPredicate();
+
+    static QueryPredicate And(std::vector<QueryPredicate> children);
+    static QueryPredicate Or(std::vector<QueryPredicate> children);
+    static QueryPredicate Not(QueryPredicate child);
+    static QueryPredicate TimeRange(const std::chrono::system_clock::time_point& start,
+                                    const std::chrono::system_clock::time_point& end);
+    static QueryPredicate AmountRange(Money min, Money max);
+    static QueryPredicate CategoryIds(std::vector<int> category_ids);
+    static QueryPredicate CategoryNames(std::vector<std::string> category_names);
+    static QueryPredicate CategoryType(const std::string& category_type);
+    static QueryPredicate ContentContains(const std::string& text);
+    static QueryPredicate BillIds(std::vector<int> bill_ids);
+
+    Op GetOp() const { return op_; }
+    const std::vector<QueryPredicate>& GetChildren() const { return children_; }
+    bool IsAll() const { return op_ == Op::kAll; }
+
+    bool Matches(const QueryRow& row) const;
+
+    // 调试输出
+    std::string ToString() const;
+    // 精确的文本表示（时间精确到时钟单位，字符串带长度前缀），相同条件得到相同结果，可作缓存键
+    std::string CacheKey() const;
+
+private:
+    explicit QueryPredicate(Op op) : op_(op) {}
+    void AppendCacheKey(std::string& out) const;
+
+    Op op_;
+    std::vector<QueryPredicate> children_;
+    std::chrono::system_clock::time_point start_;
+    std::chrono::system_clock::time_point end_;
+    Money min_amount_;
+    Money max_amount_;
+    std::vector<int> ids_;             // 分类 id 或账单 id，已排序
+    std::vector<std::string> names_;   // 分类名称
+    std::string text_;                 // 分类类型或备注子串
+};
+
+/**
+ * @brief 账单查询条件
+ *
+ * 各项条件之间为“与”关系；多个分类名称 / 分类 id 之间为“或”关系。
+ * 更复杂的组合通过 SetWhere 附加一棵 QueryPredicate。
+ * 结果按排序字段排序（同值按账单 id 升序），limit 为 0 表示不限制条数。
+ */
 class QueryCriteria {
 public:
+    enum class SortField { kTime, kAmount };
+
     // 默认构造
     QueryCriteria();
 
@@ -27,22 +117,78 @@ public:
     std::chrono::system_clock::time_point GetEndDate() const;
     void SetEndDate(const std::chrono::system_clock::time_point& end_date);
 
+    // 单个分类名称（兼容旧接口）：Get 返回第一个名称，Set 替换全部名称
     const std::string& GetCategoryName() const;
     void SetCategoryName(const std::string& category_name);
 
+    // 多个分类：名称或 id 命中任意一个即可
+    const std::vector<std::string>& GetCategoryNames() const { return category_names_; }
+    void AddCategoryName(const std::string& category_name);
+    const std::vector<int>& GetCategoryIds() const { return category_ids_; }
+    void AddCategoryId(int category_id);
+
+    // 金额范围 [min, max]（按分比较）
+    Money GetMinAmount() const { return min_amount_; }
+    Money GetMaxAmount() const { return max_amount_; }
+    void SetAmountRange(Money min_amount, Money max_amount);
+
+    // 收入 / 支出：按分类类型过滤，空串表示不限
+    const std::string& GetCategoryType() const { return category_type_; }
+    void SetCategoryType(const std::string& category_type);
+
+    // 备注包含的子串，空串表示不限
+    const std::string& GetContentContains() const { return content_contains_; }
+    void SetContentContains(const std::string& text);
+
+    // 指定账单 id
+    const std::vector<int>& GetBillIds() const { return bill_ids_; }
+    void AddBillId(int bill_id);
+
+    // 附加的条件表达式树，与上面的条件为“与”关系
+    const QueryPredicate& GetWhere() const { return where_; }
+    void SetWhere(QueryPredicate where);
+
+    // 排序与条数
+    SortField GetSortField() const { return sort_field_; }
+    bool IsDescending() const { return descending_; }
+    void SetSort(SortField field, bool descending);
+    size_t GetLimit() const { return limit_; }
+    void SetLimit(size_t limit);
+
     // 便捷方法
     bool HasDateRange() const;
     bool HasCategoryFilter() const;
+    bool HasAmountRange() const;
+    bool HasBillIdFilter() const;
+    // 是否有任何过滤条件（不含排序与条数）
+    bool HasFilters() const;
+
+    // 判断一行是否满足全部过滤条件（不考虑排序与条数）
+    bool Matches(const QueryRow& row) const;
+    // 全部过滤条件组成的表达式树
+    QueryPredicate ToPredicate() const;
 
     // 调试输出
     std::string ToString() const;
+    // 全部条件（含排序与条数）的精确文本表示，见 QueryPredicate::CacheKey
+    std::string CacheKey() const;
 
 private:
     std::chrono::system_clock::time_point start_date_;
     std::chrono::system_clock::time_point end_date_;
-    std::string category_name_;
+    std::vector<std::string> category_names_;
+    std::vector<int> category_ids_;
+    Money min_amount_;
+    Money max_amount_;
+    std::string category_type_;
+    std::string content_contains_;
+    std::vector<int> bill_ids_;
+    QueryPredicate where_;
+    SortField sort_field_ = SortField::kTime;
+    bool descending_ = false;
+    size_t limit_ = 0;
 };
 
 }  // namespace accounting
 
-#endif  // ACCOUNTING_MODELS_QUERY_CRITERIA_H_
\ No newline at end of file
+#endif  // ACCOUNTING_MODELS_QUERY_CRITERIA_H_
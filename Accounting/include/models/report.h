@@ -5,14 +5,85 @@
 #include <unordered_map>
 #include <vector>
 #include <chrono>
+#include <cstdint>
+#include <utility>
 
 #include "models/period.h"
 #include "models/chart_type.h"
 #include "models/bill_data.h"
+#include "models/money.h"
 #include "models/query_criteria.h"
 
 namespace accounting {
 
+/**
+ * @brief 报表中一个时间段（天 / 周 / 月 / 年）的汇总
+ *
+ * 时间段按本地日历划分：周从周一开始，月从 1 日开始，年从 1 月 1 日开始。
+ */
+struct ReportBucket {
+    std::chrono::system_clock::time_point start;  // 时间段第一天的本地 0 点
+    std::string label;  // 天、周："YYYY-MM-DD"（周为周一的日期）；月："YYYY-MM"；年："YYYY"
+    std::unordered_map<std::string, double> category_summary;  // category → total amount
+    Money total_income;
+    Money total_expense;
+};
+
+class Category;
+class Report;
+
+/**
+ * @brief 逐项累加报表数据，最后生成 Report
+ *
+ * 每一项为某本地日期（1970-01-01 起的天数，见 time_utils::LocalDayNumber）的一笔金额，
+ * 可以是单个账单，也可以是某分类一天的合计。分类名称在内部映射为序号，每项只查一次名称；
+ * 连续落在同一时间段的项不再做日历换算。period 为 kCustom 时忽略日期。
+ */
+class ReportBuilder {
+public:
+    explicit ReportBuilder(Period period);
+
+    void Add(int64_t local_day, Money amount, const std::string& category_name,
+             const std::string& category_type);
+    // 按分类 id 累加：某 id 第一次出现时读取一次分类名称与类型，之后只按 id 查表，
+    // 不比较、不复制字符串。category 为空表示无分类；同一 id 须对应同一分类
+    void Add(int64_t local_day, Money amount, int category_id, const Category* category);
+    Report Build(ChartType chart_type);
+
+private:
+    struct CategoryCell {
+        Money total;
+        bool seen = false;
+    };
+    struct CategoryKind {
+        size_t slot;  // 分类序号
+        bool income;
+        bool expense;
+    };
+    struct BucketTotals {
+        int64_t first_day;
+        std::vector<CategoryCell> categories;  // 按分类序号
+        Money income;
+        Money expense;
+    };
+
+    size_t CategorySlot(const std::string& category_name);
+    void AddToSlot(int64_t local_day, Money amount, size_t category_index, bool is_income,
+                   bool is_expense);
+
+    Period period_;
+    std::unordered_map<std::string, size_t> category_slots_;  // 分类名称 -> 序号
+    std::vector<const std::string*> category_names_;          // 指向 category_slots_ 中的键
+    std::vector<Money> category_totals_;
+    std::unordered_map<int, CategoryKind> category_kinds_;  // 分类 id -> 序号与收支类型
+    Money total_income_;
+    Money total_expense_;
+    std::unordered_map<int64_t, size_t> bucket_slots_;  // 时间段第一天 -> buckets_ 下标
+    std::vector<BucketTotals> buckets_;
+    std::pair<int64_t, int64_t> last_range_{0, 0};  // 上一项所在的时间段 [first, next)
+    size_t last_bucket_ = 0;
+};
+
 class Report {
 public:
     // 默认构造
@@ -23,12 +94,20 @@ public:
            ChartType chart_type,
            const std::unordered_map<std::string, double>& category_summary);
 
-    // 生成报表的静态工厂函数
+    // 生成报表的静态工厂函数。除 kCustom 外同时按 period 把账单划分到时间段，
+    // 一次遍历得到全部时间段的汇总（见 GetSeries）
     static Report Generate(const std::vector<BillData>& bills,
                            const QueryCriteria& criteria,
                            Period period,
                            ChartType chart_type);
 
+    // 由已汇总的数据生成报表（不含时间段序列）：分类名称 → 合计（空名称已归为 "Uncategorized"）及收入 / 支出合计
+    static Report FromTotals(Period period,
+                             ChartType chart_type,
+                             const std::unordered_map<std::string, Money>& category_totals,
+                             Money total_income,
+                             Money total_expense);
+
     // Getter / Setter
     Period GetPeriod() const;
     void SetPeriod(Period period);
@@ -41,6 +120,12 @@ public:
 
     double GetTotalIncome() const;
     double GetTotalExpense() const;
+    // 精确合计（单位：分）
+    Money GetTotalIncomeMoney() const;
+    Money GetTotalExpenseMoney() const;
+
+    // 按时间段起点升序的汇总序列；period 为 kCustom 或由 FromTotals 生成时为空
+    const std::vector<ReportBucket>& GetSeries() const;
 
     std::string ToString() const;
 
@@ -52,8 +137,11 @@ private:
     Period period_;
     ChartType chart_type_;
     std::unordered_map<std::string, double> category_summary_;  // category → total amount
-    double total_income_;
-    double total_expense_;
+    Money total_income_;
+    Money total_expense_;
+    std::vector<ReportBucket> series_;
+
+    friend class ReportBuilder;
 };
 
 }  // namespace accounting
@@ -0,0 +1,33 @@
+#ifndef ACCOUNTING_STORAGE_BILL_JSON_READER_H_
+#define ACCOUNTING_STORAGE_BILL_JSON_READER_H_
+
+#include <istream>
+#include <map>
+#include <vector>
+#include "models/bill.h"
+
+namespace accounting {
+
+/**
+ * @brief 流式读取 bills.json（基于 nlohmann::json_sax）
+ *
+ * 不构建 JSON DOM，解析到每个账单对象结束时直接构造 Bill 并追加到对应用户的 vector，
+ * 峰值内存约等于最终对象本身。格式与 JsonStorage 写出的一致：
+ *   [[user_id, [ {bill}, {bill}, ... ]], ...]
+ * 账单字段的要求与 from_json(const json&, Bill&) 相同：bill_id / amount / content / time 必填，
+ * category_id 可缺省或为 null（视为 -1），未知字段忽略。
+ *
+ * format 为 cbor / msgpack 时按相同结构读取二进制编码的文件（输入流需以二进制模式打开）。
+ *
+ * @return 解析成功返回 true；格式错误返回 false，此时 bills 内容不确定
+ */
+bool ReadBillsJson(std::istream& input, std::map<int, std::vector<Bill>>& bills,
+                   json::input_format_t format = json::input_format_t::json);
+
+// 流式读取单个用户的账单数组 [ {bill}, ... ]（按用户分片存储的 bills.json）
+bool ReadUserBillsJson(std::istream& input, std::vector<Bill>& bills,
+                       json::input_format_t format = json::input_format_t::json);
+
+}  // namespace accounting
+
+#endif  // ACCOUNTING_STORAGE_BILL_JSON_READER_H_
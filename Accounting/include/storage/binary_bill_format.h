@@ -0,0 +1,80 @@
+#ifndef ACCOUNTING_STORAGE_BINARY_BILL_FORMAT_H_
+#define ACCOUNTING_STORAGE_BINARY_BILL_FORMAT_H_
+
+#include <cstdint>
+
+namespace accounting {
+namespace binary_bill_format {
+
+/**
+ * bills.bin 文件布局（按主机字节序写入，头部带字节序标记）：
+ *
+ *   FileHeader
+ *   UserEntry[user_count]                 // 按 user_id 升序
+ *   用户数据块 ...                         // 每块起始按 8 字节对齐
+ *
+ * 每个用户数据块按列存放 n 笔账单：
+ *
+ *   int64_t  time[n]                      // Unix 秒
+ *   int64_t  amount_cents[n]              // 金额（分）；版本 1 为 double amount[n]（元）
+ *   int32_t  bill_id[n]
+ *   int32_t  category_id[n]
+ *   uint32_t content_offset[n + 1]        // 第 i 笔备注为 content[off[i], off[i+1])
+ *   char     content[content_bytes]       // 所有备注首尾相连
+ */
+
+constexpr char kMagic[8] = {'A', 'C', 'C', 'T', 'B', 'I', 'L', 'L'};
+constexpr uint32_t kVersion = 2;
+constexpr uint32_t kDoubleAmountVersion = 1;  // 旧版本：金额列为 double，仍可读取
+constexpr uint32_t kEndianTag = 0x01020304;
+
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t endian_tag;
+    uint32_t user_count;
+    uint32_t reserved;
+};
+
+struct UserEntry {
+    int32_t user_id;
+    uint32_t bill_count;
+    uint64_t block_offset;   // 相对文件起始
+    uint64_t content_bytes;
+};
+
+static_assert(sizeof(FileHeader) == 24, "unexpected FileHeader padding");
+static_assert(sizeof(UserEntry) == 24, "unexpected UserEntry padding");
+static_assert(sizeof(double) == sizeof(int64_t), "amount column width differs between versions");
+
+inline uint64_t AlignUp(uint64_t value, uint64_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+// 用户数据块内各列相对块起始的偏移
+struct BlockLayout {
+    uint64_t time = 0;
+    uint64_t amount = 0;
+    uint64_t bill_id = 0;
+    uint64_t category_id = 0;
+    uint64_t content_offset = 0;
+    uint64_t content = 0;
+    uint64_t size = 0;  // 含尾部对齐填充
+
+    static BlockLayout For(uint64_t bill_count, uint64_t content_bytes) {
+        BlockLayout layout;
+        layout.time = 0;
+        layout.amount = layout.time + bill_count * sizeof(int64_t);
+        layout.bill_id = layout.amount + bill_count * sizeof(int64_t);
+        layout.category_id = layout.bill_id + bill_count * sizeof(int32_t);
+        layout.content_offset = layout.category_id + bill_count * sizeof(int32_t);
+        layout.content = layout.content_offset + (bill_count + 1) * sizeof(uint32_t);
+        layout.size = AlignUp(layout.content + content_bytes, 8);
+        return layout;
+    }
+};
+
+}  // namespace binary_bill_format
+}  // namespace accounting
+
+#endif  // ACCOUNTING_STORAGE_BINARY_BILL_FORMAT_H_
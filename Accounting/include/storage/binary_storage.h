@@ -0,0 +1,47 @@
+#ifndef ACCOUNTING_STORAGE_BINARY_STORAGE_H_
+#define ACCOUNTING_STORAGE_BINARY_STORAGE_H_
+
+#include "storage/storage.h"
+#include "storage/json_storage.h"
+#include <string>
+
+namespace accounting {
+
+/**
+ * @brief 账单使用二进制列式快照的存储实现
+ *
+ * 账单按用户分块、按列写入 bills.bin（格式见 binary_bill_format.h），
+ * 加载时映射文件后直接按列构造 Bill，不做文本解析和时间字符串转换；
+ * BillManager 也可通过 OpenBillSnapshot 按用户按需读取，启动时不反序列化账单。
+ * 用户、分类、预算数据量小，仍沿用 JsonStorage 的 JSON 文件。
+ */
+class BinaryStorage : public Storage {
+public:
+    explicit BinaryStorage(const std::string& base_path);
+    ~BinaryStorage() override = default;
+
+    // 用户
+    std::pair<bool, std::vector<User>> LoadUsers() override;
+    bool SaveUsers(const std::vector<User>& users) override;
+
+    // 分类
+    std::pair<bool, std::map<int, std::vector<Category>>> LoadCategoriesByUser() override;
+    bool SaveCategoriesByUser(const std::map<int, std::vector<Category>>& data) override;
+
+    // 账单
+    std::pair<bool, std::map<int, std::vector<Bill>>> LoadBillsByUser() override;
+    bool SaveBillsByUser(const std::map<int, std::vector<Bill>>& data) override;
+    std::pair<bool, std::shared_ptr<const MappedBillSnapshot>> OpenBillSnapshot() override;
+
+    // 预算
+    std::pair<bool, std::map<int, Budget>> LoadBudgetsByUser() override;
+    bool SaveBudgetsByUser(const std::map<int, Budget>& data) override;
+
+private:
+    std::string base_path_;
+    JsonStorage json_;  // users / categories / budgets
+};
+
+}  // namespace accounting
+
+#endif  // ACCOUNTING_STORAGE_BINARY_STORAGE_H_
@@ -3,21 +3,53 @@
 
 #include "storage/storage.h"
 #include <string>
+#include <fstream>
 #include <filesystem>
 
 namespace accounting {
 
+// JsonStorage 的可选行为
+struct JsonStorageOptions {
+    // 文件布局
+    //   kSingleFile: 每类数据一个文件（users.json / bills.json / categories.json / budgets.json）
+    //   kSharded:    users.json 作为用户索引，其余按用户分目录：
+    //                users/<user_id>/bills.json、categories.json、budget.json、bill_rollup.json，
+    //                可以只读写单个用户的数据
+    enum class Layout { kSingleFile, kSharded };
+    Layout layout = Layout::kSingleFile;
+
+    // 文件编码
+    //   kText:        文本 JSON（*.json）
+    //   kCbor:        CBOR（*.cbor），数据结构与文本 JSON 相同
+    //   kMessagePack: MessagePack（*.msgpack），数据结构与文本 JSON 相同
+    // 二进制编码体积更小、解析更快，适合备份和大数据量；bills.log 始终是文本 JSON 行
+    enum class Encoding { kText, kCbor, kMessagePack };
+    Encoding encoding = Encoding::kText;
+
+    // 账单变更追加写入 bills.log（每行一条紧凑 JSON），而不是每次保存都重写 bills.json。
+    // 持久性：每条记录写入后只进入操作系统缓存，进程崩溃不丢失，但断电可能丢失最近的记录；
+    // SaveAll（SyncBillLog）返回时之前的记录都已落盘（fdatasync）。
+    // checkpoint 写出的快照文件先落盘，再删除日志
+    bool enable_bill_log = false;
+    // 每追加一条日志就落盘：增删改返回成功时该变更已在磁盘上，代价是每次写入一次 fdatasync
+    bool sync_bill_log = false;
+};
+
 /**
  * @brief 基于 JSON 文件的存储实现类
  * 
  * JsonStorage 实现了 Storage 接口，
  * 使用 JSON 文件在本地进行数据持久化。
- * 每个数据类型对应一个独立的文件。
+ * 每个数据类型对应一个独立的文件，文件可以是文本 JSON、CBOR 或 MessagePack 编码。
  */
 class JsonStorage : public Storage {
 public:
-    explicit JsonStorage(const std::string& base_path);
-    ~JsonStorage() override = default;
+    explicit JsonStorage(const std::string& base_path,
+                         const JsonStorageOptions& options = JsonStorageOptions());
+    ~JsonStorage() override;
+    // 持有日志文件描述符，不可复制
+    JsonStorage(const JsonStorage&) = delete;
+    JsonStorage& operator=(const JsonStorage&) = delete;
 
     // 用户
     std::pair<bool, std::vector<User>> LoadUsers() override;
@@ -35,10 +67,37 @@ public:
     std::pair<bool, std::map<int, Budget>> LoadBudgetsByUser() override;
     bool SaveBudgetsByUser(const std::map<int, Budget>& data) override;
 
+    // 按用户读写（分片布局下只访问该用户的文件）
+    bool SupportsPerUserLoad() const override;
+    std::pair<bool, std::vector<Category>> LoadCategoriesForUser(int user_id) override;
+    std::pair<bool, std::vector<Bill>> LoadBillsForUser(int user_id) override;
+    std::pair<bool, std::shared_ptr<Budget>> LoadBudgetForUser(int user_id) override;
+    bool SupportsPartialSave() const override;
+    bool SaveCategoriesForUsers(const std::map<int, std::vector<Category>>& data) override;
+    bool SaveBillsForUsers(const std::map<int, std::vector<Bill>>& data) override;
+    bool SaveBudgetsForUsers(const std::map<int, Budget>& data) override;
+
+    // 账单变更日志
+    bool IsBillLogEnabled() const override;
+    bool AppendBillLog(const BillLogRecord& record) override;
+    bool SyncBillLog() override;
+    std::pair<bool, std::vector<BillLogRecord>> LoadBillLog() override;
+    bool ClearBillLog() override;
+
+    // 账单按日汇总（编码同其他文件）：单文件布局保存在 bill_rollups 文件中，
+    // 分片布局按用户保存在 users/<user_id>/bill_rollup 文件中
+    bool SupportsBillRollups() const override;
+    std::pair<bool, std::map<int, BillRollupSnapshot>> LoadBillRollups() override;
+    bool SaveBillRollups(const std::map<int, BillRollupSnapshot>& data) override;
+    std::pair<bool, std::shared_ptr<BillRollupSnapshot>> LoadBillRollupForUser(int user_id) override;
+    bool SaveBillRollupsForUsers(const std::map<int, BillRollupSnapshot>& data) override;
+
     // Report persistence intentionally omitted (reports are derived).
 
 private:
     std::string base_path_;  // 存放所有 JSON 文件的路径
+    JsonStorageOptions options_;
+    int bill_log_fd_ = -1;  // 追加模式打开的 bills.log，首次写入时打开
 
     // 工具函数：通用的 JSON 读写模板函数
     template<typename T>
@@ -46,6 +105,19 @@ private:
 
     template<typename T>
     bool LoadFromJson(const std::string& filename, T& data);
+
+    // 按编码加上扩展名，例如 DataFile(base_path_, "bills") -> <base>/bills.cbor
+    std::string DataFile(const std::string& dir, const std::string& name) const;
+
+    // ===== 分片布局 =====
+    bool IsSharded() const { return options_.layout == JsonStorageOptions::Layout::kSharded; }
+    std::string UserDir(int user_id) const;
+    // users/ 下所有以数字命名的用户目录
+    std::vector<int> ListShardUserIds() const;
+    bool LoadUserBills(int user_id, std::vector<Bill>& bills) const;
+    // 写入 data 中每个用户的 name 文件；replace_all 为 true 时删除 data 之外用户的同名文件
+    template<typename T>
+    bool SaveShards(const std::map<int, T>& data, const std::string& name, bool replace_all);
 };
 
 }  // namespace accounting
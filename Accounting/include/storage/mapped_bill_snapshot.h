@@ -0,0 +1,73 @@
+#ifndef ACCOUNTING_STORAGE_MAPPED_BILL_SNAPSHOT_H_
+#define ACCOUNTING_STORAGE_MAPPED_BILL_SNAPSHOT_H_
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include "models/bill.h"
+
+namespace accounting {
+
+/**
+ * @brief 内存映射的只读账单快照（bills.bin，格式见 binary_bill_format.h）
+ *
+ * 打开时只映射文件并读取用户目录，不反序列化任何账单；
+ * 列数据直接指向映射内存，按需读取单个用户或单笔账单。
+ * 对象在存活期间保持映射有效，文件被新快照替换不影响已打开的映射。
+ */
+class MappedBillSnapshot {
+public:
+    // 单个用户的列视图，指针均指向映射内存
+    struct UserColumns {
+        size_t count = 0;
+        const int64_t* time = nullptr;
+        const int64_t* amount_cents = nullptr;  // 金额（分）
+        const double* double_amount = nullptr;  // 版本 1 的文件：金额（元），此时 amount_cents 为空
+        const int32_t* bill_id = nullptr;
+        const int32_t* category_id = nullptr;
+        const uint32_t* content_offset = nullptr;  // count + 1 项
+        const char* content = nullptr;
+        uint64_t content_bytes = 0;
+
+        Money Amount(size_t index) const {
+            return amount_cents ? Money::FromCents(amount_cents[index])
+                                : Money::FromDouble(double_amount[index]);
+        }
+    };
+
+    /**
+     * @brief 映射快照文件
+     * @return {true, nullptr} 文件不存在；{false, nullptr} 文件损坏或映射失败
+     */
+    static std::pair<bool, std::shared_ptr<const MappedBillSnapshot>> Open(const std::string& path);
+
+    ~MappedBillSnapshot();
+    MappedBillSnapshot(const MappedBillSnapshot&) = delete;
+    MappedBillSnapshot& operator=(const MappedBillSnapshot&) = delete;
+
+    std::vector<int> GetUserIds() const;
+    const UserColumns* FindUser(int user_id) const;
+
+    // 构造第 index 笔账单（category 指针为空，仅带 category_id）
+    static Bill MakeBill(const UserColumns& columns, size_t index);
+
+    // 把某用户的全部账单追加到 out；用户不存在返回 true 且不追加，数据损坏返回 false
+    bool MaterializeUser(int user_id, std::vector<Bill>& out) const;
+
+private:
+    MappedBillSnapshot() = default;
+    bool Parse();
+
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    bool mapped_ = false;        // true: data_ 来自 mmap，需要 munmap
+    std::vector<char> buffer_;   // 不支持 mmap 的平台退化为整体读入
+    std::map<int, UserColumns> users_;
+};
+
+}  // namespace accounting
+
+#endif  // ACCOUNTING_STORAGE_MAPPED_BILL_SNAPSHOT_H_
@@ -1,6 +1,7 @@
 #ifndef ACCOUNTING_STORAGE_STORAGE_H_
 #define ACCOUNTING_STORAGE_STORAGE_H_
 
+#include <cstdint>
 #include <map>
 #include <vector>
 #include <memory>
@@ -14,7 +15,41 @@
 
 namespace accounting {
 
+class MappedBillSnapshot;
+
+// 账单变更日志记录（WAL）：BillManager 的每次增删改对应一条记录，
+// 追加写入日志文件，Initialize 时在 bills 快照之上按顺序重放。
+struct BillLogRecord {
+    enum class Op { kAdd, kUpdate, kDelete };
+
+    Op op = Op::kAdd;
+    int user_id = 0;
+    Bill bill;        // kAdd / kUpdate 使用
+    int bill_id = 0;  // kDelete 使用
+};
+
+// 某用户账单的按日汇总（派生数据）：每项为一个 (分类 id, 本地日期) 的金额合计与账单数，
+// day 为 1970-01-01 起的天数。bill_count / total_cents / checksum 描述写入时该用户的全部账单，
+// day_fingerprint 记录写入时各日期的本地 0 点（依赖时区规则）；
+// 读取后与当前账单、当前时区核对，不一致时丢弃并重新计算（见 BillRollup）
+struct BillRollupEntry {
+    int category_id = -1;
+    int64_t day = 0;
+    int64_t total_cents = 0;
+    int64_t count = 0;
+};
+
+struct BillRollupSnapshot {
+    int64_t bill_count = 0;
+    int64_t total_cents = 0;
+    uint64_t checksum = 0;
+    uint64_t day_fingerprint = 0;
+    std::vector<BillRollupEntry> entries;
+};
+
 // Storage 接口，提供系统数据的读写抽象
+// 并发约定：AccountManager 并行初始化时，不同数据类型的 Load* 方法（用户 / 分类 / 账单及其日志 / 预算）
+// 会在不同线程中同时调用；同一方法不会并发调用，Save* 也不会与 Load* 并发
 class Storage {
 public:
     virtual ~Storage() = default;
@@ -39,6 +74,98 @@ public:
     virtual bool SaveBudgetsByUser(
         const std::map<int, Budget>& data) = 0;
 
+    // ===== 按用户读取 =====
+    // 只读取一个用户的数据。默认实现读取全部后取出该用户；按用户分片的存储应覆盖为只读该用户的文件。
+    // SupportsPerUserLoad 为 true 时，BillManager 启动时不加载账单，用户登录时再加载。
+    virtual bool SupportsPerUserLoad() const { return false; }
+    virtual std::pair<bool, std::vector<Category>> LoadCategoriesForUser(int user_id) {
+        auto res = LoadCategoriesByUser();
+        if (!res.first) return {false, {}};
+        auto it = res.second.find(user_id);
+        if (it == res.second.end()) return {true, {}};
+        return {true, std::move(it->second)};
+    }
+    virtual std::pair<bool, std::vector<Bill>> LoadBillsForUser(int user_id) {
+        auto res = LoadBillsByUser();
+        if (!res.first) return {false, {}};
+        auto it = res.second.find(user_id);
+        if (it == res.second.end()) return {true, {}};
+        return {true, std::move(it->second)};
+    }
+    // 用户没有预算时返回 {true, nullptr}
+    virtual std::pair<bool, std::shared_ptr<Budget>> LoadBudgetForUser(int user_id) {
+        auto res = LoadBudgetsByUser();
+        if (!res.first) return {false, nullptr};
+        auto it = res.second.find(user_id);
+        if (it == res.second.end()) return {true, nullptr};
+        return {true, std::make_shared<Budget>(it->second)};
+    }
+
+    // ===== 按用户增量保存（可选能力，默认不支持） =====
+    // 支持时各 Manager 在保存时只写入修改过的用户，data 中未出现的用户保持存储中的原样；
+    // 不支持时 Manager 整体调用 Save*ByUser 重写。
+    virtual bool SupportsPartialSave() const { return false; }
+    virtual bool SaveCategoriesForUsers(const std::map<int, std::vector<Category>>& data) {
+        (void)data;
+        return false;
+    }
+    virtual bool SaveBillsForUsers(const std::map<int, std::vector<Bill>>& data) {
+        (void)data;
+        return false;
+    }
+    virtual bool SaveBudgetsForUsers(const std::map<int, Budget>& data) {
+        (void)data;
+        return false;
+    }
+
+    // ===== 账单只读快照（可选能力，默认不支持） =====
+    // 返回内存映射的账单快照，BillManager 据此按用户按需读取，而不是在加载时反序列化全部账单。
+    // {true, nullptr} 表示不支持或快照不存在，此时走 LoadBillsByUser。
+    virtual std::pair<bool, std::shared_ptr<const MappedBillSnapshot>> OpenBillSnapshot() {
+        return {true, nullptr};
+    }
+
+    // ===== 账单变更日志（可选能力，默认不支持） =====
+    // 启用后 BillManager 的增删改逐条追加到日志，SaveAll 不再全量重写账单快照；
+    // 日志累积到一定条数后由 BillManager 写快照并清空日志（checkpoint）。
+    virtual bool IsBillLogEnabled() const { return false; }
+    virtual bool AppendBillLog(const BillLogRecord& record) {
+        (void)record;
+        return false;
+    }
+    // 把已追加的日志记录刷到磁盘（而不只是操作系统缓存），SaveAll 时调用
+    virtual bool SyncBillLog() { return true; }
+    // 读取尚未合并进快照的日志记录；无日志时返回 {true, {}}
+    virtual std::pair<bool, std::vector<BillLogRecord>> LoadBillLog() { return {true, {}}; }
+    // 快照写入成功后调用，丢弃已合并的日志
+    virtual bool ClearBillLog() { return true; }
+
+    // ===== 账单按日汇总（可选能力，默认不支持） =====
+    // BillManager 保存时一并写入，下次启动后直接使用，不必遍历账单重新计算。
+    // Save 的 data 为全部用户的汇总，整体替换存储中的旧数据；没有汇总时 Load 返回 {true, {}}
+    virtual bool SupportsBillRollups() const { return false; }
+    virtual std::pair<bool, std::map<int, BillRollupSnapshot>> LoadBillRollups() {
+        return {true, {}};
+    }
+    virtual bool SaveBillRollups(const std::map<int, BillRollupSnapshot>& data) {
+        (void)data;
+        return false;
+    }
+    // 按用户读写汇总，与账单一同按用户加载 / 增量保存。
+    // 用户没有汇总时返回 {true, nullptr}；默认实现读取全部后取出该用户
+    virtual std::pair<bool, std::shared_ptr<BillRollupSnapshot>> LoadBillRollupForUser(int user_id) {
+        auto res = LoadBillRollups();
+        if (!res.first) return {false, nullptr};
+        auto it = res.second.find(user_id);
+        if (it == res.second.end()) return {true, nullptr};
+        return {true, std::make_shared<BillRollupSnapshot>(std::move(it->second))};
+    }
+    // SupportsPartialSave 为 true 时可用：只写 data 中的用户，其余用户的汇总保持原样
+    virtual bool SaveBillRollupsForUsers(const std::map<int, BillRollupSnapshot>& data) {
+        (void)data;
+        return false;
+    }
+
     // NOTE: Report persistence APIs removed — reports are derived data and
     // can be regenerated on demand. If snapshotting is later required,
     // add explicit APIs for report definitions or snapshots.
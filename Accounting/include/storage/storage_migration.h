@@ -0,0 +1,20 @@
+#ifndef ACCOUNTING_STORAGE_STORAGE_MIGRATION_H_
+#define ACCOUNTING_STORAGE_STORAGE_MIGRATION_H_
+
+#include <memory>
+#include "storage/storage.h"
+
+namespace accounting {
+
+/**
+ * @brief 把 source 中的全部数据（用户、分类、预算、账单）写入 target
+ *
+ * 账单经由 BillManager 加载，因此 source 中尚未合并的账单变更日志也会一并迁移。
+ * @return 全部读写成功返回 true
+ */
+bool MigrateStorage(const std::shared_ptr<Storage>& source,
+                    const std::shared_ptr<Storage>& target);
+
+}  // namespace accounting
+
+#endif  // ACCOUNTING_STORAGE_STORAGE_MIGRATION_H_
@@ -0,0 +1,38 @@
+#ifndef ACCOUNTING_UTILS_MONEY_SUM_H_
+#define ACCOUNTING_UTILS_MONEY_SUM_H_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace accounting {
+namespace money_sum {
+
+/**
+ * @brief 金额列（单位：分）的求和内核
+ *
+ * 整数加法满足结合律（溢出时按补码回绕，同样与顺序无关），因此无论向量宽度、
+ * 分块方式还是线程数如何，结果都与逐个顺序累加完全相同。
+ * 编译时启用 AVX2（如 -mavx2 / -march=native）使用 256 位指令，否则使用可被自动向量化的
+ * 多累加器循环。
+ */
+int64_t SumCents(const int64_t* cents, size_t count);
+
+// 只累加 times[i] 落在 [start, end] 内的行（无分支，按掩码累加）
+int64_t SumCentsInTimeRange(const int64_t* cents,
+                            const std::chrono::system_clock::time_point* times, size_t count,
+                            const std::chrono::system_clock::time_point& start,
+                            const std::chrono::system_clock::time_point& end);
+
+// 按固定大小的块在多个线程上求和；行数较少时直接在调用线程中计算。结果与 SumCents 相同
+int64_t ParallelSumCents(const int64_t* cents, size_t count);
+int64_t ParallelSumCentsInTimeRange(const int64_t* cents,
+                                    const std::chrono::system_clock::time_point* times,
+                                    size_t count,
+                                    const std::chrono::system_clock::time_point& start,
+                                    const std::chrono::system_clock::time_point& end);
+
+}  // namespace money_sum
+}  // namespace accounting
+
+#endif  // ACCOUNTING_UTILS_MONEY_SUM_H_
@@ -0,0 +1,51 @@
+#ifndef ACCOUNTING_UTILS_PARALLEL_H_
+#define ACCOUNTING_UTILS_PARALLEL_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <thread>
+#include <vector>
+
+namespace accounting {
+
+/**
+ * @brief 对 [0, count) 的每个下标调用 fn(i)，按连续区间分给多个线程执行
+ *
+ * 线程数取 hardware_concurrency，每个线程至少分到 min_chunk 个下标；
+ * 任务太少时直接在调用线程中执行。fn 必须可以被并发调用（不同下标之间无共享写）。
+ * 任一调用抛出的异常会在所有线程结束后重新抛给调用者（只保留第一个）。
+ */
+template<typename F>
+void ParallelFor(size_t count, F&& fn, size_t min_chunk = 64) {
+    const size_t hw = std::max<size_t>(1, std::thread::hardware_concurrency());
+    const size_t threads = std::min(hw, count / std::max<size_t>(1, min_chunk));
+    if (threads <= 1) {
+        for (size_t i = 0; i < count; ++i) fn(i);
+        return;
+    }
+
+    std::vector<std::exception_ptr> errors(threads);
+    auto run = [&fn, &errors, count, threads](size_t t) {
+        const size_t begin = count * t / threads;
+        const size_t end = count * (t + 1) / threads;
+        try {
+            for (size_t i = begin; i < end; ++i) fn(i);
+        } catch (...) {
+            errors[t] = std::current_exception();
+        }
+    };
+
+    std::vector<std::thread> workers;
+    workers.reserve(threads - 1);
+    for (size_t t = 1; t < threads; ++t) workers.emplace_back(run, t);
+    run(0);
+    for (auto& worker : workers) worker.join();
+    for (const auto& error : errors) {
+        if (error) std::rethrow_exception(error);
+    }
+}
+
+}  // namespace accounting
+
+#endif  // ACCOUNTING_UTILS_PARALLEL_H_
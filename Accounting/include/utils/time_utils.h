@@ -0,0 +1,61 @@
+#ifndef ACCOUNTING_UTILS_TIME_UTILS_H_
+#define ACCOUNTING_UTILS_TIME_UTILS_H_
+
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <string>
+
+namespace accounting {
+namespace time_utils {
+
+// 本地时间的日历字段（month 1-12，day 1-31）
+struct CivilTime {
+    int year = 1970;
+    int month = 1;
+    int day = 1;
+    int hour = 0;
+    int minute = 0;
+    int second = 0;
+};
+
+// 公历日期与 1970-01-01 起天数的互相转换（proleptic Gregorian，支持负数天数）
+int64_t DaysFromCivil(int year, int month, int day);
+void CivilFromDays(int64_t days, int& year, int& month, int& day);
+
+// 某时刻所在的本地日期（1970-01-01 起的天数），只做整数运算（时区偏移见 LocalUtcOffset）
+int64_t LocalDayNumber(const std::chrono::system_clock::time_point& tp);
+// 本地日期当天 0 点对应的时刻
+std::chrono::system_clock::time_point LocalDayStart(int64_t days);
+
+/**
+ * @brief 某个 UTC 时刻的本地时区偏移（秒，本地时间 = UTC + 偏移）
+ *
+ * 结果按 15 分钟的 UTC 区间缓存在线程本地表中（时区切换都发生在整 15 分钟处），
+ * 命中时不调用 localtime，也不需要全局时区锁。进程运行期间修改 TZ 不会使缓存失效。
+ */
+int64_t LocalUtcOffset(std::time_t t);
+
+// 本地日历时间 -> time_point（等价于 tm_isdst = -1 的 mktime；字段越界时按进位规范化）
+std::chrono::system_clock::time_point LocalToTimePoint(const CivilTime& local);
+
+// time_point -> 本地日历时间（秒以下截断）
+CivilTime TimePointToLocal(const std::chrono::system_clock::time_point& tp);
+
+/**
+ * @brief 严格解析 "YYYY-MM-DD HH:MM:SS" 或 "YYYY-MM-DD"（时分秒取 0）
+ *
+ * 0-9999 以外的年份按 FormatDateTime 的写法读取：可带负号，4 到 9 位数字。
+ * @return 格式不符或字段超出范围时返回 false
+ */
+bool ParseDateTime(const char* text, size_t length, CivilTime& out);
+
+// 按 "YYYY-MM-DD HH:MM:SS" 格式化本地时间。0-9999 以外的年份不截断：
+// 负数年份带负号，位数不足 4 位时补 0（如 "10000-01-01"、"-0001-01-01"），可由 ParseDateTime 读回
+std::string FormatDateTime(const std::chrono::system_clock::time_point& tp);
+std::string FormatDateTime(const CivilTime& local);
+
+}  // namespace time_utils
+}  // namespace accounting
+
+#endif  // ACCOUNTING_UTILS_TIME_UTILS_H_
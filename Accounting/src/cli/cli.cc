@@ -2,6 +2,8 @@
 #include "storage/json_storage.h"
 #include "models/period.h"
 #include "models/chart_type.h"
+#include "utils/time_utils.h"
+#include <algorithm>
 #include <iostream>
 #include <iomanip>
 #include <sstream>
@@ -12,8 +14,25 @@ namespace accounting {
 
 bool CLI::Initialize(const std::string& data_dir) {
     try {
-        auto storage = std::make_shared<JsonStorage>(data_dir);
-        account_manager_ = std::make_shared<AccountManager>(storage);
+        // 交互式会话频繁保存，账单变更走追加日志，避免每次保存重写整个 bills.json
+        JsonStorageOptions options;
+        options.enable_bill_log = true;
+        AccountManagerOptions manager_options;
+        // 数据目录已转换为按用户分片布局（accounting_convert json data json-sharded ...）时沿用该布局，
+        // 并且只加载登录过的用户
+        if (std::filesystem::is_directory(data_dir + "/users")) {
+            options.layout = JsonStorageOptions::Layout::kSharded;
+            manager_options.lazy_load = true;
+            manager_options.max_resident_users = 8;
+        }
+        // 数据目录已转换为 CBOR / MessagePack 编码时沿用该编码
+        if (std::filesystem::exists(data_dir + "/users.cbor")) {
+            options.encoding = JsonStorageOptions::Encoding::kCbor;
+        } else if (std::filesystem::exists(data_dir + "/users.msgpack")) {
+            options.encoding = JsonStorageOptions::Encoding::kMessagePack;
+        }
+        auto storage = std::make_shared<JsonStorage>(data_dir, options);
+        account_manager_ = std::make_shared<AccountManager>(storage, manager_options);
         
         if (!account_manager_->Initialize()) {
             PrintError("系统初始化失败，无法加载数据");
@@ -306,8 +325,14 @@ void CLI::AddBill() {
     
     Bill bill;
     bill.SetAmount(amount);
-    auto chosen_category = std::make_shared<Category>(categories[cat_choice - 1]);
-    bill.SetCategory(chosen_category);
+    // 使用分类管理器中的共享对象，不为每个账单复制分类
+    const int chosen_id = categories[cat_choice - 1].GetCategoryId();
+    auto chosen_category = account_manager_->GetCategory(*current_user_, chosen_id);
+    if (chosen_category) {
+        bill.SetCategory(chosen_category);
+    } else {
+        bill.SetCategoryId(chosen_id);
+    }
     bill.SetContent(content);
 
     // 选择时间：默认使用当前时间，或自定义日期和时间
@@ -441,19 +466,28 @@ void CLI::AddBill() {
 void CLI::ViewBills() {
     PrintSeparator("账单列表");
     
-    auto bills = account_manager_->GetBills(current_user_->GetUserId());
+    // 按时间顺序逐页显示，每页用上一页的游标定位
+    constexpr int kPageSize = 20;
+    const int user_id = current_user_->GetUserId();
+    auto page = account_manager_->GetBillsAfter(user_id, BillCursor(), kPageSize);
     
-    if (bills.empty()) {
+    if (page.items.empty()) {
         PrintInfo("当前没有账单");
     } else {
         std::cout << "\n";
-        for (const auto& bill : bills) {
-            std::cout << "  [ID: " << bill.GetBillId() << "] ";
-            std::cout << std::fixed << std::setprecision(2) << bill.GetAmount();
-            if (bill.GetCategory()) {
-                std::cout << " - " << bill.GetCategory()->GetName();
+        while (true) {
+            for (const auto& bill : page.items) {
+                std::cout << "  [ID: " << bill.GetBillId() << "] ";
+                std::cout << std::fixed << std::setprecision(2) << bill.GetAmount();
+                if (bill.GetCategory()) {
+                    std::cout << " - " << bill.GetCategory()->GetName();
+                }
+                std::cout << " - " << bill.GetContent() << "\n";
             }
-            std::cout << " - " << bill.GetContent() << "\n";
+            if (!page.has_more) break;
+            std::string more = GetUserInput("\n  按 Enter 显示下一页，输入 q 结束列表: ");
+            if (more == "q" || more == "Q") break;
+            page = account_manager_->GetBillsAfter(user_id, page.next_cursor, kPageSize);
         }
         std::cout << "\n";
     }
@@ -508,7 +542,98 @@ void CLI::DeleteBill() {
 void CLI::QueryBills() {
     PrintSeparator("按条件查询账单");
     
-    PrintInfo("暂不支持高级查询，请使用'查看所有账单'功能");
+    PrintInfo("以下条件直接按 Enter 表示不限");
+    QueryCriteria criteria;
+    
+    // 日期范围（含结束日期当天）
+    std::string start_str = GetUserInput("起始日期 (YYYY-MM-DD): ");
+    std::string end_str = GetUserInput("结束日期 (YYYY-MM-DD): ");
+    std::chrono::system_clock::time_point tp;
+    if (!start_str.empty()) {
+        if (!account_manager_->ParseDateStringToTimePoint(start_str, tp)) {
+            PrintError("起始日期格式错误");
+            Pause();
+            return;
+        }
+        criteria.SetStartDate(tp);
+    }
+    if (!end_str.empty()) {
+        if (!account_manager_->ParseDateStringToTimePoint(end_str, tp)) {
+            PrintError("结束日期格式错误");
+            Pause();
+            return;
+        }
+        // 结束日期当天的最后一刻（次日本地 0 点前一个时钟单位），报表可直接使用按日汇总
+        const int64_t end_day = time_utils::LocalDayNumber(tp);
+        criteria.SetEndDate(time_utils::LocalDayStart(end_day + 1) -
+                            std::chrono::system_clock::duration(1));
+    }
+    
+    // 分类：多个名称以逗号分隔
+    std::string categories = GetUserInput("分类名称 (多个用逗号分隔): ");
+    std::stringstream category_stream(categories);
+    std::string name;
+    while (std::getline(category_stream, name, ',')) {
+        criteria.AddCategoryName(name);
+    }
+    
+    // 金额范围
+    Money min_amount = criteria.GetMinAmount();
+    Money max_amount = criteria.GetMaxAmount();
+    std::string min_str = GetUserInput("最小金额: ");
+    std::string max_str = GetUserInput("最大金额: ");
+    if ((!min_str.empty() && !Money::Parse(min_str, min_amount)) ||
+        (!max_str.empty() && !Money::Parse(max_str, max_amount))) {
+        PrintError("金额格式错误");
+        Pause();
+        return;
+    }
+    criteria.SetAmountRange(min_amount, max_amount);
+    
+    std::string type = GetUserInput("类型 (income/expense): ");
+    if (!type.empty() && type != "income" && type != "expense") {
+        PrintError("类型只能是 income 或 expense");
+        Pause();
+        return;
+    }
+    criteria.SetCategoryType(type);
+    criteria.SetContentContains(GetUserInput("备注包含: "));
+    
+    // 排序与条数
+    std::string sort = GetUserInput("排序 (1. 时间升序 2. 时间降序 3. 金额升序 4. 金额降序): ");
+    if (sort == "2") {
+        criteria.SetSort(QueryCriteria::SortField::kTime, true);
+    } else if (sort == "3") {
+        criteria.SetSort(QueryCriteria::SortField::kAmount, false);
+    } else if (sort == "4") {
+        criteria.SetSort(QueryCriteria::SortField::kAmount, true);
+    }
+    std::string limit = GetUserInput("最多显示条数: ");
+    if (!limit.empty()) {
+        try {
+            criteria.SetLimit(static_cast<size_t>(std::max(0, std::stoi(limit))));
+        } catch (...) {
+            PrintError("条数格式错误");
+            Pause();
+            return;
+        }
+    }
+    
+    auto bills = account_manager_->QueryBills(current_user_->GetUserId(), criteria);
+    if (bills.empty()) {
+        PrintInfo("没有符合条件的账单");
+    } else {
+        std::cout << "\n  共 " << bills.size() << " 条:\n\n";
+        for (const auto& bill : bills) {
+            std::cout << "  [ID: " << bill.GetBillId() << "] ";
+            std::cout << std::fixed << std::setprecision(2) << bill.GetAmount();
+            if (bill.GetCategory()) {
+                std::cout << " - " << bill.GetCategory()->GetName();
+            }
+            std::cout << " - " << bill.GetContent() << "\n";
+        }
+        std::cout << "\n";
+    }
     
     Pause();
 }
@@ -650,6 +775,15 @@ void CLI::GenerateReport() {
                       << std::setprecision(2) << amount << "\n";
         }
     }
+    
+    const auto& series = report.GetSeries();
+    if (!series.empty()) {
+        std::cout << "  按时间段汇总:\n";
+        for (const auto& bucket : series) {
+            std::cout << "    " << bucket.label << "  收入: " << bucket.total_income.ToString()
+                      << "  支出: " << bucket.total_expense.ToString() << "\n";
+        }
+    }
     std::cout << "\n";
     
     Pause();
@@ -1,28 +1,108 @@
 #include "core/account_manager.h"
+#include "utils/time_utils.h"
 #include <iostream>
 #include <algorithm>
 #include <sstream>
 #include <iomanip>
 #include <ctime>
 #include <chrono>
+#include <future>
 
 namespace accounting {
 
-AccountManager::AccountManager(std::shared_ptr<Storage> storage)
+static OperationResult<void> LoadUserFailure() {
+    return OperationResult<void>::Failure(ErrorCode::StorageError, "加载用户数据失败");
+}
+
+// latest 为允许的最晚账单时间；批量添加时只取一次当前时间
+static OperationResult<void> ValidateBillAt(const Bill& bill,
+                                            const std::chrono::system_clock::time_point& latest) {
+    // 验证金额
+    if (bill.GetAmount() <= 0) {
+        return OperationResult<void>::Failure(
+            ErrorCode::InvalidBill,
+            "账单金额必须大于 0"
+        );
+    }
+
+    if (bill.GetAmount() > 1000000) {  // 上限为 100 万
+        return OperationResult<void>::Failure(
+            ErrorCode::InvalidBill,
+            "账单金额不能超过 1000000"
+        );
+    }
+
+    // 验证时间（使用 time_point，不依赖字符串格式）
+    // 这里简单检查时间是否合理：不早于 1970-01-01，且不晚于 latest
+    auto tp = bill.GetTime();
+    auto earliest = std::chrono::system_clock::from_time_t(0);
+    if (tp < earliest || tp > latest) {
+        return OperationResult<void>::Failure(
+            ErrorCode::InvalidBill,
+            "账单时间不合理"
+        );
+    }
+
+    // 验证描述（content）
+    if (bill.GetContent().length() > 256) {
+        return OperationResult<void>::Failure(
+            ErrorCode::InvalidBill,
+            "描述长度不能超过 256 个字符"
+        );
+    }
+
+    return OperationResult<void>::Success();
+}
+
+AccountManager::AccountManager(std::shared_ptr<Storage> storage,
+                               const AccountManagerOptions& options)
     : storage_(std::move(storage)),
+      options_(options),
       category_manager_(storage_) {
     // ReportManager 依赖 BillManager，因此用 unique_ptr 动态初始化
-    report_manager_ = std::make_unique<ReportManager>(&bill_manager_);
+    report_manager_ = std::make_unique<ReportManager>(&bill_manager_, options_.report_cache);
+    if (options_.lazy_load) {
+        category_manager_.SetLazyLoading(true);
+        budget_manager_.SetLazyLoading(true);
+        bill_manager_.SetLazyLoading(true);
+    }
 }
 
 bool AccountManager::Initialize() {
     // 加载所有数据（文件不存在时视为首次运行且不视为失败；文件存在但解析/IO 错误 -> 初始化失败）
-    if (!user_manager_.LoadFromStorage(storage_)) return false;
-    if (!category_manager_.LoadFromStorage()) return false;
-    if (!budget_manager_.LoadFromStorage(storage_)) return false;
-    // BillManager 需要 CategoryManager 已加载，所以放在最后
-    if (!bill_manager_.LoadFromStorage(storage_, category_manager_)) return false;
-    return true;
+    // 懒加载模式下只读取用户索引，其余 Manager 在用户登录时按用户加载
+    resident_users_.clear();
+    resident_index_.clear();
+    if (!options_.parallel_initialize) {
+        if (!user_manager_.LoadFromStorage(storage_)) return false;
+        if (!category_manager_.LoadFromStorage()) return false;
+        if (!budget_manager_.LoadFromStorage(storage_)) return false;
+        // BillManager 需要 CategoryManager 已加载，所以放在最后
+        return bill_manager_.LoadFromStorage(storage_, category_manager_);
+    }
+
+    // 四类数据互相独立，并行读取；各任务只写自己的 Manager
+    auto load = [](auto&& fn) {
+        return std::async(std::launch::async, [fn]() {
+            try {
+                return fn();
+            } catch (...) {
+                return false;
+            }
+        });
+    };
+    auto users = load([this] { return user_manager_.LoadFromStorage(storage_); });
+    auto categories = load([this] { return category_manager_.LoadFromStorage(); });
+    auto budgets = load([this] { return budget_manager_.LoadFromStorage(storage_); });
+    auto bills = load([this] { return bill_manager_.ReadFromStorage(storage_); });
+    // 等待全部任务结束后再返回，避免失败时仍有任务在写 Manager
+    bool ok = users.get();
+    ok &= categories.get();
+    ok &= budgets.get();
+    ok &= bills.get();
+    if (!ok) return false;
+    // 分类就绪后再重放账单日志、恢复账单的分类指针
+    return bill_manager_.FinishLoad(category_manager_);
 }
 
 bool AccountManager::SaveAll() const {
@@ -34,13 +114,69 @@ bool AccountManager::SaveAll() const {
     return ok;
 }
 
+// === 懒加载 ===
+bool AccountManager::TouchUser(int user_id) {
+    if (!options_.lazy_load) {
+        // 非懒加载模式下只有分片存储的账单需要按用户加载
+        return bill_manager_.LoadUser(user_id);
+    }
+    // 分类需要先于账单加载，账单据此恢复分类指针。
+    // 常驻用户各 Manager 本应都已加载，这里只做检查，不会重复读取
+    if (!category_manager_.LoadUser(user_id) ||
+        !budget_manager_.LoadUser(user_id) ||
+        !bill_manager_.LoadUser(user_id)) {
+        return false;
+    }
+    auto it = resident_index_.find(user_id);
+    if (it != resident_index_.end()) {
+        resident_users_.splice(resident_users_.begin(), resident_users_, it->second);
+    } else {
+        resident_users_.push_front(user_id);
+        resident_index_[user_id] = resident_users_.begin();
+    }
+    EvictIdleUsers();  // 之前因未保存而跳过的用户，保存后也在这里释放
+    return true;
+}
+
+void AccountManager::EvictIdleUsers() {
+    if (options_.max_resident_users == 0) return;
+    // 从最久未访问的用户开始释放；有未保存修改的用户跳过，保存后再次访问时才会被释放
+    auto it = resident_users_.end();
+    while (resident_users_.size() > options_.max_resident_users &&
+           it != std::next(resident_users_.begin())) {
+        --it;
+        const int user_id = *it;
+        // 要么全部释放、要么全部保留：只释放一部分会让账单引用的分类、
+        // 预算检查用到的分类在内存中缺失
+        if (!bill_manager_.CanEvictUser(user_id) ||
+            !budget_manager_.CanEvictUser(user_id) ||
+            !category_manager_.CanEvictUser(user_id)) {
+            continue;
+        }
+        // 账单释放可能需要 checkpoint，先释放账单，失败时其他 Manager 保持不动
+        if (!bill_manager_.EvictUser(user_id)) continue;
+        budget_manager_.EvictUser(user_id);
+        category_manager_.EvictUser(user_id);
+        report_manager_->ClearReports(user_id);
+        resident_index_.erase(user_id);
+        it = resident_users_.erase(it);
+    }
+}
+
+std::vector<int> AccountManager::GetResidentUsers() const {
+    return std::vector<int>(resident_users_.begin(), resident_users_.end());
+}
+
 // === 用户 ===
 bool AccountManager::RegisterUser(const std::string& username, const std::string& password) {
     return user_manager_.RegisterUser(username, password);
 }
 
 std::shared_ptr<User> AccountManager::Login(const std::string& username, const std::string& password) {
-    return user_manager_.Login(username, password);
+    auto user = user_manager_.Login(username, password);
+    // 懒加载或按用户分片存储时，登录后才把该用户的数据读入内存
+    if (user && !TouchUser(user->GetUserId())) return nullptr;
+    return user;
 }
 
 // === 账单 ===
@@ -51,20 +187,21 @@ bool AccountManager::CheckBudgetBeforeAdd(int user_id, const Bill& bill) const {
 }
 
 bool AccountManager::AddBill(int user_id, Bill bill) {
+    if (!TouchUser(user_id)) return false;
     if (!CheckBudgetBeforeAdd(user_id, bill)) {
         std::cerr << "[警告] 账单超出预算限制，未添加。\n";
         return false;
     }
-    if (!bill_manager_.AddBill(user_id, bill)) return false;
-    report_manager_->ClearReports(user_id);
-    return true;
+    return bill_manager_.AddBill(user_id, bill);
 }
 
 bool AccountManager::UpdateBill(int user_id, const Bill& bill) {
+    if (!TouchUser(user_id)) return false;
     return bill_manager_.UpdateBill(user_id, bill);
 }
 
 bool AccountManager::DeleteBill(int user_id, int bill_id) {
+    if (!TouchUser(user_id)) return false;
     return bill_manager_.DeleteBill(user_id, bill_id);
 }
 
@@ -78,23 +215,36 @@ std::vector<Bill> AccountManager::QueryBills(int user_id, const QueryCriteria& c
 
 // === 分类 ===
 bool AccountManager::AddCategory(const User& user, const Category& category) {
+    if (!TouchUser(user.GetUserId())) return false;
     return category_manager_.AddCategory(user, category);
 }
 
 bool AccountManager::UpdateCategory(const User& user, const Category& category) {
-    return category_manager_.UpdateCategory(user, category);
+    if (!TouchUser(user.GetUserId())) return false;
+    if (!category_manager_.UpdateCategory(user, category)) return false;
+    report_manager_->ClearReports(user.GetUserId());  // 报表中的分类名称与类型可能变化
+    return true;
 }
 
 bool AccountManager::DeleteCategory(const User& user, int category_id) {
-    return category_manager_.DeleteCategory(user, category_id);
+    if (!TouchUser(user.GetUserId())) return false;
+    if (!category_manager_.DeleteCategory(user, category_id)) return false;
+    report_manager_->ClearReports(user.GetUserId());
+    return true;
 }
 
 std::vector<Category> AccountManager::GetCategories(const User& user) const {
     return category_manager_.GetCategoriesForUser(user);
 }
 
+std::shared_ptr<const Category> AccountManager::GetCategory(const User& user,
+                                                            int category_id) const {
+    return category_manager_.GetSharedCategory(user, category_id);
+}
+
 // === 预算 ===
 bool AccountManager::SetBudget(int user_id, const Budget& budget) {
+    if (!TouchUser(user_id)) return false;
     return budget_manager_.SetBudget(user_id, budget);
 }
 
@@ -169,12 +319,21 @@ OperationResult<std::shared_ptr<User>> AccountManager::LoginEx(
         );
     }
 
+    // 懒加载或按用户分片存储时，登录后才把该用户的数据读入内存
+    if (!TouchUser(user->GetUserId())) {
+        return OperationResult<std::shared_ptr<User>>::Failure(
+            ErrorCode::StorageError,
+            "加载用户数据失败"
+        );
+    }
+
     return OperationResult<std::shared_ptr<User>>::Success(user);
 }
 
 // ========== 第一阶段：带错误处理的账单操作 ==========
 
 OperationResult<void> AccountManager::AddBillEx(int user_id, const Bill& bill) {
+    if (!TouchUser(user_id)) return LoadUserFailure();
     // 验证账单
     auto validation = ValidateBill(bill);
     if (!validation.IsSuccess()) {
@@ -200,11 +359,56 @@ OperationResult<void> AccountManager::AddBillEx(int user_id, const Bill& bill) {
         );
     }
 
-    report_manager_->ClearReports(user_id);
     return OperationResult<void>::Success();
 }
 
+std::vector<OperationResult<void>> AccountManager::AddBillsEx(int user_id,
+                                                             std::vector<Bill>&& bills) {
+    std::vector<OperationResult<void>> results(bills.size(), OperationResult<void>::Success());
+    if (!TouchUser(user_id)) {
+        std::fill(results.begin(), results.end(), LoadUserFailure());
+        return results;
+    }
+
+    // 一次取当前时间和预算，逐行验证；通过的账单移入 accepted
+    const auto latest = std::chrono::system_clock::now() + std::chrono::hours(24);
+    const auto budget = budget_manager_.GetBudget(user_id);
+    std::vector<Bill> accepted;
+    std::vector<size_t> accepted_rows;
+    accepted.reserve(bills.size());
+    accepted_rows.reserve(bills.size());
+    for (size_t row = 0; row < bills.size(); ++row) {
+        auto validation = ValidateBillAt(bills[row], latest);
+        if (!validation.IsSuccess()) {
+            results[row] = validation;
+            continue;
+        }
+        if (budget && !BudgetManager::CheckLimit(*budget, bills[row])) {
+            results[row] = OperationResult<void>::Failure(
+                ErrorCode::BudgetExceeded,
+                "添加该账单将超过预算限制"
+            );
+            continue;
+        }
+        accepted.push_back(std::move(bills[row]));
+        accepted_rows.push_back(row);
+    }
+
+    const auto added = bill_manager_.AddBills(user_id, accepted);
+    for (size_t i = 0; i < added.size(); ++i) {
+        if (!added[i]) {
+            results[accepted_rows[i]] = OperationResult<void>::Failure(
+                ErrorCode::StorageError,
+                "账单添加失败，请重试"
+            );
+        }
+    }
+
+    return results;
+}
+
 OperationResult<void> AccountManager::UpdateBillEx(int user_id, const Bill& bill) {
+    if (!TouchUser(user_id)) return LoadUserFailure();
     // 验证账单
     auto validation = ValidateBill(bill);
     if (!validation.IsSuccess()) {
@@ -222,11 +426,11 @@ OperationResult<void> AccountManager::UpdateBillEx(int user_id, const Bill& bill
         );
     }
 
-    report_manager_->ClearReports(user_id);
     return OperationResult<void>::Success();
 }
 
 OperationResult<void> AccountManager::DeleteBillEx(int user_id, int bill_id) {
+    if (!TouchUser(user_id)) return LoadUserFailure();
     if (!bill_manager_.DeleteBill(user_id, bill_id)) {
         return OperationResult<void>::Failure(
             ErrorCode::BillNotFound,
@@ -234,7 +438,6 @@ OperationResult<void> AccountManager::DeleteBillEx(int user_id, int bill_id) {
         );
     }
 
-    report_manager_->ClearReports(user_id);
     return OperationResult<void>::Success();
 }
 
@@ -242,6 +445,7 @@ OperationResult<void> AccountManager::DeleteBillEx(int user_id, int bill_id) {
 
 OperationResult<void> AccountManager::AddCategoryEx(const User& user,
                                                     const Category& category) {
+    if (!TouchUser(user.GetUserId())) return LoadUserFailure();
     // 验证分类
     auto validation = ValidateCategory(user, category);
     if (!validation.IsSuccess()) {
@@ -264,6 +468,7 @@ OperationResult<void> AccountManager::AddCategoryEx(const User& user,
 
 OperationResult<void> AccountManager::UpdateCategoryEx(const User& user,
                                                        const Category& category) {
+    if (!TouchUser(user.GetUserId())) return LoadUserFailure();
     // 验证分类
     auto validation = ValidateCategory(user, category);
     if (!validation.IsSuccess()) {
@@ -280,18 +485,21 @@ OperationResult<void> AccountManager::UpdateCategoryEx(const User& user,
             "分类不存在或更新失败"
         );
     }
+    report_manager_->ClearReports(user.GetUserId());  // 报表中的分类名称与类型可能变化
 
     return OperationResult<void>::Success();
 }
 
 OperationResult<void> AccountManager::DeleteCategoryEx(const User& user,
                                                        int category_id) {
+    if (!TouchUser(user.GetUserId())) return LoadUserFailure();
     if (!category_manager_.DeleteCategory(user, category_id)) {
         return OperationResult<void>::Failure(
             ErrorCode::CategoryNotFound,
             "分类不存在或删除失败"
         );
     }
+    report_manager_->ClearReports(user.GetUserId());
 
     return OperationResult<void>::Success();
 }
@@ -299,6 +507,7 @@ OperationResult<void> AccountManager::DeleteCategoryEx(const User& user,
 // ========== 第一阶段：带错误处理的预算操作 ==========
 
 OperationResult<void> AccountManager::SetBudgetEx(int user_id, const Budget& budget) {
+    if (!TouchUser(user_id)) return LoadUserFailure();
     // 验证预算
     auto validation = ValidateBudget(budget);
     if (!validation.IsSuccess()) {
@@ -371,42 +580,8 @@ OperationResult<void> AccountManager::ValidateUserInput(const std::string& usern
 }
 
 OperationResult<void> AccountManager::ValidateBill(const Bill& bill) const {
-    // 验证金额
-    if (bill.GetAmount() <= 0) {
-        return OperationResult<void>::Failure(
-            ErrorCode::InvalidBill,
-            "账单金额必须大于 0"
-        );
-    }
-
-    if (bill.GetAmount() > 1000000) {  // 上限为 100 万
-        return OperationResult<void>::Failure(
-            ErrorCode::InvalidBill,
-            "账单金额不能超过 1000000"
-        );
-    }
-
-    // 验证时间（使用 time_point，不依赖字符串格式）
-    // 这里简单检查时间是否合理：不早于 1970-01-01，且不晚于当前时间 + 1 天
-    auto tp = bill.GetTime();
-    auto now = std::chrono::system_clock::now();
-    auto earliest = std::chrono::system_clock::from_time_t(0);
-    if (tp < earliest || tp > now + std::chrono::hours(24)) {
-        return OperationResult<void>::Failure(
-            ErrorCode::InvalidBill,
-            "账单时间不合理"
-        );
-    }
-
-    // 验证描述（content）
-    if (bill.GetContent().length() > 256) {
-        return OperationResult<void>::Failure(
-            ErrorCode::InvalidBill,
-            "描述长度不能超过 256 个字符"
-        );
-    }
-
-    return OperationResult<void>::Success();
+    // 不晚于当前时间 + 1 天
+    return ValidateBillAt(bill, std::chrono::system_clock::now() + std::chrono::hours(24));
 }
 
 OperationResult<void> AccountManager::ValidateCategory(const User& user,
@@ -487,41 +662,20 @@ std::vector<Bill> AccountManager::GetBillsByDateRange(
         return {};
     }
 
-    // 获取所有账单
-    auto all_bills = GetBills(user_id);
-
-    // 按日期范围过滤（比较 time_point）
-    std::vector<Bill> result;
-    for (const auto& bill : all_bills) {
-        auto bill_tp = bill.GetTime();
-        if (bill_tp >= tp_start && bill_tp <= tp_end) {
-            result.push_back(bill);
-        }
-    }
+    // 按时间索引取日期范围内的账单
+    std::vector<Bill> result = bill_manager_.GetBillsInTimeRange(user_id, tp_start, tp_end);
 
     return result;
 }
 
 std::vector<Bill> AccountManager::GetBillsByCategory(int user_id, int category_id) const {
-    auto all_bills = GetBills(user_id);
-    
-    std::vector<Bill> result;
-    for (const auto& bill : all_bills) {
-        if (bill.GetCategoryId() == category_id) {
-            result.push_back(bill);
-        }
-    }
-
-    return result;
+    // 分类索引只访问该分类的账单
+    return bill_manager_.GetBillsByCategory(user_id, category_id);
 }
 
 std::vector<Bill> AccountManager::GetBillsByCategoryAndDate(
     int user_id, int category_id, const std::string& start_date,
     const std::string& end_date) const {
-    // 先按分类过滤
-    auto bills_by_category = GetBillsByCategory(user_id, category_id);
-
-    // 再按日期范围过滤
     if (!IsValidDateFormat(start_date) || !IsValidDateFormat(end_date)) {
         return {};
     }
@@ -530,7 +684,6 @@ std::vector<Bill> AccountManager::GetBillsByCategoryAndDate(
         return {};
     }
 
-    std::vector<Bill> result;
     // 解析起止日期为 time_point
     std::chrono::system_clock::time_point tp_start, tp_end;
     if (!ParseDateStringToTimePoint(start_date, tp_start) ||
@@ -538,14 +691,8 @@ std::vector<Bill> AccountManager::GetBillsByCategoryAndDate(
         return {};
     }
 
-    for (const auto& bill : bills_by_category) {
-        auto bill_tp = bill.GetTime();
-        if (bill_tp >= tp_start && bill_tp <= tp_end) {
-            result.push_back(bill);
-        }
-    }
-
-    return result;
+    // 在该分类的时间索引上二分定位日期范围
+    return bill_manager_.GetBillsByCategoryInTimeRange(user_id, category_id, tp_start, tp_end);
 }
 
 PagedResult<Bill> AccountManager::GetBillsPaged(int user_id, int page_number,
@@ -554,8 +701,8 @@ PagedResult<Bill> AccountManager::GetBillsPaged(int user_id, int page_number,
     result.page_number = page_number;
     result.page_size = page_size;
 
-    auto all_bills = GetBills(user_id);
-    result.total_count = all_bills.size();
+    // 只取总数，不构造全部账单
+    result.total_count = static_cast<int>(bill_manager_.CountBills(user_id));
     result.CalculateTotalPages();
 
     // 验证页码
@@ -563,38 +710,87 @@ PagedResult<Bill> AccountManager::GetBillsPaged(int user_id, int page_number,
         return result;  // 返回空结果
     }
 
-    // 计算起始和结束索引
-    int start_idx = (page_number - 1) * page_size;
-    int end_idx = std::min(start_idx + page_size, (int)all_bills.size());
-
-    result.items.assign(all_bills.begin() + start_idx, all_bills.begin() + end_idx);
+    // 只构造当前页的账单
+    size_t start_idx = static_cast<size_t>(page_number - 1) * page_size;
+    result.items = bill_manager_.GetBillsByUser(user_id, start_idx, page_size);
 
     return result;
 }
 
+CursorPage<Bill> AccountManager::GetBillsAfter(int user_id, const BillCursor& cursor,
+                                               int page_size) const {
+    CursorPage<Bill> page;
+    page.next_cursor = cursor;
+    if (page_size < 1) return page;
+
+    // 多取一个用于判断是否还有下一页
+    page.items = bill_manager_.GetBillsAfter(user_id, cursor.time, cursor.bill_id,
+                                             static_cast<size_t>(page_size) + 1);
+    if (page.items.size() > static_cast<size_t>(page_size)) {
+        page.items.pop_back();
+        page.has_more = true;
+    }
+    if (!page.items.empty()) {
+        page.next_cursor.time = page.items.back().GetTime();
+        page.next_cursor.bill_id = page.items.back().GetBillId();
+    }
+    return page;
+}
+
 double AccountManager::GetTotalExpenseByCategory(
     int user_id, int category_id, const std::string& start_date,
     const std::string& end_date) const {
-    auto bills = GetBillsByCategoryAndDate(user_id, category_id, start_date, end_date);
+    if (!IsValidDateFormat(start_date) || !IsValidDateFormat(end_date)) {
+        return 0.0;
+    }
 
-    double total = 0.0;
-    for (const auto& bill : bills) {
-        total += bill.GetAmount();
+    if (!IsDateLessOrEqual(start_date, end_date)) {
+        return 0.0;
+    }
+
+    std::chrono::system_clock::time_point tp_start, tp_end;
+    if (!ParseDateStringToTimePoint(start_date, tp_start) ||
+        !ParseDateStringToTimePoint(end_date, tp_end)) {
+        return 0.0;
     }
 
-    return total;
+    // 区间同 GetBillsByCategoryAndDate（到结束日期 0 点为止）：结束日期之前的整天由按日汇总
+    // 和前缀和得出，恰好在结束日期 0 点的账单经分类索引补上
+    Money total = bill_manager_
+                      .SumCategoryInDays(user_id, category_id,
+                                         time_utils::LocalDayNumber(tp_start),
+                                         time_utils::LocalDayNumber(tp_end) - 1)
+                      .total;
+    bill_manager_.ForEachBillInCategory(user_id, category_id, tp_end, tp_end,
+                                        [&total](const BillView& bill) { total += bill.amount; });
+    return total.ToDouble();
 }
 
 double AccountManager::GetTotalExpense(int user_id, const std::string& start_date,
                                       const std::string& end_date) const {
-    auto bills = GetBillsByDateRange(user_id, start_date, end_date);
+    if (!IsValidDateFormat(start_date) || !IsValidDateFormat(end_date)) {
+        return 0.0;
+    }
 
-    double total = 0.0;
-    for (const auto& bill : bills) {
-        total += bill.GetAmount();
+    if (!IsDateLessOrEqual(start_date, end_date)) {
+        return 0.0;
     }
 
-    return total;
+    std::chrono::system_clock::time_point tp_start, tp_end;
+    if (!ParseDateStringToTimePoint(start_date, tp_start) ||
+        !ParseDateStringToTimePoint(end_date, tp_end)) {
+        return 0.0;
+    }
+
+    // 区间同 GetBillsByDateRange：结束日期之前的整天每个分类两次二分，
+    // 恰好在结束日期 0 点的账单经时间索引补上
+    Money total = bill_manager_
+                      .SumInDays(user_id, time_utils::LocalDayNumber(tp_start),
+                                 time_utils::LocalDayNumber(tp_end) - 1)
+                      .total;
+    bill_manager_.ForEachBillInTimeRange(user_id, tp_end, tp_end,
+                                         [&total](const BillView& bill) { total += bill.amount; });
+    return total.ToDouble();
 }
 
 // ========== 第四阶段：预算分析接口 ==========
@@ -612,10 +808,7 @@ BudgetStatus AccountManager::GetBudgetStatus(int user_id) const {
     status.total_budget = budget->GetTotalLimit();
 
     // 计算已使用金额（当月？还是全部？为简化起见，这里使用全部）
-    auto bills = GetBills(user_id);
-    for (const auto& bill : bills) {
-        status.used_amount += bill.GetAmount();
-    }
+    status.used_amount = bill_manager_.SumAmount(user_id).ToDouble();
 
     status.remaining_budget = status.total_budget - status.used_amount;
     status.is_exceeded = status.remaining_budget < 0;
@@ -647,10 +840,10 @@ std::vector<CategoryBudgetStatus> AccountManager::GetCategoryBudgetStatus(
         cat_status.limit_set = true;
 
         // 计算该分类的使用金额
-        auto bills_in_category = GetBillsByCategory(user_id, category_id);
-        for (const auto& bill : bills_in_category) {
-            cat_status.used += bill.GetAmount();
-        }
+        Money used;
+        bill_manager_.ForEachBillInCategory(
+            user_id, category_id, [&used](const BillView& bill) { used += bill.amount; });
+        cat_status.used = used.ToDouble();
 
         cat_status.remaining = limit - cat_status.used;
         cat_status.is_exceeded = cat_status.remaining < 0;
@@ -684,19 +877,14 @@ BudgetImpact AccountManager::GetBudgetImpactIfAddBill(int user_id,
     impact.would_exceed_total = impact.remaining_total_after_add < 0;
 
     // 获取分类预算状态
-    const auto& limits = budget->GetCategoryLimits();
-    auto it = limits.find(bill.GetCategoryId());
-    if (it != limits.end()) {
-        double category_limit = it->second;
-        auto bills_in_category = GetBillsByCategory(user_id, bill.GetCategoryId());
-
-        double used = 0.0;
-        for (const auto& b : bills_in_category) {
-            used += b.GetAmount();
-        }
-
-        impact.current_remaining_category = category_limit - used;
-        impact.remaining_category_after_add = category_limit - (used + bill.GetAmount());
+    if (budget->HasCategoryLimit(bill.GetCategoryId())) {
+        const Money category_limit = budget->GetCategoryLimitMoney(bill.GetCategoryId());
+        Money used;
+        bill_manager_.ForEachBillInCategory(
+            user_id, bill.GetCategoryId(), [&used](const BillView& b) { used += b.amount; });
+
+        impact.current_remaining_category = (category_limit - used).ToDouble();
+        impact.remaining_category_after_add = (category_limit - used - bill.GetMoney()).ToDouble();
         impact.would_exceed_category = impact.remaining_category_after_add < 0;
     }
 
@@ -758,22 +946,10 @@ bool AccountManager::ParseDateStringToTimePoint(const std::string& date_str,
                                                std::chrono::system_clock::time_point& out) const {
     if (!IsValidDateFormat(date_str)) return false;
 
-    int year = std::stoi(date_str.substr(0, 4));
-    int month = std::stoi(date_str.substr(5, 2));
-    int day = std::stoi(date_str.substr(8, 2));
-
-    std::tm tm{};
-    tm.tm_year = year - 1900;
-    tm.tm_mon = month - 1;
-    tm.tm_mday = day;
-    tm.tm_hour = 0;
-    tm.tm_min = 0;
-    tm.tm_sec = 0;
-
-    std::time_t tt = std::mktime(&tm);
-    if (tt == -1) return false;
+    time_utils::CivilTime local;
+    if (!time_utils::ParseDateTime(date_str.data(), date_str.size(), local)) return false;
 
-    out = std::chrono::system_clock::from_time_t(tt);
+    out = time_utils::LocalToTimePoint(local);
     return true;
 }
 
@@ -782,26 +958,13 @@ bool AccountManager::ParseDateTimeStringToTimePoint(const std::string& date_str,
                                                     std::chrono::system_clock::time_point& out) const {
     if (!IsValidDateFormat(date_str)) return false;
 
-    int year = std::stoi(date_str.substr(0, 4));
-    int month = std::stoi(date_str.substr(5, 2));
-    int day = std::stoi(date_str.substr(8, 2));
+    time_utils::CivilTime local;
+    if (!time_utils::ParseDateTime(date_str.data(), date_str.size(), local)) return false;
 
-    int hour = 0, min = 0, sec = 0;
     // parse time_str like HH:MM or HH:MM:SS
-    std::sscanf(time_str.c_str(), "%d:%d:%d", &hour, &min, &sec);
+    std::sscanf(time_str.c_str(), "%d:%d:%d", &local.hour, &local.minute, &local.second);
 
-    std::tm tm{};
-    tm.tm_year = year - 1900;
-    tm.tm_mon = month - 1;
-    tm.tm_mday = day;
-    tm.tm_hour = hour;
-    tm.tm_min = min;
-    tm.tm_sec = sec;
-
-    std::time_t tt = std::mktime(&tm);
-    if (tt == -1) return false;
-
-    out = std::chrono::system_clock::from_time_t(tt);
+    out = time_utils::LocalToTimePoint(local);
     return true;
 }
 
@@ -809,21 +972,23 @@ std::pair<double, double> AccountManager::GetDailySummary(int user_id, const std
     std::pair<double,double> res{0.0, 0.0};
     std::chrono::system_clock::time_point tp_start;
     if (!ParseDateStringToTimePoint(date_str, tp_start)) return res;
-    auto tp_end = tp_start + std::chrono::hours(24);
-
-    auto bills = GetBills(user_id);
-    for (const auto& bill : bills) {
-        auto t = bill.GetTime();
-        if (t >= tp_start && t < tp_end) {
-            auto cat = bill.GetCategory();
-            if (cat && cat->GetType() == "income") {
-                res.first += bill.GetAmount();
+    const int64_t day = time_utils::LocalDayNumber(tp_start);
+
+    // 当天各分类的合计取自按日汇总
+    Money income, expense;
+    bill_manager_.ForEachCategoryTotalInDays(
+        user_id, day, day,
+        [&income, &expense](int, const Category* category,
+                            const BillManager::CategoryTotal& total) {
+            if (category && category->GetType() == "income") {
+                income += total.total;
             } else {
-                res.second += bill.GetAmount();
+                expense += total.total;
             }
-        }
-    }
+        });
 
+    res.first = income.ToDouble();
+    res.second = expense.ToDouble();
     return res;
 }
 
@@ -0,0 +1,199 @@
+#include "managers/bill_columns.h"
+#include <algorithm>
+#include <unordered_set>
+
+namespace accounting {
+
+static constexpr size_t kMinCompactBytes = 4096;
+
+// ===== BillView =====
+BillView BillView::FromBill(const Bill& bill) {
+    BillView view;
+    view.bill_id = bill.GetBillId();
+    view.amount = bill.GetMoney();
+    view.time = bill.GetTime();
+    view.category_id = bill.GetCategoryId();
+    view.content = bill.GetContent();
+    view.category = bill.GetCategory().get();
+    if (bill.GetCategory()) view.shared_category = &bill.GetCategory();
+    return view;
+}
+
+QueryRow BillView::ToQueryRow() const {
+    QueryRow row;
+    row.bill_id = bill_id;
+    row.amount = amount;
+    row.time = time;
+    row.category_id = category_id;
+    if (category) {
+        row.category_name = category->GetName();
+        row.category_type = category->GetType();
+    }
+    row.content = content;
+    return row;
+}
+
+Bill BillView::ToBill() const {
+    Bill bill(bill_id, 0.0, shared_category ? *shared_category : nullptr, time,
+              std::string(content));
+    bill.SetMoney(amount);
+    bill.SetCategoryId(category_id);
+    return bill;
+}
+
+BillColumns::BillColumns(const std::vector<Bill>& bills) {
+    size_t content_bytes = 0;
+    for (const auto& bill : bills) content_bytes += bill.GetContent().size();
+    Reserve(bills.size(), content_bytes);
+    for (const auto& bill : bills) Append(bill);
+}
+
+void BillColumns::Reserve(size_t rows, size_t content_bytes) {
+    bill_id_.reserve(rows);
+    amount_.reserve(rows);
+    time_.reserve(rows);
+    category_id_.reserve(rows);
+    content_offset_.reserve(rows);
+    content_length_.reserve(rows);
+    content_.reserve(content_bytes);
+}
+
+std::string_view BillColumns::Content(size_t row) const {
+    return std::string_view(content_.data() + content_offset_[row], content_length_[row]);
+}
+
+std::shared_ptr<const Category> BillColumns::GetCategory(int category_id) const {
+    auto it = categories_.find(category_id);
+    return it != categories_.end() ? it->second : nullptr;
+}
+
+const Category* BillColumns::FindCategory(int category_id) const {
+    auto it = categories_.find(category_id);
+    return it != categories_.end() ? it->second.get() : nullptr;
+}
+
+const std::shared_ptr<const Category>* BillColumns::FindSharedCategory(int category_id) const {
+    auto it = categories_.find(category_id);
+    return it != categories_.end() && it->second ? &it->second : nullptr;
+}
+
+// ===== 行操作 =====
+void BillColumns::Append(const Bill& bill) {
+    bill_id_.push_back(bill.GetBillId());
+    amount_.push_back(bill.GetMoney().Cents());
+    time_.push_back(bill.GetTime());
+    category_id_.push_back(bill.GetCategoryId());
+    content_offset_.push_back(0);
+    content_length_.push_back(0);
+    StoreContent(bill_id_.size() - 1, bill.GetContent());
+    RememberCategory(bill);
+}
+
+void BillColumns::Assign(size_t row, const Bill& bill) {
+    bill_id_[row] = bill.GetBillId();
+    amount_[row] = bill.GetMoney().Cents();
+    time_[row] = bill.GetTime();
+    category_id_[row] = bill.GetCategoryId();
+    if (Content(row) != bill.GetContent()) {
+        dead_content_bytes_ += content_length_[row];
+        StoreContent(row, bill.GetContent());
+        MaybeCompactContent();
+    }
+    RememberCategory(bill);
+}
+
+void BillColumns::SwapRemove(size_t row) {
+    dead_content_bytes_ += content_length_[row];
+    const size_t last = bill_id_.size() - 1;
+    if (row != last) {
+        bill_id_[row] = bill_id_[last];
+        amount_[row] = amount_[last];
+        time_[row] = time_[last];
+        category_id_[row] = category_id_[last];
+        content_offset_[row] = content_offset_[last];
+        content_length_[row] = content_length_[last];
+    }
+    bill_id_.pop_back();
+    amount_.pop_back();
+    time_.pop_back();
+    category_id_.pop_back();
+    content_offset_.pop_back();
+    content_length_.pop_back();
+    MaybeCompactContent();
+}
+
+Bill BillColumns::Materialize(size_t row) const {
+    const int category_id = category_id_[row];
+    Bill bill(bill_id_[row], 0.0, GetCategory(category_id), time_[row],
+              std::string(Content(row)));
+    bill.SetMoney(Money::FromCents(amount_[row]));
+    bill.SetCategoryId(category_id);
+    return bill;
+}
+
+BillView BillColumns::View(size_t row) const {
+    BillView view;
+    view.bill_id = bill_id_[row];
+    view.amount = Money::FromCents(amount_[row]);
+    view.time = time_[row];
+    view.category_id = category_id_[row];
+    view.content = Content(row);
+    view.shared_category = FindSharedCategory(category_id_[row]);
+    view.category = view.shared_category ? view.shared_category->get() : nullptr;
+    return view;
+}
+
+std::vector<Bill> BillColumns::MaterializeAll() const {
+    std::vector<Bill> bills;
+    bills.reserve(Size());
+    for (size_t row = 0; row < Size(); ++row) bills.push_back(Materialize(row));
+    return bills;
+}
+
+// ===== 分类指针 =====
+void BillColumns::SetCategory(int category_id, std::shared_ptr<const Category> category) {
+    if (category) {
+        categories_[category_id] = std::move(category);
+    } else {
+        categories_.erase(category_id);
+    }
+}
+
+std::vector<int> BillColumns::DistinctCategoryIds() const {
+    std::unordered_set<int> seen(category_id_.begin(), category_id_.end());
+    std::vector<int> ids(seen.begin(), seen.end());
+    std::sort(ids.begin(), ids.end());
+    return ids;
+}
+
+void BillColumns::RememberCategory(const Bill& bill) {
+    // 只记录与行上分类 id 一致的指针；同一分类 id 以最后写入的为准
+    auto category = bill.GetCategory();
+    if (category && category->GetCategoryId() == bill.GetCategoryId()) {
+        categories_[bill.GetCategoryId()] = std::move(category);
+    }
+}
+
+// ===== 文本区 =====
+void BillColumns::StoreContent(size_t row, const std::string& content) {
+    content_offset_[row] = content_.size();
+    content_length_[row] = content.size();
+    content_.append(content);
+}
+
+void BillColumns::MaybeCompactContent() {
+    if (dead_content_bytes_ < kMinCompactBytes || dead_content_bytes_ * 2 < content_.size()) {
+        return;
+    }
+    std::string compacted;
+    compacted.reserve(content_.size() - dead_content_bytes_);
+    for (size_t row = 0; row < Size(); ++row) {
+        const size_t offset = compacted.size();
+        compacted.append(content_, content_offset_[row], content_length_[row]);
+        content_offset_[row] = offset;
+    }
+    content_ = std::move(compacted);
+    dead_content_bytes_ = 0;
+}
+
+}  // namespace accounting
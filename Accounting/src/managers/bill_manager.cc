@@ -1,14 +1,22 @@
 #include "managers/bill_manager.h"
 #include "managers/category_manager.h"
 #include "models/user.h"
+#include "utils/money_sum.h"
+#include "utils/parallel.h"
 #include <algorithm>
+#include <iterator>
+#include <limits>
+#include <tuple>
 #include <iostream>
 
 namespace accounting {
 
 // ========================== 添加账单 ==========================
 bool BillManager::AddBill(int user_id, Bill bill) {
-    auto& bills = bills_[user_id];
+    auto* user_bills = MutableUserBills(user_id, true);
+    if (!user_bills) return false;
+    auto& columns = *user_bills;
+    auto& slots = SlotsFor(user_id, columns);
 
     // 初始化 ID 生成器
     if (next_bill_id_.find(user_id) == next_bill_id_.end()) {
@@ -19,127 +27,1185 @@ bool BillManager::AddBill(int user_id, Bill bill) {
     if (bill.GetBillId() == 0) {
         bill.SetBillId(next_bill_id_[user_id]++);
     } else {
-        for (const auto& b : bills) {
-            if (b.GetBillId() == bill.GetBillId()) {
-                std::cerr << "[BillManager] Duplicate bill_id for user "
-                          << user_id << ": " << bill.GetBillId() << std::endl;
-                return false;
-            }
+        if (slots.count(bill.GetBillId())) {
+            std::cerr << "[BillManager] Duplicate bill_id for user "
+                      << user_id << ": " << bill.GetBillId() << std::endl;
+            return false;
         }
         next_bill_id_[user_id] = std::max(next_bill_id_[user_id], bill.GetBillId() + 1);
     }
 
-    bills.push_back(std::move(bill));
+    if (bill_log_) {
+        BillLogRecord record;
+        record.op = BillLogRecord::Op::kAdd;
+        record.user_id = user_id;
+        record.bill = bill;
+        record.bill_id = bill.GetBillId();
+        if (!AppendLog(record)) return false;
+    }
+
+    slots[bill.GetBillId()] = columns.Size();
+    IndexRow(user_id, {bill.GetTime(), bill.GetBillId()}, bill.GetCategoryId());
+    RollupAdd(user_id, bill);
+    columns.Append(bill);
+    ShareCategory(user_id, columns, bill.GetCategoryId());
+    MarkChanged(user_id);
+    MaybeCheckpoint();
     return true;
 }
 
+std::vector<bool> BillManager::AddBills(int user_id, std::vector<Bill>& bills) {
+    std::vector<bool> added(bills.size(), false);
+    if (bills.empty()) return added;
+    auto* user_bills = MutableUserBills(user_id, true);
+    if (!user_bills) return added;
+    auto& columns = *user_bills;
+    auto& slots = SlotsFor(user_id, columns);
+
+    size_t content_bytes = 0;
+    for (const auto& bill : bills) content_bytes += bill.GetContent().size();
+    columns.Reserve(columns.Size() + bills.size(), columns.ContentBytes() + content_bytes);
+    slots.reserve(slots.size() + bills.size());
+
+    int& next_id = next_bill_id_.try_emplace(user_id, 1).first->second;
+    std::vector<std::pair<TimeKey, int>> keys;
+    keys.reserve(bills.size());
+    std::set<int> categories;
+    for (size_t i = 0; i < bills.size(); ++i) {
+        Bill& bill = bills[i];
+        if (bill.GetBillId() == 0) {
+            bill.SetBillId(next_id++);
+        } else if (slots.count(bill.GetBillId())) {
+            std::cerr << "[BillManager] Duplicate bill_id for user "
+                      << user_id << ": " << bill.GetBillId() << std::endl;
+            continue;
+        } else {
+            next_id = std::max(next_id, bill.GetBillId() + 1);
+        }
+
+        if (bill_log_) {
+            BillLogRecord record;
+            record.op = BillLogRecord::Op::kAdd;
+            record.user_id = user_id;
+            record.bill = bill;
+            record.bill_id = bill.GetBillId();
+            if (!AppendLog(record)) continue;
+        }
+
+        slots[bill.GetBillId()] = columns.Size();
+        keys.emplace_back(TimeKey{bill.GetTime(), bill.GetBillId()}, bill.GetCategoryId());
+        categories.insert(bill.GetCategoryId());
+        RollupAdd(user_id, bill);
+        columns.Append(bill);
+        added[i] = true;
+    }
+    if (keys.empty()) return added;
+
+    IndexRows(user_id, std::move(keys));
+    for (int category_id : categories) ShareCategory(user_id, columns, category_id);
+    MarkChanged(user_id);
+    MaybeCheckpoint();
+    return added;
+}
+
 // ========================== 更新账单 ==========================
 bool BillManager::UpdateBill(int user_id, const Bill& updated_bill) {
-    auto it = bills_.find(user_id);
-    if (it == bills_.end()) return false;
+    auto* user_bills = MutableUserBills(user_id, false);
+    if (!user_bills) return false;
+    auto& columns = *user_bills;
 
-    for (auto& bill : it->second) {
-        if (bill.GetBillId() == updated_bill.GetBillId()) {
-            bill = updated_bill;
-            return true;
-        }
+    const auto& slots = SlotsFor(user_id, columns);
+    auto slot = slots.find(updated_bill.GetBillId());
+    if (slot == slots.end()) return false;
+
+    if (bill_log_) {
+        BillLogRecord record;
+        record.op = BillLogRecord::Op::kUpdate;
+        record.user_id = user_id;
+        record.bill = updated_bill;
+        record.bill_id = updated_bill.GetBillId();
+        if (!AppendLog(record)) return false;
     }
-    return false;
+    const size_t row = slot->second;
+    const auto old_time = columns.Times()[row];
+    const int old_category_id = columns.CategoryIds()[row];
+    if (old_time != updated_bill.GetTime() || old_category_id != updated_bill.GetCategoryId()) {
+        UnindexRow(user_id, {old_time, updated_bill.GetBillId()}, old_category_id);
+        IndexRow(user_id, {updated_bill.GetTime(), updated_bill.GetBillId()},
+                 updated_bill.GetCategoryId());
+    }
+    RollupRemove(user_id, columns, row);
+    RollupAdd(user_id, updated_bill);
+    columns.Assign(row, updated_bill);
+    ShareCategory(user_id, columns, updated_bill.GetCategoryId());
+    MarkChanged(user_id);
+    MaybeCheckpoint();
+    return true;
 }
 
 // ========================== 删除账单 ==========================
 bool BillManager::DeleteBill(int user_id, int bill_id) {
-    auto it = bills_.find(user_id);
-    if (it == bills_.end()) return false;
+    auto* user_bills = MutableUserBills(user_id, false);
+    if (!user_bills) return false;
+
+    auto& columns = *user_bills;
+    auto& slots = SlotsFor(user_id, columns);
+    auto slot = slots.find(bill_id);
+    if (slot == slots.end()) return false;
+
+    if (bill_log_) {
+        BillLogRecord record;
+        record.op = BillLogRecord::Op::kDelete;
+        record.user_id = user_id;
+        record.bill_id = bill_id;
+        if (!AppendLog(record)) return false;
+    }
+
+    // 用最后一个账单填补空位，不移动中间的元素（账单顺序因此会改变）
+    const size_t row = slot->second;
+    slots.erase(slot);
+    UnindexRow(user_id, {columns.Times()[row], bill_id}, columns.CategoryIds()[row]);
+    RollupRemove(user_id, columns, row);
+    columns.SwapRemove(row);
+    if (row < columns.Size()) slots[columns.BillIds()[row]] = row;
+    MarkChanged(user_id);
+    MaybeCheckpoint();
+    return true;
+}
 
-    auto& vec = it->second;
-    auto old_size = vec.size();
-    vec.erase(std::remove_if(vec.begin(), vec.end(),
-                             [bill_id](const Bill& b) {
-                                 return b.GetBillId() == bill_id;
-                             }),
-              vec.end());
-    return vec.size() != old_size;
+void BillManager::MarkChanged(int user_id) {
+    dirty_users_.insert(user_id);
+    data_versions_[user_id] = ++version_counter_;
+}
+
+uint64_t BillManager::DataVersion(int user_id) const {
+    auto it = data_versions_.find(user_id);
+    return it != data_versions_.end() ? it->second : base_version_;
 }
 
 // ========================== 获取账单 ==========================
 std::vector<Bill> BillManager::GetBillsByUser(int user_id) const {
     auto it = bills_.find(user_id);
-    if (it != bills_.end()) return it->second;
+    if (it != bills_.end()) return it->second.MaterializeAll();
+    return LoadUncachedBills(user_id);
+}
+
+std::vector<Bill> BillManager::LoadUncachedBills(int user_id) const {
+    // 未修改过的用户直接从快照读取；按用户加载模式下未加载的用户临时从存储读取，不常驻
+    std::vector<Bill> bills;
+    if (base_ && base_->MaterializeUser(user_id, bills)) {
+        RestoreCategories(user_id, bills);
+        return bills;
+    }
+    if (lazy_source_) {
+        auto res = lazy_source_->LoadBillsForUser(user_id);
+        if (!res.first) return {};
+        RestoreCategories(user_id, res.second);
+        return res.second;
+    }
     return {};
 }
 
+size_t BillManager::CountBills(int user_id) const {
+    auto it = bills_.find(user_id);
+    if (it != bills_.end()) return it->second.Size();
+    // 快照中的用户直接读取行数，不构造账单
+    if (base_) {
+        if (const auto* columns = base_->FindUser(user_id)) return columns->count;
+    }
+    return lazy_source_ ? LoadUncachedBills(user_id).size() : 0;
+}
+
+std::vector<Bill> BillManager::GetBillsByUser(int user_id, size_t offset, size_t limit) const {
+    std::vector<Bill> results;
+    auto it = bills_.find(user_id);
+    if (it == bills_.end()) {
+        auto bills = LoadUncachedBills(user_id);
+        if (offset >= bills.size()) return results;
+        const size_t end = offset + std::min(limit, bills.size() - offset);
+        results.assign(std::make_move_iterator(bills.begin() + offset),
+                       std::make_move_iterator(bills.begin() + end));
+        return results;
+    }
+    const BillColumns& columns = it->second;
+    if (offset >= columns.Size()) return results;
+    const size_t end = offset + std::min(limit, columns.Size() - offset);
+    results.reserve(end - offset);
+    for (size_t row = offset; row < end; ++row) results.push_back(columns.Materialize(row));
+    return results;
+}
+
+std::vector<Bill> BillManager::GetBillsAfter(int user_id,
+                                             const std::chrono::system_clock::time_point& after_time,
+                                             int after_bill_id, size_t limit) const {
+    std::vector<Bill> results;
+    if (limit == 0) return results;
+    const TimeKey after{after_time, after_bill_id};
+    auto it = bills_.find(user_id);
+    if (it == bills_.end()) {
+        // 快照中或未加载的用户没有索引，取时间范围后跳过不晚于游标的账单
+        for (auto& bill : GetBillsInTimeRange(user_id, after_time,
+                                              std::chrono::system_clock::time_point::max())) {
+            if (!(after < TimeKey{bill.GetTime(), bill.GetBillId()})) continue;
+            results.push_back(std::move(bill));
+            if (results.size() == limit) break;
+        }
+        return results;
+    }
+    const BillColumns& columns = it->second;
+    const TimeIndex& index = TimeIndexFor(user_id, columns);
+    const BillSlots& slots = SlotsFor(user_id, columns);
+    auto first = std::upper_bound(index.begin(), index.end(), after);
+    const size_t count = std::min(limit, static_cast<size_t>(index.end() - first));
+    results.reserve(count);
+    for (auto key = first; key != first + count; ++key) {
+        results.push_back(columns.Materialize(slots.at(key->second)));
+    }
+    return results;
+}
+
 // ========================== 按条件查询 ==========================
+// 排序键：(排序字段, bill_id)；降序时只反转排序字段，同值仍按 bill_id 升序
+template<typename Row, typename KeyFn>
+static void SortAndLimit(std::vector<Row>& rows, const QueryCriteria& criteria, KeyFn&& key_of) {
+    const bool by_amount = criteria.GetSortField() == QueryCriteria::SortField::kAmount;
+    const bool descending = criteria.IsDescending();
+    auto less = [&](const Row& a, const Row& b) {
+        const QueryRow ka = key_of(a);
+        const QueryRow kb = key_of(b);
+        if (by_amount ? ka.amount != kb.amount : ka.time != kb.time) {
+            const bool a_first = by_amount ? ka.amount < kb.amount : ka.time < kb.time;
+            return descending ? !a_first : a_first;
+        }
+        return ka.bill_id < kb.bill_id;
+    };
+    const size_t limit = criteria.GetLimit();
+    if (limit > 0 && limit < rows.size()) {
+        std::partial_sort(rows.begin(), rows.begin() + limit, rows.end(), less);
+        rows.resize(limit);
+    } else {
+        std::sort(rows.begin(), rows.end(), less);
+    }
+}
+
+static void SortAndLimitBills(std::vector<Bill>& bills, const QueryCriteria& criteria) {
+    SortAndLimit(bills, criteria, [](const Bill& bill) {
+        QueryRow row;
+        row.bill_id = bill.GetBillId();
+        row.amount = bill.GetMoney();
+        row.time = bill.GetTime();
+        return row;
+    });
+}
+
+// 除时间范围外没有其他过滤条件
+static bool OnlyTimeFilter(const QueryCriteria& criteria) {
+    QueryCriteria without_time = criteria;
+    without_time.SetStartDate(std::chrono::system_clock::time_point::min());
+    without_time.SetEndDate(std::chrono::system_clock::time_point::max());
+    return !without_time.HasFilters();
+}
+
+BillManager::QueryPlan BillManager::MakeQueryPlan(int user_id, const BillColumns& columns,
+                                                  const QueryCriteria& criteria) const {
+    QueryPlan plan;
+    size_t best = columns.Size();  // 全表扫描的代价
+
+    // 分类名称需要 CategoryManager 才能解析为 id；有名称无法解析时不能走分类索引
+    if (criteria.HasCategoryFilter()) {
+        plan.category_ids = criteria.GetCategoryIds();
+        plan.category_ids_resolved = true;
+        User tmp_user;
+        tmp_user.SetUserId(user_id);
+        for (const auto& name : criteria.GetCategoryNames()) {
+            const Category* category =
+                category_manager_ ? category_manager_->GetCategoryByName(tmp_user, name) : nullptr;
+            if (!category) {
+                plan.category_ids_resolved = false;
+                break;
+            }
+            plan.category_ids.push_back(category->GetCategoryId());
+        }
+        std::sort(plan.category_ids.begin(), plan.category_ids.end());
+        plan.category_ids.erase(std::unique(plan.category_ids.begin(), plan.category_ids.end()),
+                                plan.category_ids.end());
+    }
+
+    if (criteria.HasBillIdFilter() && criteria.GetBillIds().size() < best) {
+        best = criteria.GetBillIds().size();
+        plan.path = QueryAccessPath::kBillId;
+    }
+    if (plan.category_ids_resolved) {
+        size_t rows = 0;
+        for (int category_id : plan.category_ids) {
+            auto range = KeysInTimeRange(CategoryTimeIndex(user_id, columns, category_id),
+                                         criteria.GetStartDate(), criteria.GetEndDate());
+            rows += static_cast<size_t>(range.second - range.first);
+        }
+        if (rows < best) {
+            best = rows;
+            plan.path = QueryAccessPath::kCategoryIndex;
+        }
+    }
+    // 时间索引：有时间范围，或按时间排序取前 limit 条且没有其他条件（可提前结束）
+    const bool time_top_k = criteria.GetSortField() == QueryCriteria::SortField::kTime &&
+                            criteria.GetLimit() > 0 && OnlyTimeFilter(criteria);
+    if (criteria.HasDateRange() || time_top_k) {
+        auto range = KeysInTimeRange(TimeIndexFor(user_id, columns), criteria.GetStartDate(),
+                                     criteria.GetEndDate());
+        size_t rows = static_cast<size_t>(range.second - range.first);
+        if (time_top_k) rows = std::min(rows, criteria.GetLimit());
+        if (rows < best) {
+            best = rows;
+            plan.path = QueryAccessPath::kTimeIndex;
+        }
+    }
+    return plan;
+}
+
+BillManager::QueryAccessPath BillManager::PlanQuery(int user_id,
+                                                    const QueryCriteria& criteria) const {
+    auto it = bills_.find(user_id);
+    if (it == bills_.end()) return QueryAccessPath::kScan;
+    return MakeQueryPlan(user_id, it->second, criteria).path;
+}
+
+std::vector<size_t> BillManager::SelectRows(int user_id, const BillColumns& columns,
+                                            const QueryCriteria& criteria) const {
+    const QueryPlan plan = MakeQueryPlan(user_id, columns, criteria);
+    const auto start = criteria.GetStartDate();
+    const auto end = criteria.GetEndDate();
+    auto matches = [&](size_t row) { return criteria.Matches(columns.View(row).ToQueryRow()); };
+    auto key_of = [&columns](size_t row) {
+        QueryRow key;
+        key.bill_id = columns.BillIds()[row];
+        key.amount = Money::FromCents(columns.AmountCents()[row]);
+        key.time = columns.Times()[row];
+        return key;
+    };
+
+    std::vector<size_t> rows;
+    switch (plan.path) {
+        case QueryAccessPath::kBillId: {
+            const BillSlots& slots = SlotsFor(user_id, columns);
+            std::vector<int> ids = criteria.GetBillIds();
+            std::sort(ids.begin(), ids.end());
+            ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+            for (int id : ids) {
+                auto slot = slots.find(id);
+                if (slot != slots.end() && matches(slot->second)) rows.push_back(slot->second);
+            }
+            break;
+        }
+        case QueryAccessPath::kCategoryIndex:
+            for (int category_id : plan.category_ids) {
+                ForEachRowInTimeRange(user_id, columns,
+                                      CategoryTimeIndex(user_id, columns, category_id), start, end,
+                                      [&](size_t row) {
+                                          if (matches(row)) rows.push_back(row);
+                                      });
+            }
+            break;
+        case QueryAccessPath::kTimeIndex: {
+            // 索引本身按 (时间, bill_id) 有序：按时间排序时顺序读取，取满 limit 条即可停止
+            const BillSlots& slots = SlotsFor(user_id, columns);
+            auto range = KeysInTimeRange(TimeIndexFor(user_id, columns), start, end);
+            const bool ordered = criteria.GetSortField() == QueryCriteria::SortField::kTime;
+            const size_t limit = ordered ? criteria.GetLimit() : 0;
+            if (ordered && criteria.IsDescending()) {
+                for (auto key = range.second; key != range.first;) {
+                    --key;
+                    // 取满后仍读完与最后一行同一时间的账单：同一时间内按 bill_id 升序取舍
+                    if (limit > 0 && rows.size() >= limit &&
+                        key->first != columns.Times()[rows.back()]) {
+                        break;
+                    }
+                    const size_t row = slots.at(key->second);
+                    if (matches(row)) rows.push_back(row);
+                }
+            } else {
+                for (auto key = range.first; key != range.second; ++key) {
+                    if (limit > 0 && rows.size() >= limit) break;
+                    const size_t row = slots.at(key->second);
+                    if (matches(row)) rows.push_back(row);
+                }
+            }
+            break;
+        }
+        case QueryAccessPath::kScan: {
+            // 先在连续的时间列和金额列上无分支地生成候选行，再按分类列过滤，最后检查其余条件
+            const size_t n = columns.Size();
+            const auto* times = columns.Times().data();
+            const auto* cents = columns.AmountCents().data();
+            const int64_t min_cents = criteria.GetMinAmount().Cents();
+            const int64_t max_cents = criteria.GetMaxAmount().Cents();
+            rows.resize(n);
+            size_t count = 0;
+            for (size_t row = 0; row < n; ++row) {
+                rows[count] = row;
+                count += static_cast<size_t>(times[row] >= start) & static_cast<size_t>(times[row] <= end) &
+                         static_cast<size_t>(cents[row] >= min_cents) &
+                         static_cast<size_t>(cents[row] <= max_cents);
+            }
+            rows.resize(count);
+            if (plan.category_ids_resolved) {
+                const auto* category_ids = columns.CategoryIds().data();
+                rows.erase(std::remove_if(rows.begin(), rows.end(),
+                                          [&](size_t row) {
+                                              return !std::binary_search(plan.category_ids.begin(),
+                                                                         plan.category_ids.end(),
+                                                                         category_ids[row]);
+                                          }),
+                           rows.end());
+            }
+            rows.erase(std::remove_if(rows.begin(), rows.end(),
+                                      [&](size_t row) { return !matches(row); }),
+                       rows.end());
+            break;
+        }
+    }
+
+    SortAndLimit(rows, criteria, key_of);
+    return rows;
+}
+
 std::vector<Bill> BillManager::QueryBillsByCriteria(
     int user_id, const QueryCriteria& criteria) const {
     std::vector<Bill> results;
     auto it = bills_.find(user_id);
-    if (it == bills_.end()) return results;
-
-    for (const auto& bill : it->second) {
-        bool match = true;
+    if (it != bills_.end()) {
+        const BillColumns& columns = it->second;
+        const auto rows = SelectRows(user_id, columns, criteria);
+        results.reserve(rows.size());
+        for (size_t row : rows) results.push_back(columns.Materialize(row));
+        return results;
+    }
 
-        // 日期范围过滤
-        if (criteria.HasDateRange()) {
-            if (bill.GetTime() < criteria.GetStartDate() ||
-                bill.GetTime() > criteria.GetEndDate()) {
-                match = false;
+    if (lazy_source_) {
+        for (auto& bill : LoadUncachedBills(user_id)) {
+            if (criteria.Matches(BillView::FromBill(bill).ToQueryRow())) {
+                results.push_back(std::move(bill));
             }
         }
-
-        // 分类名称过滤
-        if (criteria.HasCategoryFilter()) {
-            auto category = bill.GetCategory();
-            if (!category || category->GetName() != criteria.GetCategoryName()) {
-                match = false;
+    } else if (base_) {
+        // 未修改过的用户直接在快照列上过滤，只构造命中的账单
+        const auto* columns = base_->FindUser(user_id);
+        if (!columns) return results;
+        User tmp_user;
+        tmp_user.SetUserId(user_id);
+        for (size_t i = 0; i < columns->count; ++i) {
+            auto category = category_manager_
+                ? category_manager_->GetSharedCategory(tmp_user, columns->category_id[i])
+                : nullptr;
+            QueryRow row;
+            row.bill_id = columns->bill_id[i];
+            row.amount = columns->Amount(i);
+            row.time = std::chrono::system_clock::from_time_t(
+                static_cast<std::time_t>(columns->time[i]));
+            row.category_id = columns->category_id[i];
+            if (category) {
+                row.category_name = category->GetName();
+                row.category_type = category->GetType();
+            }
+            const uint32_t offset = columns->content_offset[i];
+            const uint32_t next = columns->content_offset[i + 1];
+            if (offset > next || next > columns->content_bytes) break;  // 数据损坏
+            row.content = std::string_view(columns->content + offset, next - offset);
+            if (!criteria.Matches(row)) continue;
+            try {
+                Bill bill = MappedBillSnapshot::MakeBill(*columns, i);
+                if (category) bill.SetCategory(category);
+                results.push_back(std::move(bill));
+            } catch (...) {
+                break;
             }
         }
+    }
+    SortAndLimitBills(results, criteria);
+    return results;
+}
 
-        if (match) results.push_back(bill);
+std::vector<Bill> BillManager::GetBillsInTimeRange(
+    int user_id, const std::chrono::system_clock::time_point& start,
+    const std::chrono::system_clock::time_point& end) const {
+    auto it = bills_.find(user_id);
+    if (it == bills_.end()) {
+        // 快照中或未加载的用户没有索引，按条件扫描后排序
+        QueryCriteria criteria;
+        criteria.SetStartDate(start);
+        criteria.SetEndDate(end);
+        auto results = QueryBillsByCriteria(user_id, criteria);
+        std::sort(results.begin(), results.end(), [](const Bill& a, const Bill& b) {
+            return TimeKey{a.GetTime(), a.GetBillId()} < TimeKey{b.GetTime(), b.GetBillId()};
+        });
+        return results;
+    }
+    const BillColumns& columns = it->second;
+    std::vector<Bill> results;
+    for (size_t row : RowsInTimeRange(user_id, columns, TimeIndexFor(user_id, columns),
+                                      start, end)) {
+        results.push_back(columns.Materialize(row));
     }
+    return results;
+}
 
+std::vector<Bill> BillManager::GetBillsByCategory(int user_id, int category_id) const {
+    return GetBillsByCategoryInTimeRange(user_id, category_id,
+                                         std::chrono::system_clock::time_point::min(),
+                                         std::chrono::system_clock::time_point::max());
+}
+
+std::vector<Bill> BillManager::GetBillsByCategoryInTimeRange(
+    int user_id, int category_id, const std::chrono::system_clock::time_point& start,
+    const std::chrono::system_clock::time_point& end) const {
+    std::vector<Bill> results;
+    auto it = bills_.find(user_id);
+    if (it == bills_.end()) {
+        // 快照中或未加载的用户没有索引，扫描时间范围后按分类过滤
+        for (auto& bill : GetBillsInTimeRange(user_id, start, end)) {
+            if (bill.GetCategoryId() == category_id) results.push_back(std::move(bill));
+        }
+        return results;
+    }
+    const BillColumns& columns = it->second;
+    const TimeIndex& index = CategoryTimeIndex(user_id, columns, category_id);
+    for (size_t row : RowsInTimeRange(user_id, columns, index, start, end)) {
+        results.push_back(columns.Materialize(row));
+    }
     return results;
 }
 
+Money BillManager::SumAmount(int user_id) const {
+    return SumAmountInTimeRange(user_id, std::chrono::system_clock::time_point::min(),
+                                std::chrono::system_clock::time_point::max());
+}
+
+Money BillManager::SumAmountInTimeRange(int user_id,
+                                        const std::chrono::system_clock::time_point& start,
+                                        const std::chrono::system_clock::time_point& end) const {
+    auto it = bills_.find(user_id);
+    if (it == bills_.end()) {
+        Money total;
+        ForEachBillInTimeRange(user_id, start, end,
+                               [&total](const BillView& bill) { total += bill.amount; });
+        return total;
+    }
+    // 只顺序读取时间列和金额列；整数求和与分块、线程数无关
+    const BillColumns& columns = it->second;
+    return Money::FromCents(money_sum::ParallelSumCentsInTimeRange(
+        columns.AmountCents().data(), columns.Times().data(), columns.Size(), start, end));
+}
+
+std::vector<size_t> BillManager::RowsInTimeRange(
+    int user_id, const BillColumns& columns, const TimeIndex& index,
+    const std::chrono::system_clock::time_point& start,
+    const std::chrono::system_clock::time_point& end) const {
+    std::vector<size_t> rows;
+    auto range = KeysInTimeRange(index, start, end);
+    rows.reserve(static_cast<size_t>(range.second - range.first));
+    ForEachRowInTimeRange(user_id, columns, index, start, end,
+                          [&rows](size_t row) { rows.push_back(row); });
+    return rows;
+}
+
+std::pair<BillManager::TimeIndex::const_iterator, BillManager::TimeIndex::const_iterator>
+BillManager::KeysInTimeRange(const TimeIndex& index,
+                             const std::chrono::system_clock::time_point& start,
+                             const std::chrono::system_clock::time_point& end) {
+    if (end < start) return {index.end(), index.end()};
+    // 同一时刻的账单按 id 排序，区间两端取 id 的极值
+    auto first = std::lower_bound(index.begin(), index.end(),
+                                  TimeKey{start, std::numeric_limits<int>::min()});
+    auto last = std::upper_bound(first, index.end(),
+                                 TimeKey{end, std::numeric_limits<int>::max()});
+    return {first, last};
+}
+
 // ========================== 存储加载 ==========================
 bool BillManager::LoadFromStorage(std::shared_ptr<Storage> storage, const CategoryManager& category_manager) {
+    return ReadFromStorage(std::move(storage)) && FinishLoad(category_manager);
+}
+
+bool BillManager::ReadFromStorage(std::shared_ptr<Storage> storage) {
     if (!storage) return false;
+    bill_log_.reset();
+    pending_log_records_ = 0;
+    pending_replay_.clear();
+    base_.reset();
+    lazy_source_.reset();
+    synced_storage_.reset();
+    dirty_users_.clear();
+    unmerged_users_.clear();
+    category_manager_ = nullptr;
+    bills_.clear();
+    bill_slots_.clear();
+    time_index_.clear();
+    category_index_.clear();
+    rollups_.clear();
+    stored_rollups_.clear();
+    verified_rollups_.clear();
+    // 重新加载后所有用户的数据都可能变化
+    data_versions_.clear();
+    base_version_ = ++version_counter_;
+    dirty_rollups_.clear();
     try {
-        auto res = storage->LoadBillsByUser();
-        if (!res.first) return false;
-        bills_ = std::move(res.second);
+        // 优先按用户加载或映射快照：启动耗时与账单数量无关
+        if (lazy_loading_ || storage->SupportsPerUserLoad()) {
+            lazy_source_ = storage;
+        } else {
+            auto snapshot = storage->OpenBillSnapshot();
+            if (!snapshot.first) return false;
+            if (snapshot.second) {
+                base_ = std::move(snapshot.second);
+            } else {
+                auto res = storage->LoadBillsByUser();
+                if (!res.first) return false;
+                // 逐个用户转成列式存储，转换完即释放该用户的 Bill 对象
+                while (!res.second.empty()) {
+                    auto node = res.second.extract(res.second.begin());
+                    bills_.emplace(node.key(), BillColumns(node.mapped()));
+                }
+            }
+        }
+
+        // 尚未合并的日志先读出来，等分类加载完成后在 FinishLoad 中重放
+        auto log = storage->LoadBillLog();
+        if (!log.first) return false;
+        pending_replay_ = std::move(log.second);
+
+        // 汇总是派生数据：读取失败时忽略，用到时重新计算。
+        // 按用户加载时随该用户的账单一起读取（LoadStoredRollup）
+        if (!lazy_source_ && storage->SupportsBillRollups()) {
+            auto rollups = storage->LoadBillRollups();
+            if (rollups.first) stored_rollups_ = std::move(rollups.second);
+        }
     } catch (...) {
         return false;
     }
+    synced_storage_ = storage;
     next_bill_id_.clear();
+    for (const auto& [user_id, columns] : bills_) {
+        const auto& ids = columns.BillIds();
+        next_bill_id_[user_id] = ids.empty() ? 1 : *std::max_element(ids.begin(), ids.end()) + 1;
+    }
+    return true;
+}
 
-    for (auto& [user_id, bills] : bills_) {
-        int max_id = 0;
-        // restore category pointers for each bill
-        User tmp_user;
-        tmp_user.SetUserId(user_id);
-        for (auto& bill : bills) {
-            max_id = std::max(max_id, bill.GetBillId());
-            int cid = bill.GetCategoryId();
-            if (cid >= 0) {
-                const Category* c = category_manager.GetCategoryById(tmp_user, cid);
-                if (c) {
-                    // create shared_ptr copy from manager's Category
-                    bill.SetCategory(std::make_shared<Category>(*c));
-                } else {
-                    bill.SetCategory(nullptr);
-                }
-            } else {
-                bill.SetCategory(nullptr);
+bool BillManager::FinishLoad(const CategoryManager& category_manager) {
+    if (!synced_storage_) return false;
+    category_manager_ = &category_manager;
+
+    // 在快照之上重放尚未合并的日志（未启用日志模式时也重放，防止切换模式后丢数据）；
+    // 重放涉及的用户记为脏，下次保存或 checkpoint 时写入快照
+    try {
+        for (const auto& record : pending_replay_) {
+            ApplyLogRecord(record);
+        }
+        pending_log_records_ = pending_replay_.size();
+        pending_replay_.clear();
+    } catch (...) {
+        return false;
+    }
+
+    // 各用户的分类指针互不相关，分类已在内存中的用户按用户并行恢复；
+    // 分类未加载的用户要读取存储，Storage 的同一 Load* 方法不能并发调用，逐个恢复
+    std::vector<std::pair<int, BillColumns*>> users;
+    users.reserve(bills_.size());
+    for (auto& [user_id, columns] : bills_) {
+        if (category_manager.IsUserLoaded(user_id)) {
+            users.emplace_back(user_id, &columns);
+        } else {
+            RestoreCategories(user_id, columns);
+        }
+    }
+    ParallelFor(users.size(), [this, &users](size_t i) {
+        RestoreCategories(users[i].first, *users[i].second);
+    }, 1);
+
+    if (synced_storage_->IsBillLogEnabled()) {
+        bill_log_ = synced_storage_;
+        // 重放的修改本来就在日志文件中，只是尚未合并进快照
+        unmerged_users_.insert(dirty_users_.begin(), dirty_users_.end());
+        dirty_users_.clear();
+    }
+    return true;
+}
+
+// 按分类 id 查找分类管理器中共享的分类对象；找不到时返回 nullptr
+class CategoryResolver {
+public:
+    CategoryResolver(const CategoryManager* category_manager, int user_id)
+        : category_manager_(category_manager) {
+        user_.SetUserId(user_id);
+        // 分类管理器懒加载且尚未加载该用户时，临时读取该用户的分类
+        use_unloaded_ = category_manager_ && !category_manager_->IsUserLoaded(user_id);
+        if (use_unloaded_) unloaded_ = category_manager_->GetCategoriesForUser(user_);
+    }
+
+    std::shared_ptr<const Category> Resolve(int category_id) const {
+        if (category_id < 0 || !category_manager_) return nullptr;
+        if (!use_unloaded_) return category_manager_->GetSharedCategory(user_, category_id);
+        // 未加载的用户没有共享对象，调用方按分类 id 缓存，每个分类只复制一份
+        auto it = std::find_if(unloaded_.begin(), unloaded_.end(),
+                               [category_id](const Category& x) {
+                                   return x.GetCategoryId() == category_id;
+                               });
+        return it != unloaded_.end() ? std::make_shared<const Category>(*it) : nullptr;
+    }
+
+private:
+    const CategoryManager* category_manager_;
+    User user_;
+    bool use_unloaded_ = false;
+    std::vector<Category> unloaded_;
+};
+
+void BillManager::RestoreCategories(int user_id, std::vector<Bill>& bills) const {
+    // restore category pointers for each bill
+    CategoryResolver resolver(category_manager_, user_id);
+    std::unordered_map<int, std::shared_ptr<const Category>> resolved;
+    for (auto& bill : bills) {
+        int cid = bill.GetCategoryId();
+        auto it = resolved.find(cid);
+        if (it == resolved.end()) it = resolved.emplace(cid, resolver.Resolve(cid)).first;
+        // 找不到分类时保留 category_id，便于分类恢复后重新关联
+        bill.SetCategory(it->second);
+        bill.SetCategoryId(cid);
+    }
+}
+
+void BillManager::ShareCategory(int user_id, BillColumns& columns, int category_id) const {
+    if (!category_manager_ || category_id < 0) return;
+    User tmp_user;
+    tmp_user.SetUserId(user_id);
+    if (auto shared = category_manager_->GetSharedCategory(tmp_user, category_id)) {
+        columns.SetCategory(category_id, std::move(shared));
+    }
+}
+
+std::unordered_map<int, std::shared_ptr<const Category>> BillManager::ResolveCategories(
+    int user_id, const std::vector<int>& category_ids) const {
+    CategoryResolver resolver(category_manager_, user_id);
+    std::unordered_map<int, std::shared_ptr<const Category>> resolved;
+    for (int cid : category_ids) resolved.emplace(cid, resolver.Resolve(cid));
+    return resolved;
+}
+
+void BillManager::RestoreCategories(int user_id, BillColumns& columns) const {
+    // 列式存储每个分类 id 只保存一个指针
+    CategoryResolver resolver(category_manager_, user_id);
+    for (int cid : columns.DistinctCategoryIds()) {
+        columns.SetCategory(cid, resolver.Resolve(cid));
+    }
+}
+
+const BillManager::TimeIndex& BillManager::TimeIndexFor(int user_id,
+                                                        const BillColumns& columns) const {
+    auto inserted = time_index_.try_emplace(user_id);
+    TimeIndex& index = inserted.first->second;
+    if (inserted.second) {
+        const auto& times = columns.Times();
+        const auto& ids = columns.BillIds();
+        index.reserve(columns.Size());
+        for (size_t row = 0; row < columns.Size(); ++row) index.emplace_back(times[row], ids[row]);
+        std::sort(index.begin(), index.end());
+    }
+    return index;
+}
+
+const BillManager::TimeIndex& BillManager::CategoryTimeIndex(int user_id,
+                                                             const BillColumns& columns,
+                                                             int category_id) const {
+    auto inserted = category_index_.try_emplace(user_id);
+    CategoryIndex& by_category = inserted.first->second;
+    if (inserted.second) {
+        const auto& times = columns.Times();
+        const auto& ids = columns.BillIds();
+        const auto& category_ids = columns.CategoryIds();
+        for (size_t row = 0; row < columns.Size(); ++row) {
+            by_category[category_ids[row]].emplace_back(times[row], ids[row]);
+        }
+        for (auto& [_, index] : by_category) std::sort(index.begin(), index.end());
+    }
+    static const TimeIndex kEmpty;
+    auto found = by_category.find(category_id);
+    return found != by_category.end() ? found->second : kEmpty;
+}
+
+const BillRollup& BillManager::RollupFor(int user_id, const BillColumns& columns) const {
+    auto inserted = rollups_.try_emplace(user_id);
+    BillRollup& rollup = inserted.first->second;
+    if (inserted.second) {
+        // 优先使用存储中保存的汇总；与当前账单不一致（如之后又重放了日志）时重新计算
+        auto stored = stored_rollups_.find(user_id);
+        const bool reused = stored != stored_rollups_.end() &&
+                            BillRollup::FromSnapshot(stored->second, columns, rollup);
+        if (stored != stored_rollups_.end()) stored_rollups_.erase(stored);
+        verified_rollups_.erase(user_id);
+        if (!reused) {
+            rollup = BillRollup(columns);
+            dirty_rollups_.insert(user_id);
+        }
+    }
+    return rollup;
+}
+
+void BillManager::RollupAdd(int user_id, const Bill& bill) {
+    auto rollup = rollups_.find(user_id);
+    if (rollup == rollups_.end()) return;
+    rollup->second.Add(bill.GetBillId(), bill.GetTime(), bill.GetCategoryId(),
+                       bill.GetMoney().Cents());
+    dirty_rollups_.insert(user_id);
+}
+
+void BillManager::RollupRemove(int user_id, const BillColumns& columns, size_t row) {
+    auto rollup = rollups_.find(user_id);
+    if (rollup == rollups_.end()) return;
+    rollup->second.Remove(columns.BillIds()[row], columns.Times()[row],
+                          columns.CategoryIds()[row], columns.AmountCents()[row]);
+    dirty_rollups_.insert(user_id);
+}
+
+BillManager::CategoryTotal BillManager::SumCategoryInDays(int user_id, int category_id,
+                                                          int64_t first_day,
+                                                          int64_t last_day) const {
+    auto it = bills_.find(user_id);
+    if (it != bills_.end()) {
+        return RollupFor(user_id, it->second).SumCategory(category_id, first_day, last_day);
+    }
+    return UncachedRollup(user_id).SumCategory(category_id, first_day, last_day);
+}
+
+BillManager::CategoryTotal BillManager::SumInDays(int user_id, int64_t first_day,
+                                                  int64_t last_day) const {
+    auto it = bills_.find(user_id);
+    if (it != bills_.end()) return RollupFor(user_id, it->second).SumAll(first_day, last_day);
+    return UncachedRollup(user_id).SumAll(first_day, last_day);
+}
+
+BillRollup BillManager::UncachedRollup(int user_id) const {
+    BillRollup rollup;
+    LoadStoredRollup(user_id);
+    auto stored = stored_rollups_.find(user_id);
+    if (stored != stored_rollups_.end() && verified_rollups_.count(user_id) &&
+        BillRollup::FromVerifiedSnapshot(stored->second, rollup)) {
+        return rollup;
+    }
+    // 第一次使用：与账单核对，不一致或没有保存的汇总时重新计算，之后不再读取账单
+    const BillColumns columns(LoadUncachedBills(user_id));
+    if (stored != stored_rollups_.end() &&
+        BillRollup::FromSnapshot(stored->second, columns, rollup)) {
+        verified_rollups_.insert(user_id);
+        return rollup;
+    }
+    rollup = BillRollup(columns);
+    if (!columns.Empty()) {
+        stored_rollups_[user_id] = rollup.ToSnapshot();
+        verified_rollups_.insert(user_id);
+        dirty_rollups_.insert(user_id);
+    }
+    return rollup;
+}
+
+void BillManager::LoadStoredRollup(int user_id) const {
+    if (!lazy_source_ || !lazy_source_->SupportsBillRollups()) return;
+    // 卸载时留下的汇总已与存储中的账单核对过，比存储中保存的更新
+    if (stored_rollups_.count(user_id)) return;
+    try {
+        auto res = lazy_source_->LoadBillRollupForUser(user_id);
+        if (res.first && res.second) stored_rollups_.emplace(user_id, std::move(*res.second));
+    } catch (...) {
+        // 汇总是派生数据：读取失败时忽略，用到时重新计算
+    }
+}
+
+bool BillManager::WriteRollups(const std::shared_ptr<Storage>& storage, bool force) const {
+    if (!storage->SupportsBillRollups()) return true;
+    if (dirty_rollups_.empty() && !force) return true;
+    if (!force && storage->SupportsPartialSave()) {
+        // 只写汇总有变化的用户；汇总已丢弃的用户不写，存储中的旧汇总下次使用时与账单核对
+        std::map<int, BillRollupSnapshot> changed;
+        for (int user_id : dirty_rollups_) {
+            auto rollup = rollups_.find(user_id);
+            if (rollup != rollups_.end()) {
+                changed[user_id] = rollup->second.ToSnapshot();
+                continue;
+            }
+            auto stored = stored_rollups_.find(user_id);
+            if (stored != stored_rollups_.end()) changed[user_id] = stored->second;
+        }
+        if (!storage->SaveBillRollupsForUsers(changed)) return false;
+        dirty_rollups_.clear();
+        return true;
+    }
+    // 未建立汇总的用户沿用已保存的汇总（下次使用时仍会与账单核对）；
+    // 按用户加载时内存中只有部分用户的汇总，其余从来源存储读取
+    std::map<int, BillRollupSnapshot> data;
+    if (lazy_source_) {
+        auto saved = lazy_source_->LoadBillRollups();
+        if (saved.first) data = std::move(saved.second);
+    }
+    for (const auto& [user_id, snapshot] : stored_rollups_) data[user_id] = snapshot;
+    for (const auto& [user_id, rollup] : rollups_) data[user_id] = rollup.ToSnapshot();
+    if (!storage->SaveBillRollups(data)) return false;
+    dirty_rollups_.clear();
+    return true;
+}
+
+void BillManager::IndexRow(int user_id, const TimeKey& key, int category_id) {
+    auto time_index = time_index_.find(user_id);
+    if (time_index != time_index_.end()) InsertTimeKey(time_index->second, key);
+    auto by_category = category_index_.find(user_id);
+    if (by_category != category_index_.end()) {
+        InsertTimeKey(by_category->second[category_id], key);
+    }
+}
+
+void BillManager::IndexRows(int user_id, std::vector<std::pair<TimeKey, int>> rows) {
+    auto time_index = time_index_.find(user_id);
+    if (time_index != time_index_.end()) {
+        TimeIndex keys;
+        keys.reserve(rows.size());
+        for (const auto& row : rows) keys.push_back(row.first);
+        MergeTimeKeys(time_index->second, std::move(keys));
+    }
+    auto by_category = category_index_.find(user_id);
+    if (by_category != category_index_.end()) {
+        // 按分类分组后逐组归并
+        std::sort(rows.begin(), rows.end(), [](const auto& a, const auto& b) {
+            return std::tie(a.second, a.first) < std::tie(b.second, b.first);
+        });
+        for (size_t begin = 0; begin < rows.size();) {
+            size_t end = begin;
+            TimeIndex keys;
+            while (end < rows.size() && rows[end].second == rows[begin].second) {
+                keys.push_back(rows[end++].first);
+            }
+            MergeTimeKeys(by_category->second[rows[begin].second], std::move(keys));
+            begin = end;
+        }
+    }
+}
+
+void BillManager::MergeTimeKeys(TimeIndex& index, TimeIndex keys) {
+    std::sort(keys.begin(), keys.end());
+    const size_t old_size = index.size();
+    index.insert(index.end(), keys.begin(), keys.end());
+    // 新账单通常都晚于已有账单，此时无需归并
+    if (old_size > 0 && old_size < index.size() && index[old_size] < index[old_size - 1]) {
+        std::inplace_merge(index.begin(), index.begin() + old_size, index.end());
+    }
+}
+
+void BillManager::UnindexRow(int user_id, const TimeKey& key, int category_id) {
+    auto time_index = time_index_.find(user_id);
+    if (time_index != time_index_.end()) EraseTimeKey(time_index->second, key);
+    auto by_category = category_index_.find(user_id);
+    if (by_category != category_index_.end()) {
+        auto index = by_category->second.find(category_id);
+        if (index != by_category->second.end()) {
+            EraseTimeKey(index->second, key);
+            if (index->second.empty()) by_category->second.erase(index);
+        }
+    }
+}
+
+void BillManager::InsertTimeKey(TimeIndex& index, const TimeKey& key) {
+    // 新账单通常是最新的，直接追加
+    if (index.empty() || index.back() < key) {
+        index.push_back(key);
+    } else {
+        index.insert(std::upper_bound(index.begin(), index.end(), key), key);
+    }
+}
+
+void BillManager::EraseTimeKey(TimeIndex& index, const TimeKey& key) {
+    auto it = std::lower_bound(index.begin(), index.end(), key);
+    if (it != index.end() && *it == key) index.erase(it);
+}
+
+BillManager::BillSlots& BillManager::SlotsFor(int user_id, const BillColumns& columns) const {
+    auto inserted = bill_slots_.try_emplace(user_id);
+    BillSlots& slots = inserted.first->second;
+    if (inserted.second) {
+        const auto& ids = columns.BillIds();
+        slots.reserve(ids.size());
+        // 数据中重复的 bill_id 以第一次出现的为准，与原先的线性查找一致
+        for (size_t row = 0; row < ids.size(); ++row) slots.emplace(ids[row], row);
+    }
+    return slots;
+}
+
+BillColumns* BillManager::MutableUserBills(int user_id, bool create) {
+    auto it = bills_.find(user_id);
+    if (it != bills_.end()) return &it->second;
+
+    // 第一次访问该用户：从快照复制或从存储加载到内存
+    std::vector<Bill> bills;
+    if (lazy_source_) {
+        auto res = lazy_source_->LoadBillsForUser(user_id);
+        if (!res.first) {
+            std::cerr << "[BillManager] Failed to load bills for user " << user_id << std::endl;
+            return nullptr;
+        }
+        bills = std::move(res.second);
+        LoadStoredRollup(user_id);
+    } else if (base_ && base_->FindUser(user_id)) {
+        if (!base_->MaterializeUser(user_id, bills)) {
+            std::cerr << "[BillManager] Corrupt bill snapshot for user " << user_id << std::endl;
+        }
+    } else if (!create) {
+        return nullptr;
+    }
+
+    int max_id = 0;
+    for (const auto& bill : bills) max_id = std::max(max_id, bill.GetBillId());
+    next_bill_id_.emplace(user_id, max_id + 1);
+    bill_slots_.erase(user_id);
+    time_index_.erase(user_id);
+    category_index_.erase(user_id);
+    rollups_.erase(user_id);
+    BillColumns& columns = bills_[user_id] = BillColumns(bills);
+    RestoreCategories(user_id, columns);
+    return &columns;
+}
+
+bool BillManager::LoadUser(int user_id) {
+    if (!lazy_source_) return true;
+    return MutableUserBills(user_id, true) != nullptr;
+}
+
+bool BillManager::EvictUser(int user_id) {
+    if (!CanEvictUser(user_id)) return false;
+    if (dirty_users_.count(user_id) || unmerged_users_.count(user_id)) {
+        // 重新加载时只读快照、不重放日志，日志模式下先把修改合并进快照
+        if (!Checkpoint()) return false;
+    }
+    bills_.erase(user_id);
+    bill_slots_.erase(user_id);
+    time_index_.erase(user_id);
+    category_index_.erase(user_id);
+    // 未修改的用户的汇总与存储中的账单一致，留到下次加载或保存时使用
+    auto rollup = rollups_.find(user_id);
+    if (rollup != rollups_.end()) {
+        stored_rollups_[user_id] = rollup->second.ToSnapshot();
+        verified_rollups_.insert(user_id);
+        rollups_.erase(rollup);
+    }
+    next_bill_id_.erase(user_id);
+    return true;
+}
+
+bool BillManager::CanEvictUser(int user_id) const {
+    if (!lazy_source_) return false;
+    return bill_log_ || (!dirty_users_.count(user_id) && !unmerged_users_.count(user_id));
+}
+
+bool BillManager::IsUserLoaded(int user_id) const {
+    return !lazy_source_ || bills_.count(user_id) > 0;
+}
+
+bool BillManager::SaveAllBills(Storage& storage) const {
+    if (lazy_source_) {
+        // 未加载的用户从来源存储读取，再覆盖上内存中的数据
+        auto res = lazy_source_->LoadBillsByUser();
+        if (!res.first) return false;
+        for (const auto& [user_id, columns] : bills_) res.second[user_id] = columns.MaterializeAll();
+        return storage.SaveBillsByUser(res.second);
+    }
+
+    std::map<int, std::vector<Bill>> merged;
+    for (const auto& [user_id, columns] : bills_) merged[user_id] = columns.MaterializeAll();
+    if (!base_) return storage.SaveBillsByUser(merged);
+    for (int user_id : base_->GetUserIds()) {
+        if (merged.count(user_id)) continue;
+        if (!base_->MaterializeUser(user_id, merged[user_id])) return false;
+    }
+    return storage.SaveBillsByUser(merged);
+}
+
+bool BillManager::WriteBills(const std::shared_ptr<Storage>& storage) const {
+    if (storage == synced_storage_) {
+        if (dirty_users_.empty() && unmerged_users_.empty()) return true;
+        if (storage->SupportsPartialSave()) {
+            // 脏用户一定已复制到增量层
+            std::set<int> users = unmerged_users_;
+            users.insert(dirty_users_.begin(), dirty_users_.end());
+            std::map<int, std::vector<Bill>> changed;
+            for (int user_id : users) {
+                auto it = bills_.find(user_id);
+                if (it != bills_.end()) changed.emplace(user_id, it->second.MaterializeAll());
             }
+            if (!storage->SaveBillsForUsers(changed)) return false;
+            dirty_users_.clear();
+            unmerged_users_.clear();
+            return true;
         }
-        next_bill_id_[user_id] = max_id + 1;
     }
+    if (!SaveAllBills(*storage)) return false;
+    synced_storage_ = storage;
+    dirty_users_.clear();
+    unmerged_users_.clear();
     return true;
 }
 
 bool BillManager::SaveToStorage(std::shared_ptr<Storage> storage) const {
-    return storage->SaveBillsByUser(bills_);
+    if (!storage) return false;
+    const bool synced = storage == synced_storage_;
+    // 日志模式下每次变更都已写入日志，只需确保日志落盘，无需重写快照
+    if (bill_log_ && storage == bill_log_) {
+        if (!storage->SyncBillLog()) return false;
+        // 修改已安全落在日志中，不再算未保存；快照留到下次 checkpoint 写入
+        unmerged_users_.insert(dirty_users_.begin(), dirty_users_.end());
+        dirty_users_.clear();
+        return WriteRollups(storage, false);
+    }
+    if (!WriteBills(storage)) return false;
+    if (!WriteRollups(storage, !synced)) return false;
+    return storage->ClearBillLog();
+}
+
+// ========================== 变更日志 ==========================
+void BillManager::SetCheckpointInterval(size_t interval) {
+    checkpoint_interval_ = interval;
+}
+
+bool BillManager::Checkpoint() {
+    if (!bill_log_) return true;
+    if (!WriteBills(bill_log_)) return false;
+    if (!bill_log_->ClearBillLog()) return false;
+    pending_log_records_ = 0;
+    return true;
+}
+
+bool BillManager::ApplyLogRecord(const BillLogRecord& record) {
+    switch (record.op) {
+        case BillLogRecord::Op::kAdd:
+            return AddBill(record.user_id, record.bill);
+        case BillLogRecord::Op::kUpdate:
+            return UpdateBill(record.user_id, record.bill);
+        case BillLogRecord::Op::kDelete:
+            return DeleteBill(record.user_id, record.bill_id);
+    }
+    return false;
+}
+
+bool BillManager::AppendLog(const BillLogRecord& record) {
+    if (!bill_log_) return true;
+    if (!bill_log_->AppendBillLog(record)) {
+        std::cerr << "[BillManager] Failed to append bill log for user "
+                  << record.user_id << std::endl;
+        return false;
+    }
+    ++pending_log_records_;
+    return true;
+}
+
+void BillManager::MaybeCheckpoint() {
+    if (!bill_log_ || checkpoint_interval_ == 0) return;
+    if (pending_log_records_ >= checkpoint_interval_) {
+        Checkpoint();
+    }
 }
 
 }  // namespace accounting
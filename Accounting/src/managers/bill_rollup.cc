@@ -0,0 +1,209 @@
+#include "managers/bill_rollup.h"
+#include "utils/time_utils.h"
+
+namespace accounting {
+
+BillRollup::BillRollup(const BillColumns& columns) {
+    const auto& ids = columns.BillIds();
+    const auto& times = columns.Times();
+    const auto& category_ids = columns.CategoryIds();
+    const auto& amounts = columns.AmountCents();
+    for (size_t row = 0; row < columns.Size(); ++row) {
+        Add(ids[row], times[row], category_ids[row], amounts[row]);
+    }
+}
+
+BillRollup::BillRollup(const std::vector<Bill>& bills) {
+    for (const auto& bill : bills) {
+        Add(bill.GetBillId(), bill.GetTime(), bill.GetCategoryId(), bill.GetMoney().Cents());
+    }
+}
+
+// ===== 持久化 =====
+BillRollupSnapshot BillRollup::ToSnapshot() const {
+    BillRollupSnapshot snapshot;
+    snapshot.bill_count = bill_count_;
+    snapshot.total_cents = total_cents_;
+    snapshot.checksum = checksum_;
+    for (const auto& [category_id, series] : series_) {
+        for (size_t i = 0; i < series.days.size(); ++i) {
+            snapshot.entries.push_back(
+                {category_id, series.days[i], series.cents[i], series.counts[i]});
+        }
+    }
+    snapshot.day_fingerprint = DayFingerprint(snapshot.entries);
+    return snapshot;
+}
+
+bool BillRollup::FromSnapshot(const BillRollupSnapshot& snapshot, const BillColumns& columns,
+                              BillRollup& out) {
+    if (snapshot.bill_count != static_cast<int64_t>(columns.Size())) return false;
+    // 日期按本地时区划分，时区规则变化后已保存的日期不再可信
+    if (snapshot.day_fingerprint != DayFingerprint(snapshot.entries)) return false;
+    // 校验只做整数运算，比逐行换算日期重新计算便宜
+    const auto& ids = columns.BillIds();
+    const auto& times = columns.Times();
+    const auto& category_ids = columns.CategoryIds();
+    const auto& amounts = columns.AmountCents();
+    int64_t total_cents = 0;
+    uint64_t checksum = 0;
+    for (size_t row = 0; row < columns.Size(); ++row) {
+        total_cents += amounts[row];
+        checksum += RowChecksum(ids[row], times[row], category_ids[row], amounts[row]);
+    }
+    if (total_cents != snapshot.total_cents || checksum != snapshot.checksum) return false;
+    return FromVerifiedSnapshot(snapshot, out);
+}
+
+bool BillRollup::FromVerifiedSnapshot(const BillRollupSnapshot& snapshot, BillRollup& out) {
+    BillRollup rollup;
+    int64_t entry_count = 0;
+    for (const auto& entry : snapshot.entries) {
+        if (entry.count <= 0) return false;
+        rollup.AddDay(entry.category_id, entry.day, entry.total_cents, entry.count);
+        entry_count += entry.count;
+    }
+    if (entry_count != snapshot.bill_count) return false;
+    rollup.bill_count_ = snapshot.bill_count;
+    rollup.total_cents_ = snapshot.total_cents;
+    rollup.checksum_ = snapshot.checksum;
+    out = std::move(rollup);
+    return true;
+}
+
+// ===== 修改 =====
+void BillRollup::Add(int bill_id, const TimePoint& time, int category_id, int64_t amount_cents) {
+    AddDay(category_id, time_utils::LocalDayNumber(time), amount_cents, 1);
+    ++bill_count_;
+    total_cents_ += amount_cents;
+    checksum_ += RowChecksum(bill_id, time, category_id, amount_cents);
+}
+
+void BillRollup::Remove(int bill_id, const TimePoint& time, int category_id,
+                        int64_t amount_cents) {
+    AddDay(category_id, time_utils::LocalDayNumber(time), -amount_cents, -1);
+    --bill_count_;
+    total_cents_ -= amount_cents;
+    checksum_ -= RowChecksum(bill_id, time, category_id, amount_cents);
+}
+
+void BillRollup::AddDay(int category_id, int64_t day, int64_t cents, int64_t count) {
+    Series& series = series_[category_id];
+    series.total_cents += cents;
+    series.total_count += count;
+
+    auto it = std::lower_bound(series.days.begin(), series.days.end(), day);
+    const size_t i = static_cast<size_t>(it - series.days.begin());
+    if (it == series.days.end() || *it != day) {
+        series.days.insert(it, day);
+        series.cents.insert(series.cents.begin() + i, 0);
+        series.counts.insert(series.counts.begin() + i, 0);
+    }
+    series.cents[i] += cents;
+    series.counts[i] += count;
+    if (series.counts[i] <= 0) {
+        series.days.erase(series.days.begin() + i);
+        series.cents.erase(series.cents.begin() + i);
+        series.counts.erase(series.counts.begin() + i);
+    }
+    series.prefix_valid = std::min(series.prefix_valid, i);
+    if (series.total_count <= 0) series_.erase(category_id);
+}
+
+// ===== 查询 =====
+void BillRollup::EnsurePrefix(const Series& series) {
+    const size_t n = series.days.size();
+    series.prefix_cents.resize(n + 1);
+    series.prefix_counts.resize(n + 1);
+    series.prefix_cents[0] = 0;
+    series.prefix_counts[0] = 0;
+    for (size_t i = series.prefix_valid; i < n; ++i) {
+        series.prefix_cents[i + 1] = series.prefix_cents[i] + series.cents[i];
+        series.prefix_counts[i + 1] = series.prefix_counts[i] + series.counts[i];
+    }
+    series.prefix_valid = n;
+}
+
+BillRollup::Total BillRollup::SumSeries(const Series& series, int64_t first_day,
+                                        int64_t last_day) {
+    Total total;
+    if (last_day < first_day) return total;
+    if (first_day == kFirstDay && last_day == kLastDay) {
+        total.total = Money::FromCents(series.total_cents);
+        total.count = static_cast<size_t>(series.total_count);
+        return total;
+    }
+    EnsurePrefix(series);
+    const size_t lo = static_cast<size_t>(
+        std::lower_bound(series.days.begin(), series.days.end(), first_day) - series.days.begin());
+    const size_t hi = static_cast<size_t>(
+        std::upper_bound(series.days.begin(), series.days.end(), last_day) - series.days.begin());
+    if (hi <= lo) return total;
+    total.total = Money::FromCents(series.prefix_cents[hi] - series.prefix_cents[lo]);
+    total.count = static_cast<size_t>(series.prefix_counts[hi] - series.prefix_counts[lo]);
+    return total;
+}
+
+BillRollup::Total BillRollup::SumCategory(int category_id, int64_t first_day,
+                                          int64_t last_day) const {
+    auto it = series_.find(category_id);
+    if (it == series_.end()) return Total();
+    return SumSeries(it->second, first_day, last_day);
+}
+
+BillRollup::Total BillRollup::SumAll(int64_t first_day, int64_t last_day) const {
+    Total total;
+    for (const auto& [_, series] : series_) {
+        const Total part = SumSeries(series, first_day, last_day);
+        total.total += part.total;
+        total.count += part.count;
+    }
+    return total;
+}
+
+std::vector<int> BillRollup::CategoryIds() const {
+    std::vector<int> ids;
+    ids.reserve(series_.size());
+    for (const auto& [category_id, _] : series_) ids.push_back(category_id);
+    return ids;
+}
+
+uint64_t BillRollup::DayFingerprint(const std::vector<BillRollupEntry>& entries) {
+    std::vector<int64_t> days;
+    days.reserve(entries.size());
+    for (const auto& entry : entries) days.push_back(entry.day);
+    std::sort(days.begin(), days.end());
+    days.erase(std::unique(days.begin(), days.end()), days.end());
+
+    // 账单属于日期 d 当且仅当时间在 [d 的 0 点, d + 1 的 0 点) 内，两端都计入
+    uint64_t fingerprint = 0;
+    for (int64_t day : days) {
+        const auto start = std::chrono::system_clock::to_time_t(time_utils::LocalDayStart(day));
+        const auto end = std::chrono::system_clock::to_time_t(time_utils::LocalDayStart(day + 1));
+        uint64_t x = static_cast<uint64_t>(day);
+        x = x * 0x9E3779B97F4A7C15ULL + static_cast<uint64_t>(start);
+        x = x * 0x9E3779B97F4A7C15ULL + static_cast<uint64_t>(end);
+        x ^= x >> 31;
+        x *= 0xBF58476D1CE4E5B9ULL;
+        x ^= x >> 29;
+        fingerprint = fingerprint * 0x94D049BB133111EBULL + x;
+    }
+    return fingerprint;
+}
+
+uint64_t BillRollup::RowChecksum(int bill_id, const TimePoint& time, int category_id,
+                                 int64_t amount_cents) {
+    // 各字段依次混入后做一次 splitmix64 终结，使不同账单的分量近似独立
+    uint64_t x = static_cast<uint64_t>(static_cast<uint32_t>(bill_id));
+    x = x * 0x9E3779B97F4A7C15ULL + static_cast<uint64_t>(time.time_since_epoch().count());
+    x = x * 0x9E3779B97F4A7C15ULL + static_cast<uint64_t>(static_cast<uint32_t>(category_id));
+    x = x * 0x9E3779B97F4A7C15ULL + static_cast<uint64_t>(amount_cents);
+    x ^= x >> 30;
+    x *= 0xBF58476D1CE4E5B9ULL;
+    x ^= x >> 27;
+    x *= 0x94D049BB133111EBULL;
+    x ^= x >> 31;
+    return x;
+}
+
+}  // namespace accounting
@@ -5,6 +5,8 @@ namespace accounting {
 
 bool BudgetManager::SetBudget(int user_id, const Budget& budget) {
     budgets_[user_id] = budget;
+    loaded_users_.insert(user_id);
+    dirty_users_.insert(user_id);
     return true;
 }
 
@@ -13,34 +15,37 @@ std::shared_ptr<Budget> BudgetManager::GetBudget(int user_id) const {
     if (it != budgets_.end()) {
         return std::make_shared<Budget>(it->second);
     }
+    // 懒加载模式下未加载的用户临时从存储读取，不常驻
+    if (!IsUserLoaded(user_id) && lazy_source_) {
+        auto res = lazy_source_->LoadBudgetForUser(user_id);
+        if (res.first) return res.second;
+    }
     return nullptr;
 }
 
 bool BudgetManager::CheckLimit(int user_id, const Bill& bill) const {
     auto it = budgets_.find(user_id);
+    std::shared_ptr<Budget> loaded;
     if (it == budgets_.end()) {
+        loaded = GetBudget(user_id);
         // 没有设置预算，则默认不限制
-        return true;
+        if (!loaded) return true;
     }
 
-    const Budget& budget = it->second;
-    double total_limit = budget.GetTotalLimit();
-    double current_total = 0.0;
-
-    // 计算当前已使用预算（按 category_id -> limit）
-    auto category_limits = budget.GetCategoryLimits();
-    for (const auto& [category_id, limit] : category_limits) {
-        if (bill.GetCategory() && category_id == bill.GetCategory()->GetCategoryId()) {
-            // 假设当前账单就是本类别，检查是否超出类别限额
-            if (bill.GetAmount() > limit) {
-                return false;
-            }
-        }
-        current_total += limit;
+    return CheckLimit(loaded ? *loaded : it->second, bill);
+}
+
+bool BudgetManager::CheckLimit(const Budget& budget, const Bill& bill) {
+    const Money amount = bill.GetMoney();
+
+    // 按分比较，避免 double 舍入误差导致恰好等于限额的账单被拒绝
+    if (bill.GetCategory() && budget.HasCategoryLimit(bill.GetCategory()->GetCategoryId()) &&
+        amount > budget.GetCategoryLimitMoney(bill.GetCategory()->GetCategoryId())) {
+        return false;
     }
 
     // 检查总预算
-    if (bill.GetAmount() > total_limit) {
+    if (amount > budget.GetTotalLimitMoney()) {
         return false;
     }
 
@@ -49,6 +54,15 @@ bool BudgetManager::CheckLimit(int user_id, const Bill& bill) const {
 
 bool BudgetManager::LoadFromStorage(std::shared_ptr<Storage> storage) {
     if (!storage) return false;
+    budgets_.clear();
+    loaded_users_.clear();
+    lazy_source_.reset();
+    if (lazy_loading_) {
+        lazy_source_ = storage;
+        synced_storage_ = storage;
+        dirty_users_.clear();
+        return true;
+    }
     try {
         auto res = storage->LoadBudgetsByUser();
         if (!res.first) return false;
@@ -56,12 +70,68 @@ bool BudgetManager::LoadFromStorage(std::shared_ptr<Storage> storage) {
     } catch (...) {
         return false;
     }
+    synced_storage_ = storage;
+    dirty_users_.clear();
     return true;
 }
 
 bool BudgetManager::SaveToStorage(std::shared_ptr<Storage> storage) const {
     if (!storage) return false;
-    return storage->SaveBudgetsByUser(budgets_);
+    if (storage == synced_storage_) {
+        if (dirty_users_.empty()) return true;
+        if (storage->SupportsPartialSave()) {
+            std::map<int, Budget> changed;
+            for (int user_id : dirty_users_) {
+                auto it = budgets_.find(user_id);
+                if (it != budgets_.end()) changed.emplace(*it);
+            }
+            if (!storage->SaveBudgetsForUsers(changed)) return false;
+            dirty_users_.clear();
+            return true;
+        }
+    }
+    if (lazy_source_) {
+        // 未加载的用户从来源存储读取，再覆盖上内存中的数据
+        auto res = lazy_source_->LoadBudgetsByUser();
+        if (!res.first) return false;
+        for (const auto& [user_id, budget] : budgets_) res.second[user_id] = budget;
+        if (!storage->SaveBudgetsByUser(res.second)) return false;
+    } else if (!storage->SaveBudgetsByUser(budgets_)) {
+        return false;
+    }
+    synced_storage_ = storage;
+    dirty_users_.clear();
+    return true;
+}
+
+// ===== 按用户加载 =====
+bool BudgetManager::LoadUser(int user_id) {
+    if (IsUserLoaded(user_id)) return true;
+    if (!lazy_source_) return false;
+    try {
+        auto res = lazy_source_->LoadBudgetForUser(user_id);
+        if (!res.first) return false;
+        if (res.second) budgets_[user_id] = *res.second;
+    } catch (...) {
+        return false;
+    }
+    loaded_users_.insert(user_id);
+    return true;
+}
+
+bool BudgetManager::EvictUser(int user_id) {
+    if (!CanEvictUser(user_id)) return false;
+    budgets_.erase(user_id);
+    loaded_users_.erase(user_id);
+    return true;
+}
+
+bool BudgetManager::CanEvictUser(int user_id) const {
+    return lazy_loading_ && !dirty_users_.count(user_id);
+}
+
+bool BudgetManager::IsUserLoaded(int user_id) const {
+    return !lazy_loading_ || loaded_users_.count(user_id) > 0;
 }
 
 }  // namespace accounting
@@ -5,10 +5,29 @@
 
 namespace accounting {
 
+namespace {
+
+CategoryManager::CategoryList MakeShared(std::vector<Category> categories) {
+    CategoryManager::CategoryList shared;
+    shared.reserve(categories.size());
+    for (auto& c : categories) shared.push_back(std::make_shared<Category>(std::move(c)));
+    return shared;
+}
+
+std::vector<Category> Values(const CategoryManager::CategoryList& categories) {
+    std::vector<Category> values;
+    values.reserve(categories.size());
+    for (const auto& c : categories) values.push_back(*c);
+    return values;
+}
+
+}  // namespace
+
 CategoryManager::CategoryManager(std::shared_ptr<Storage> storage)
     : storage_(std::move(storage)) {}
 
 bool CategoryManager::AddCategory(const User& user, const Category& category) {
+    if (!LoadUser(user.GetUserId())) return false;
     auto& user_categories = categories_by_user_[user.GetUserId()];
 
     if (IsDuplicateCategoryName(user, category.GetName())) {
@@ -20,29 +39,33 @@ bool CategoryManager::AddCategory(const User& user, const Category& category) {
     // 为该用户生成一个新的 category_id
     int new_id = 1;
     for (const auto& c : user_categories) {
-        if (c.GetCategoryId() >= new_id) {
-            new_id = c.GetCategoryId() + 1;
+        if (c->GetCategoryId() >= new_id) {
+            new_id = c->GetCategoryId() + 1;
         }
     }
     new_cat.SetCategoryId(new_id);
 
-    user_categories.push_back(new_cat);
+    user_categories.push_back(std::make_shared<Category>(std::move(new_cat)));
+    dirty_users_.insert(user.GetUserId());
     return true;
 }
 
 bool CategoryManager::UpdateCategory(const User& user, const Category& category) {
+    if (!LoadUser(user.GetUserId())) return false;
     auto it = categories_by_user_.find(user.GetUserId());
     if (it == categories_by_user_.end()) return false;
 
     auto& user_categories = it->second;
     for (auto& c : user_categories) {
-        if (c.GetCategoryId() == category.GetCategoryId()) {
+        if (c->GetCategoryId() == category.GetCategoryId()) {
             // 若修改名称，检查是否冲突
-            if (c.GetName() != category.GetName() &&
+            if (c->GetName() != category.GetName() &&
                 IsDuplicateCategoryName(user, category.GetName())) {
                 return false;
             }
-            c = category;
+            // 在原对象上修改，共享该分类的账单随之看到新的名称/类型
+            *c = category;
+            dirty_users_.insert(user.GetUserId());
             return true;
         }
     }
@@ -50,26 +73,33 @@ bool CategoryManager::UpdateCategory(const User& user, const Category& category)
 }
 
 bool CategoryManager::DeleteCategory(const User& user, int category_id) {
+    if (!LoadUser(user.GetUserId())) return false;
     auto it = categories_by_user_.find(user.GetUserId());
     if (it == categories_by_user_.end()) return false;
 
     auto& user_categories = it->second;
     auto new_end = std::remove_if(user_categories.begin(), user_categories.end(),
-                                  [category_id](const Category& c) {
-                                      return c.GetCategoryId() == category_id;
+                                  [category_id](const std::shared_ptr<Category>& c) {
+                                      return c->GetCategoryId() == category_id;
                                   });
     if (new_end == user_categories.end()) {
         return false;  // 没找到
     }
 
     user_categories.erase(new_end, user_categories.end());
+    dirty_users_.insert(user.GetUserId());
     return true;
 }
 
 std::vector<Category> CategoryManager::GetCategoriesForUser(const User& user) const {
     auto it = categories_by_user_.find(user.GetUserId());
-    if (it == categories_by_user_.end()) return {};
-    return it->second;
+    if (it != categories_by_user_.end()) return Values(it->second);
+    // 懒加载模式下未加载的用户临时从存储读取，不常驻
+    if (lazy_loading_ && storage_) {
+        auto res = storage_->LoadCategoriesForUser(user.GetUserId());
+        if (res.first) return res.second;
+    }
+    return {};
 }
 
 const Category* CategoryManager::GetCategoryById(const User& user, int category_id) const {
@@ -78,21 +108,32 @@ const Category* CategoryManager::GetCategoryById(const User& user, int category_
 
     const auto& user_categories = it->second;
     for (const auto& c : user_categories) {
-        if (c.GetCategoryId() == category_id) {
-            return &c;
+        if (c->GetCategoryId() == category_id) {
+            return c.get();
         }
     }
     return nullptr;
 }
 
+std::shared_ptr<const Category> CategoryManager::GetSharedCategory(const User& user,
+                                                                   int category_id) const {
+    auto it = categories_by_user_.find(user.GetUserId());
+    if (it == categories_by_user_.end()) return nullptr;
+
+    for (const auto& c : it->second) {
+        if (c->GetCategoryId() == category_id) return c;
+    }
+    return nullptr;
+}
+
 const Category* CategoryManager::GetCategoryByName(const User& user, const std::string& name) const {
     auto it = categories_by_user_.find(user.GetUserId());
     if (it == categories_by_user_.end()) return nullptr;
 
     const auto& user_categories = it->second;
     for (const auto& c : user_categories) {
-        if (c.GetName() == name) {
-            return &c;
+        if (c->GetName() == name) {
+            return c.get();
         }
     }
     return nullptr;
@@ -104,26 +145,93 @@ bool CategoryManager::IsDuplicateCategoryName(const User& user, const std::strin
 
     const auto& user_categories = it->second;
     return std::any_of(user_categories.begin(), user_categories.end(),
-                       [&name](const Category& c) { return c.GetName() == name; });
+                       [&name](const std::shared_ptr<Category>& c) { return c->GetName() == name; });
 }
 
 // 以下持久化接口暂留空实现（JSON / DB 后期可扩展）
 bool CategoryManager::LoadFromStorage() {
     if (!storage_) return false;
     categories_by_user_.clear();
+    if (lazy_loading_) {
+        synced_ = true;
+        dirty_users_.clear();
+        return true;
+    }
     try {
         auto res = storage_->LoadCategoriesByUser();
         if (!res.first) return false;
-        categories_by_user_ = std::move(res.second);
+        for (auto& [user_id, categories] : res.second) {
+            categories_by_user_.emplace(user_id, MakeShared(std::move(categories)));
+        }
     } catch (...) {
         return false;
     }
+    synced_ = true;
+    dirty_users_.clear();
     return true;
 }
 
 bool CategoryManager::SaveToStorage() const {
     if (!storage_) return false;
-    return storage_->SaveCategoriesByUser(categories_by_user_);
+    if (synced_) {
+        if (dirty_users_.empty()) return true;
+        if (storage_->SupportsPartialSave()) {
+            std::map<int, std::vector<Category>> changed;
+            for (int user_id : dirty_users_) {
+                auto it = categories_by_user_.find(user_id);
+                if (it != categories_by_user_.end()) changed.emplace(user_id, Values(it->second));
+            }
+            if (!storage_->SaveCategoriesForUsers(changed)) return false;
+            dirty_users_.clear();
+            return true;
+        }
+    }
+    if (lazy_loading_) {
+        // 未加载的用户从存储读取，再覆盖上内存中的数据
+        auto res = storage_->LoadCategoriesByUser();
+        if (!res.first) return false;
+        for (const auto& [user_id, categories] : categories_by_user_) {
+            res.second[user_id] = Values(categories);
+        }
+        if (!storage_->SaveCategoriesByUser(res.second)) return false;
+    } else {
+        std::map<int, std::vector<Category>> all;
+        for (const auto& [user_id, categories] : categories_by_user_) {
+            all.emplace(user_id, Values(categories));
+        }
+        if (!storage_->SaveCategoriesByUser(all)) return false;
+    }
+    synced_ = true;
+    dirty_users_.clear();
+    return true;
+}
+
+// ===== 按用户加载 =====
+bool CategoryManager::LoadUser(int user_id) {
+    if (IsUserLoaded(user_id)) return true;
+    if (!storage_) return false;
+    try {
+        auto res = storage_->LoadCategoriesForUser(user_id);
+        if (!res.first) return false;
+        categories_by_user_[user_id] = MakeShared(std::move(res.second));
+    } catch (...) {
+        return false;
+    }
+    return true;
+}
+
+bool CategoryManager::EvictUser(int user_id) {
+    if (!CanEvictUser(user_id)) return false;
+    categories_by_user_.erase(user_id);
+    return true;
+}
+
+bool CategoryManager::CanEvictUser(int user_id) const {
+    return lazy_loading_ && !dirty_users_.count(user_id);
+}
+
+bool CategoryManager::IsUserLoaded(int user_id) const {
+    return !lazy_loading_ || categories_by_user_.count(user_id) > 0;
 }
 
 }  // namespace accounting
@@ -1,10 +1,12 @@
 #include "managers/report_manager.h"
 #include <stdexcept>
 
+#include "utils/time_utils.h"
+
 namespace accounting {
 
-ReportManager::ReportManager(BillManager* bill_manager)
-    : bill_manager_(bill_manager) {
+ReportManager::ReportManager(BillManager* bill_manager, const ReportCacheOptions& cache_options)
+    : bill_manager_(bill_manager), cache_options_(cache_options) {
     if (!bill_manager_) {
         throw std::invalid_argument("BillManager pointer cannot be null.");
     }
@@ -14,52 +16,152 @@ Report ReportManager::GenerateReport(int user_id,
                                      const QueryCriteria& criteria,
                                      Period period,
                                      ChartType chart_type) {
-    // 从 BillManager 获取用户账单
-    std::vector<Bill> bills = bill_manager_->GetBillsByUser(user_id);
+    const uint64_t version = bill_manager_->DataVersion(user_id);
+    std::string key = std::to_string(user_id) + '|' + std::to_string(static_cast<int>(period)) +
+                      '|' + std::to_string(static_cast<int>(chart_type)) + '|' +
+                      criteria.CacheKey();
 
-    // 将 Bill 转为 BillData，获取分类信息
-    std::vector<BillData> bill_data_list;
-    for (const auto& bill : bills) {
-        std::string category_name = "";
-        std::string category_type = "";  // 新增：获取分类类型
-        
-        if (bill.GetCategory()) {
-            category_name = bill.GetCategory()->GetName();
-            category_type = bill.GetCategory()->GetType();  // 新增：从 Category 获取 type
+    auto cached = cache_index_.find(key);
+    if (cached != cache_index_.end()) {
+        if (cached->second->version == version) {
+            lru_.splice(lru_.begin(), lru_, cached->second);
+            last_reports_[user_id] = cached->second->report;
+            return cached->second->report;
         }
-        
-        bill_data_list.emplace_back(bill.GetAmount(),
-                                    category_name,
-                                    category_type,  // 新增：传递分类类型
-                                    bill.GetTime(),
-                                    bill.GetContent());
+        EraseEntry(cached->second);  // 账单已修改，缓存过期
     }
 
-    // 生成报表
-    Report report = Report::Generate(bill_data_list, criteria, period, chart_type);
-
-    // 缓存到 reports_
-    reports_[user_id].push_back(report);
+    Report report = BuildReport(user_id, criteria, period, chart_type);
+    last_reports_[user_id] = report;
+    if (cache_options_.max_entries > 0) {
+        const size_t bytes = EstimateBytes(report) + key.size();
+        lru_.push_front({key, user_id, version, report, bytes});
+        cache_index_.emplace(std::move(key), lru_.begin());
+        cache_bytes_ += bytes;
+        Shrink();
+    }
+    return report;
+}
 
+Report ReportManager::BuildReport(int user_id, const QueryCriteria& criteria, Period period,
+                                  ChartType chart_type) const {
+    Report report;
+    int64_t first_day = 0;
+    int64_t last_day = 0;
+    if (WholeDayRange(user_id, criteria, first_day, last_day)) {
+        // 不过滤或只按整天过滤时由 BillManager 的按日汇总生成，不访问账单：
+        // 不分时间段时每个分类一项，否则每个分类每天一项
+        ReportBuilder builder(period);
+        if (period == Period::kCustom) {
+            bill_manager_->ForEachCategoryTotalInDays(
+                user_id, first_day, last_day,
+                [&builder](int category_id, const Category* category,
+                           const BillManager::CategoryTotal& total) {
+                    builder.Add(0, total.total, category_id, category);
+                });
+        } else {
+            bill_manager_->ForEachDailyTotal(
+                user_id, first_day, last_day,
+                [&builder](int category_id, const Category* category, int64_t day,
+                           const BillManager::CategoryTotal& total) {
+                    builder.Add(day, total.total, category_id, category);
+                });
+        }
+        report = builder.Build(chart_type);
+    } else {
+        // 由 BillManager 按查询计划选出账单，直接在账单视图上按分类 id 累加：
+        // 不构造 BillData，不逐个账单复制分类名称、类型和备注
+        ReportBuilder builder(period);
+        const bool bucketed = period != Period::kCustom;
+        bill_manager_->ForEachBillMatching(user_id, criteria, [&](const BillView& bill) {
+            const int64_t day = bucketed ? time_utils::LocalDayNumber(bill.time) : 0;
+            builder.Add(day, bill.amount, bill.category_id, bill.category);
+        });
+        report = builder.Build(chart_type);
+    }
     return report;
 }
 
+bool ReportManager::WholeDayRange(int user_id, const QueryCriteria& criteria,
+                                  int64_t& first_day, int64_t& last_day) const {
+    using TimePoint = std::chrono::system_clock::time_point;
+    QueryCriteria rest = criteria;
+    rest.SetStartDate(TimePoint::min());
+    rest.SetEndDate(TimePoint::max());
+    if (rest.HasFilters() || criteria.GetLimit() > 0) return false;
+
+    first_day = BillRollup::kFirstDay;
+    last_day = BillRollup::kLastDay;
+    const TimePoint start = criteria.GetStartDate();
+    const TimePoint end = criteria.GetEndDate();
+    if (start != TimePoint::min()) {
+        // 起点须为某天的本地 0 点
+        first_day = time_utils::LocalDayNumber(start);
+        if (time_utils::LocalDayStart(first_day) != start) return false;
+    }
+    if (end != TimePoint::max()) {
+        // 终点须为某天的最后一刻（次日 0 点前一个时钟单位）；
+        // 否则（如精确到秒的 23:59:59）终点之后到次日 0 点之间须没有账单
+        last_day = time_utils::LocalDayNumber(end);
+        const TimePoint next_day = time_utils::LocalDayStart(last_day + 1);
+        if (next_day - end != TimePoint::duration(1)) {
+            // 未常驻的用户检查时要读取全部账单，不如直接逐个账单汇总
+            if (!bill_manager_->IsUserLoaded(user_id)) return false;
+            bool gap_empty = true;
+            bill_manager_->ForEachBillInTimeRange(
+                user_id, end + TimePoint::duration(1), next_day - TimePoint::duration(1),
+                [&gap_empty](const BillView&) { gap_empty = false; });
+            if (!gap_empty) return false;
+        }
+    }
+    return true;
+}
+
 std::optional<Report> ReportManager::GetLastReport(int user_id) const {
-    auto it = reports_.find(user_id);
-    if (it == reports_.end() || it->second.empty()) {
+    auto it = last_reports_.find(user_id);
+    if (it == last_reports_.end()) {
         return std::nullopt;
     }
-    return it->second.back();
+    return it->second;
 }
 
-const std::vector<Report>& ReportManager::GetReportsByUser(int user_id) const {
-    static const std::vector<Report> kEmpty;  // 用于返回空引用
-    auto it = reports_.find(user_id);
-    return (it != reports_.end()) ? it->second : kEmpty;
+void ReportManager::ClearReports(int user_id) {
+    last_reports_.erase(user_id);
+    for (auto it = lru_.begin(); it != lru_.end();) {
+        auto next = std::next(it);
+        if (it->user_id == user_id) EraseEntry(it);
+        it = next;
+    }
 }
 
-void ReportManager::ClearReports(int user_id) {
-    reports_.erase(user_id);
+size_t ReportManager::EstimateBytes(const Report& report) {
+    // 哈希表每个节点另计约 64 字节的指针与桶开销
+    constexpr size_t kNodeOverhead = 64;
+    size_t bytes = sizeof(Report);
+    for (const auto& [category, _] : report.GetCategorySummary()) {
+        bytes += kNodeOverhead + category.capacity();
+    }
+    for (const auto& bucket : report.GetSeries()) {
+        bytes += sizeof(ReportBucket) + bucket.label.capacity();
+        for (const auto& [category, _] : bucket.category_summary) {
+            bytes += kNodeOverhead + category.capacity();
+        }
+    }
+    return bytes;
+}
+
+void ReportManager::EraseEntry(CacheList::iterator entry) {
+    cache_bytes_ -= entry->bytes;
+    cache_index_.erase(entry->key);
+    lru_.erase(entry);
+}
+
+void ReportManager::Shrink() {
+    // 超过上限的单个报表也不保留
+    while (!lru_.empty() && (lru_.size() > cache_options_.max_entries ||
+                             cache_bytes_ > cache_options_.max_bytes)) {
+        EraseEntry(std::prev(lru_.end()));
+    }
 }
 
 }  // namespace accounting
@@ -11,6 +11,7 @@ bool UserManager::RegisterUser(const std::string& username, const std::string& p
     User user(new_id, username);
     user.SetPassword(password);
     users_[username] = user;
+    dirty_ = true;
     return true;
 }
 
@@ -39,6 +40,7 @@ bool UserManager::SavePreferences(int user_id, const std::map<std::string, std::
             for (const auto& [key, value] : preferences) {
                 user.SetPreference(key, value);
             }
+            dirty_ = true;
             return true;
         }
     }
@@ -58,16 +60,22 @@ bool UserManager::LoadFromStorage(std::shared_ptr<Storage> storage) {
     } catch (...) {
         return false;
     }
+    synced_storage_ = storage;
+    dirty_ = false;
     return true;
 }
 
 bool UserManager::SaveToStorage(std::shared_ptr<Storage> storage) const {
     if (!storage) return false;
+    if (!dirty_ && storage == synced_storage_) return true;
     std::vector<User> user_list;
     for (const auto& [username, user] : users_) {
         user_list.push_back(user);
     }
-    return storage->SaveUsers(user_list);
+    if (!storage->SaveUsers(user_list)) return false;
+    synced_storage_ = storage;
+    dirty_ = false;
+    return true;
 }
 
 int UserManager::GenerateNextUserId() const {
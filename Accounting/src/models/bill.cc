@@ -1,4 +1,5 @@
 #include "models/bill.h"
+#include "utils/time_utils.h"
 #include <iomanip>
 #include <sstream>
 
@@ -7,7 +8,7 @@ namespace accounting {
 // 默认构造
 Bill::Bill()
     : bill_id_(0),
-    amount_(0.0),
+    amount_(),
     category_(nullptr),
     category_id_(-1),
     time_(std::chrono::system_clock::now()),
@@ -15,11 +16,11 @@ Bill::Bill()
 
 // 带参构造
 Bill::Bill(int bill_id, double amount,
-           std::shared_ptr<Category> category,
+           std::shared_ptr<const Category> category,
            const std::chrono::system_clock::time_point& time,
            const std::string& content)
     : bill_id_(bill_id),
-    amount_(amount),
+    amount_(Money::FromDouble(amount)),
     category_(category),
     category_id_((category) ? category->GetCategoryId() : -1),
     time_(time),
@@ -28,11 +29,13 @@ Bill::Bill(int bill_id, double amount,
 int Bill::GetBillId() const { return bill_id_; }
 void Bill::SetBillId(int id) { bill_id_ = id; }
 
-double Bill::GetAmount() const { return amount_; }
-void Bill::SetAmount(double amount) { amount_ = amount; }
+double Bill::GetAmount() const { return amount_.ToDouble(); }
+void Bill::SetAmount(double amount) { amount_ = Money::FromDouble(amount); }
+Money Bill::GetMoney() const { return amount_; }
+void Bill::SetMoney(Money amount) { amount_ = amount; }
 
-std::shared_ptr<Category> Bill::GetCategory() const { return category_; }
-void Bill::SetCategory(const std::shared_ptr<Category>& category) { 
+const std::shared_ptr<const Category>& Bill::GetCategory() const { return category_; }
+void Bill::SetCategory(const std::shared_ptr<const Category>& category) { 
     category_ = category; 
     category_id_ = category ? category->GetCategoryId() : -1;
 }
@@ -50,16 +53,14 @@ void Bill::SetContent(const std::string& content) { content_ = content; }
 // 调试输出
 std::string Bill::ToString() const {
     std::ostringstream oss;
-    // 将时间转换为可读字符串
-    std::time_t t = std::chrono::system_clock::to_time_t(time_);
     oss << "Bill(ID: " << bill_id_
-        << ", Amount: " << amount_;
+        << ", Amount: " << amount_.ToString();
     if (category_) {
         oss << ", Category: " << category_->GetName();
     } else {
         oss << ", Category: NULL";
     }
-    oss << ", Time: " << std::put_time(std::localtime(&t), "%F %T")
+    oss << ", Time: " << time_utils::FormatDateTime(time_)
         << ", Content: " << content_
         << ")";
     return oss.str();
@@ -67,21 +68,18 @@ std::string Bill::ToString() const {
 
 // ===== JSON 序列化实现 =====
 
-// 时间转换辅助函数
-static std::string TimePointToString(const std::chrono::system_clock::time_point& tp) {
-    std::time_t t = std::chrono::system_clock::to_time_t(tp);
-    std::tm tm = *std::localtime(&t);
-    char buf[32];
-    std::strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", &tm);
-    return buf;
+// 时间转换辅助函数（固定格式手写解析，避免 istringstream / get_time / mktime 的开销）
+std::string BillTimeToString(const std::chrono::system_clock::time_point& tp) {
+    return time_utils::FormatDateTime(tp);
 }
 
-static std::chrono::system_clock::time_point StringToTimePoint(const std::string& s) {
-    std::tm tm{};
-    std::istringstream ss(s);
-    ss >> std::get_time(&tm, "%Y-%m-%d %H:%M:%S");
-    auto t = std::mktime(&tm);
-    return std::chrono::system_clock::from_time_t(t);
+std::chrono::system_clock::time_point BillTimeFromString(const std::string& s) {
+    time_utils::CivilTime local;
+    // 格式不符时退化为纪元时间，与旧实现一样不让整个文件加载失败
+    if (!time_utils::ParseDateTime(s.data(), s.size(), local)) {
+        return std::chrono::system_clock::time_point();
+    }
+    return time_utils::LocalToTimePoint(local);
 }
 
 void to_json(json& j, const Bill& b) {
@@ -90,16 +88,16 @@ void to_json(json& j, const Bill& b) {
         {"amount", b.amount_},
         // 保存 category_id（优先使用 shared_ptr 的 id，否则使用存储的 category_id_）
         {"category_id", b.category_ ? b.category_->GetCategoryId() : b.category_id_},
-        {"time", TimePointToString(b.time_)},
+        {"time", BillTimeToString(b.time_)},
         {"content", b.content_}
     };
 }
 
 void from_json(const json& j, Bill& b) {
     b.bill_id_ = j.at("bill_id").get<int>();
-    b.amount_ = j.at("amount").get<double>();
+    b.amount_ = j.at("amount").get<Money>();
     b.content_ = j.at("content").get<std::string>();
-    b.time_ = StringToTimePoint(j.at("time").get<std::string>());
+    b.time_ = BillTimeFromString(j.at("time").get<std::string>());
 
     // 只读取 category_id，暂时不创建 category_ 指针（由 BillManager 恢复）
     int category_id = -1;
@@ -5,7 +5,7 @@
 namespace accounting {
 
 BillData::BillData()
-    : amount_(0.0),
+    : amount_(),
       category_name_(""),
       category_type_(""),
       time_(std::chrono::system_clock::now()),
@@ -15,14 +15,26 @@ BillData::BillData(double amount, const std::string& category_name,
                    const std::string& category_type,
                    const std::chrono::system_clock::time_point& time,
                    const std::string& content)
+    : amount_(Money::FromDouble(amount)),
+      category_name_(category_name),
+      category_type_(category_type),
+      time_(time),
+      content_(content) {}
+
+BillData::BillData(Money amount, const std::string& category_name,
+                   const std::string& category_type,
+                   const std::chrono::system_clock::time_point& time,
+                   const std::string& content)
     : amount_(amount),
       category_name_(category_name),
       category_type_(category_type),
       time_(time),
       content_(content) {}
 
-double BillData::GetAmount() const { return amount_; }
-void BillData::SetAmount(double amount) { amount_ = amount; }
+double BillData::GetAmount() const { return amount_.ToDouble(); }
+void BillData::SetAmount(double amount) { amount_ = Money::FromDouble(amount); }
+Money BillData::GetMoney() const { return amount_; }
+void BillData::SetMoney(Money amount) { amount_ = amount; }
 
 const std::string& BillData::GetCategoryName() const { return category_name_; }
 void BillData::SetCategoryName(const std::string& category_name) { 
@@ -45,7 +57,7 @@ void BillData::SetContent(const std::string& content) { content_ = content; }
 std::string BillData::ToString() const {
     std::ostringstream oss;
     std::time_t t = std::chrono::system_clock::to_time_t(time_);
-    oss << "BillData(Amount: " << amount_
+    oss << "BillData(Amount: " << amount_.ToString()
         << ", Category: " << category_name_
         << ", Type: " << category_type_
         << ", Time: " << std::put_time(std::localtime(&t), "%F %T")
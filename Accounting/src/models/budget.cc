@@ -5,43 +5,61 @@
 namespace accounting {
 
 // 默认构造
-Budget::Budget() : total_limit_(0.0) {}
+Budget::Budget() : total_limit_() {}
 
 // 带参构造
 Budget::Budget(double total_limit, const std::unordered_map<int, double>& category_limits)
-    : total_limit_(total_limit), category_limits_(category_limits) {}
+    : total_limit_(Money::FromDouble(total_limit)) {
+    for (const auto& [category_id, limit] : category_limits) {
+        category_limits_[category_id] = Money::FromDouble(limit);
+    }
+}
 
 // Getter / Setter
-double Budget::GetTotalLimit() const { return total_limit_; }
-void Budget::SetTotalLimit(double limit) { total_limit_ = limit; }
+double Budget::GetTotalLimit() const { return total_limit_.ToDouble(); }
+void Budget::SetTotalLimit(double limit) { total_limit_ = Money::FromDouble(limit); }
+Money Budget::GetTotalLimitMoney() const { return total_limit_; }
 
-const std::unordered_map<int, double>& Budget::GetCategoryLimits() const {
-    return category_limits_;
+std::unordered_map<int, double> Budget::GetCategoryLimits() const {
+    std::unordered_map<int, double> limits;
+    limits.reserve(category_limits_.size());
+    for (const auto& [category_id, limit] : category_limits_) {
+        limits.emplace(category_id, limit.ToDouble());
+    }
+    return limits;
 }
 
 void Budget::SetCategoryLimit(int category_id, double limit) {
     // negative id treated as invalid
     if (category_id >= 0) {
-        category_limits_[category_id] = limit;
+        category_limits_[category_id] = Money::FromDouble(limit);
     }
 }
 
 double Budget::GetCategoryLimit(int category_id) const {
+    return GetCategoryLimitMoney(category_id).ToDouble();
+}
+
+Money Budget::GetCategoryLimitMoney(int category_id) const {
     auto it = category_limits_.find(category_id);
     if (it != category_limits_.end()) {
         return it->second;
     }
-    return 0.0;
+    return Money();
+}
+
+bool Budget::HasCategoryLimit(int category_id) const {
+    return category_limits_.count(category_id) > 0;
 }
 
 // 调试输出
 std::string Budget::ToString() const {
     std::ostringstream oss;
-    oss << "Budget(TotalLimit: " << total_limit_ << ", CategoryLimits: {";
+    oss << "Budget(TotalLimit: " << total_limit_.ToString() << ", CategoryLimits: {";
     bool first = true;
     for (const auto& [category_id, limit] : category_limits_) {
         if (!first) oss << ", ";
-        oss << category_id << ": " << limit;
+        oss << category_id << ": " << limit.ToString();
         first = false;
     }
     oss << "})";
@@ -65,7 +83,7 @@ void to_json(json& j, const Budget& b) {
 }
 
 void from_json(const json& j, Budget& b) {
-    b.total_limit_ = j.value("total_limit", 0.0);
+    b.total_limit_ = j.value("total_limit", Money());
     b.category_limits_.clear();
 
     if (j.contains("category_limits")) {
@@ -73,7 +91,7 @@ void from_json(const json& j, Budget& b) {
         if (arr.is_array()) {
             for (const auto& item : arr) {
                 int cid = item.value("category_id", -1);
-                double limit = item.value("limit", 0.0);
+                Money limit = item.value("limit", Money());
                 if (cid >= 0) b.category_limits_[cid] = limit;
             }
         } else if (arr.is_object()) {
@@ -82,7 +100,7 @@ void from_json(const json& j, Budget& b) {
                 // key is string, try parse as int
                 try {
                     int cid = std::stoi(it.key());
-                    double limit = it.value().get<double>();
+                    Money limit = it.value().get<Money>();
                     if (cid >= 0) b.category_limits_[cid] = limit;
                 } catch (...) {
                     // ignore non-int keys
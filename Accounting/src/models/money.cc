@@ -0,0 +1,103 @@
+#include "models/money.h"
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <stdexcept>
+
+namespace accounting {
+
+// 2^63：乘以 100 后的金额须落在 [-2^63, 2^63) 内，llround 的结果才有定义
+static constexpr double kCentsLimit = 9223372036854775808.0;
+
+bool Money::TryFromDouble(double amount, Money& out) {
+    // 先乘后取整：0.29 * 100 = 28.999... 也能得到 29
+    const double scaled = amount * kMinorPerMajor;
+    if (!(scaled >= -kCentsLimit && scaled < kCentsLimit)) return false;  // 含 NaN
+    out = Money(static_cast<int64_t>(std::llround(scaled)));
+    return true;
+}
+
+Money Money::FromDouble(double amount) {
+    Money money;
+    if (TryFromDouble(amount, money) || std::isnan(amount)) return money;
+    return Money(amount > 0 ? std::numeric_limits<int64_t>::max()
+                            : -std::numeric_limits<int64_t>::max());
+}
+
+bool Money::Parse(std::string_view text, Money& out) {
+    size_t pos = 0;
+    bool negative = false;
+    if (pos < text.size() && (text[pos] == '-' || text[pos] == '+')) {
+        negative = text[pos] == '-';
+        ++pos;
+    }
+
+    int64_t major = 0;
+    size_t digits = 0;
+    for (; pos < text.size() && text[pos] >= '0' && text[pos] <= '9'; ++pos, ++digits) {
+        if (major > (INT64_MAX / kMinorPerMajor - 9) / 10) return false;  // 溢出
+        major = major * 10 + (text[pos] - '0');
+    }
+
+    int64_t minor = 0;
+    if (pos < text.size() && text[pos] == '.') {
+        ++pos;
+        int64_t scale = kMinorPerMajor / 10;
+        bool round_up = false;
+        for (size_t i = 0; pos < text.size() && text[pos] >= '0' && text[pos] <= '9';
+             ++pos, ++i, ++digits) {
+            const int digit = text[pos] - '0';
+            if (scale > 0) {
+                minor += digit * scale;
+                scale /= 10;
+            } else if (i == 2) {
+                round_up = digit >= 5;  // 第三位小数决定进位
+            }
+        }
+        if (round_up) ++minor;
+    }
+    if (digits == 0 || pos != text.size()) return false;
+
+    const int64_t cents = major * kMinorPerMajor + minor;
+    out = Money(negative ? -cents : cents);
+    return true;
+}
+
+std::string Money::ToString() const {
+    const uint64_t abs = cents_ < 0 ? 0 - static_cast<uint64_t>(cents_)
+                                    : static_cast<uint64_t>(cents_);
+    std::string text = std::to_string(abs / kMinorPerMajor);
+    const auto minor = static_cast<unsigned>(abs % kMinorPerMajor);
+    text += '.';
+    text += static_cast<char>('0' + minor / 10);
+    text += static_cast<char>('0' + minor % 10);
+    return cents_ < 0 ? "-" + text : text;
+}
+
+// ===== JSON 序列化实现 =====
+void to_json(json& j, const Money& m) {
+    // 分 / 100 的 double 是最接近该十进制数的值，按最短形式输出后可精确读回
+    j = m.ToDouble();
+}
+
+void from_json(const json& j, Money& m) {
+    // 超出范围时抛出，由读取方按文件损坏处理，而不是得到回绕后的金额
+    constexpr int64_t kMaxMajor = std::numeric_limits<int64_t>::max() / Money::kMinorPerMajor;
+    if (j.is_number_unsigned()) {
+        const uint64_t major = j.get<uint64_t>();
+        if (major > static_cast<uint64_t>(kMaxMajor)) {
+            throw std::out_of_range("amount out of range");
+        }
+        m = Money::FromCents(static_cast<int64_t>(major) * Money::kMinorPerMajor);
+    } else if (j.is_number_integer()) {
+        const int64_t major = j.get<int64_t>();
+        if (major > kMaxMajor || major < -kMaxMajor) {
+            throw std::out_of_range("amount out of range");
+        }
+        m = Money::FromCents(major * Money::kMinorPerMajor);
+    } else if (!Money::TryFromDouble(j.get<double>(), m)) {
+        throw std::out_of_range("amount out of range");
+    }
+}
+
+}  // namespace accounting
@@ -1,43 +1,327 @@
 #include "models/query_criteria.h"
+#include <algorithm>
 #include <iomanip>
+#include <limits>
 #include <sstream>
 
 namespace accounting {
 
+namespace {
+
+const Money kMinMoney = Money::FromCents(std::numeric_limits<int64_t>::min());
+const Money kMaxMoney = Money::FromCents(std::numeric_limits<int64_t>::max());
+
+std::string FormatTime(const std::chrono::system_clock::time_point& tp) {
+    std::ostringstream oss;
+    std::time_t t = std::chrono::system_clock::to_time_t(tp);
+    oss << std::put_time(std::localtime(&t), "%F %T");
+    return oss.str();
+}
+
+void SortUnique(std::vector<int>& ids) {
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+}
+
+// ===== 缓存键的编码：整数以 ';' 结尾，字符串带长度前缀 =====
+void AppendInt(std::string& out, int64_t value) {
+    out += std::to_string(value);
+    out += ';';
+}
+
+void AppendString(std::string& out, const std::string& value) {
+    AppendInt(out, static_cast<int64_t>(value.size()));
+    out += value;
+}
+
+void AppendTime(std::string& out, const std::chrono::system_clock::time_point& tp) {
+    AppendInt(out, static_cast<int64_t>(tp.time_since_epoch().count()));
+}
+
+void AppendIds(std::string& out, const std::vector<int>& ids) {
+    AppendInt(out, static_cast<int64_t>(ids.size()));
+    for (int id : ids) AppendInt(out, id);
+}
+
+void AppendStrings(std::string& out, const std::vector<std::string>& values) {
+    AppendInt(out, static_cast<int64_t>(values.size()));
+    for (const auto& value : values) AppendString(out, value);
+}
+
+}  // namespace
+
+// ========================== QueryPredicate ==========================
+QueryPredicate::QueryPredicate() : op_(Op::kAll) {}
+
+QueryPredicate QueryPredicate::And(std::vector<QueryPredicate> children) {
+    QueryPredicate p(Op::kAnd);
+    p.children_ = std::move(children);
+    return p;
+}
+
+QueryPredicate QueryPredicate::Or(std::vector<QueryPredicate> children) {
+    QueryPredicate p(Op::kOr);
+    p.children_ = std::move(children);
+    return p;
+}
+
+QueryPredicate QueryPredicate::Not(QueryPredicate child) {
+    QueryPredicate p(Op::kNot);
+    p.children_.push_back(std::move(child));
+    return p;
+}
+
+QueryPredicate QueryPredicate::TimeRange(const std::chrono::system_clock::time_point& start,
+                                         const std::chrono::system_clock::time_point& end) {
+    QueryPredicate p(Op::kTimeRange);
+    p.start_ = start;
+    p.end_ = end;
+    return p;
+}
+
+QueryPredicate QueryPredicate::AmountRange(Money min, Money max) {
+    QueryPredicate p(Op::kAmountRange);
+    p.min_amount_ = min;
+    p.max_amount_ = max;
+    return p;
+}
+
+QueryPredicate QueryPredicate::CategoryIds(std::vector<int> category_ids) {
+    QueryPredicate p(Op::kCategoryIds);
+    p.ids_ = std::move(category_ids);
+    SortUnique(p.ids_);
+    return p;
+}
+
+QueryPredicate QueryPredicate::CategoryNames(std::vector<std::string> category_names) {
+    QueryPredicate p(Op::kCategoryNames);
+    p.names_ = std::move(category_names);
+    return p;
+}
+
+QueryPredicate QueryPredicate::CategoryType(const std::string& category_type) {
+    QueryPredicate p(Op::kCategoryType);
+    p.text_ = category_type;
+    return p;
+}
+
+QueryPredicate QueryPredicate::ContentContains(const std::string& text) {
+    QueryPredicate p(Op::kContentContains);
+    p.text_ = text;
+    return p;
+}
+
+QueryPredicate QueryPredicate::BillIds(std::vector<int> bill_ids) {
+    QueryPredicate p(Op::kBillIds);
+    p.ids_ = std::move(bill_ids);
+    SortUnique(p.ids_);
+    return p;
+}
+
+bool QueryPredicate::Matches(const QueryRow& row) const {
+    switch (op_) {
+        case Op::kAll:
+            return true;
+        case Op::kAnd:
+            for (const auto& child : children_) {
+                if (!child.Matches(row)) return false;
+            }
+            return true;
+        case Op::kOr:
+            for (const auto& child : children_) {
+                if (child.Matches(row)) return true;
+            }
+            return false;
+        case Op::kNot:
+            return !children_.front().Matches(row);
+        case Op::kTimeRange:
+            return row.time >= start_ && row.time <= end_;
+        case Op::kAmountRange:
+            return row.amount >= min_amount_ && row.amount <= max_amount_;
+        case Op::kCategoryIds:
+            return std::binary_search(ids_.begin(), ids_.end(), row.category_id);
+        case Op::kCategoryNames:
+            return !row.category_name.empty() &&
+                   std::find(names_.begin(), names_.end(), row.category_name) != names_.end();
+        case Op::kCategoryType:
+            return row.category_type == text_;
+        case Op::kContentContains:
+            return row.content.find(text_) != std::string_view::npos;
+        case Op::kBillIds:
+            return std::binary_search(ids_.begin(), ids_.end(), row.bill_id);
+    }
+    return false;
+}
+
+std::string QueryPredicate::ToString() const {
+    std::ostringstream oss;
+    auto join_ids = [&oss](const std::vector<int>& ids) {
+        for (size_t i = 0; i < ids.size(); ++i) oss << (i ? ", " : "") << ids[i];
+    };
+    switch (op_) {
+        case Op::kAll:
+            oss << "All";
+            break;
+        case Op::kAnd:
+        case Op::kOr:
+            oss << (op_ == Op::kAnd ? "And(" : "Or(");
+            for (size_t i = 0; i < children_.size(); ++i) {
+                oss << (i ? ", " : "") << children_[i].ToString();
+            }
+            oss << ")";
+            break;
+        case Op::kNot:
+            oss << "Not(" << children_.front().ToString() << ")";
+            break;
+        case Op::kTimeRange:
+            oss << "Time[" << FormatTime(start_) << " to " << FormatTime(end_) << "]";
+            break;
+        case Op::kAmountRange:
+            oss << "Amount[" << min_amount_.ToString() << ", " << max_amount_.ToString() << "]";
+            break;
+        case Op::kCategoryIds:
+            oss << "CategoryId{";
+            join_ids(ids_);
+            oss << "}";
+            break;
+        case Op::kCategoryNames:
+            oss << "Category{";
+            for (size_t i = 0; i < names_.size(); ++i) oss << (i ? ", " : "") << names_[i];
+            oss << "}";
+            break;
+        case Op::kCategoryType:
+            oss << "Type=" << text_;
+            break;
+        case Op::kContentContains:
+            oss << "Content~\"" << text_ << "\"";
+            break;
+        case Op::kBillIds:
+            oss << "BillId{";
+            join_ids(ids_);
+            oss << "}";
+            break;
+    }
+    return oss.str();
+}
+
+std::string QueryPredicate::CacheKey() const {
+    std::string out;
+    AppendCacheKey(out);
+    return out;
+}
+
+void QueryPredicate::AppendCacheKey(std::string& out) const {
+    AppendInt(out, static_cast<int64_t>(op_));
+    switch (op_) {
+        case Op::kAll:
+            break;
+        case Op::kAnd:
+        case Op::kOr:
+        case Op::kNot:
+            AppendInt(out, static_cast<int64_t>(children_.size()));
+            for (const auto& child : children_) child.AppendCacheKey(out);
+            break;
+        case Op::kTimeRange:
+            AppendTime(out, start_);
+            AppendTime(out, end_);
+            break;
+        case Op::kAmountRange:
+            AppendInt(out, min_amount_.Cents());
+            AppendInt(out, max_amount_.Cents());
+            break;
+        case Op::kCategoryIds:
+        case Op::kBillIds:
+            AppendIds(out, ids_);
+            break;
+        case Op::kCategoryNames:
+            AppendStrings(out, names_);
+            break;
+        case Op::kCategoryType:
+        case Op::kContentContains:
+            AppendString(out, text_);
+            break;
+    }
+}
+
+// ========================== QueryCriteria ==========================
 QueryCriteria::QueryCriteria()
     : start_date_(std::chrono::system_clock::time_point::min()),
       end_date_(std::chrono::system_clock::time_point::max()),
-      category_name_("") {}
+      min_amount_(kMinMoney),
+      max_amount_(kMaxMoney) {}
 
 QueryCriteria::QueryCriteria(const std::chrono::system_clock::time_point& start_date,
                              const std::chrono::system_clock::time_point& end_date,
                              const std::string& category_name)
     : start_date_(start_date),
       end_date_(end_date),
-      category_name_(category_name) {}
+      min_amount_(kMinMoney),
+      max_amount_(kMaxMoney) {
+    SetCategoryName(category_name);
+}
 
-std::chrono::system_clock::time_point QueryCriteria::GetStartDate() const { 
-    return start_date_; 
+std::chrono::system_clock::time_point QueryCriteria::GetStartDate() const {
+    return start_date_;
 }
 
 void QueryCriteria::SetStartDate(const std::chrono::system_clock::time_point& start_date) {
     start_date_ = start_date;
 }
 
-std::chrono::system_clock::time_point QueryCriteria::GetEndDate() const { 
-    return end_date_; 
+std::chrono::system_clock::time_point QueryCriteria::GetEndDate() const {
+    return end_date_;
 }
 
 void QueryCriteria::SetEndDate(const std::chrono::system_clock::time_point& end_date) {
     end_date_ = end_date;
 }
 
-const std::string& QueryCriteria::GetCategoryName() const { 
-    return category_name_; 
+const std::string& QueryCriteria::GetCategoryName() const {
+    static const std::string kEmpty;
+    return category_names_.empty() ? kEmpty : category_names_.front();
 }
 
 void QueryCriteria::SetCategoryName(const std::string& category_name) {
-    category_name_ = category_name;
+    category_names_.clear();
+    if (!category_name.empty()) category_names_.push_back(category_name);
+}
+
+void QueryCriteria::AddCategoryName(const std::string& category_name) {
+    if (!category_name.empty()) category_names_.push_back(category_name);
+}
+
+void QueryCriteria::AddCategoryId(int category_id) {
+    category_ids_.push_back(category_id);
+}
+
+void QueryCriteria::SetAmountRange(Money min_amount, Money max_amount) {
+    min_amount_ = min_amount;
+    max_amount_ = max_amount;
+}
+
+void QueryCriteria::SetCategoryType(const std::string& category_type) {
+    category_type_ = category_type;
+}
+
+void QueryCriteria::SetContentContains(const std::string& text) {
+    content_contains_ = text;
+}
+
+void QueryCriteria::AddBillId(int bill_id) {
+    bill_ids_.push_back(bill_id);
+}
+
+void QueryCriteria::SetWhere(QueryPredicate where) {
+    where_ = std::move(where);
+}
+
+void QueryCriteria::SetSort(SortField field, bool descending) {
+    sort_field_ = field;
+    descending_ = descending;
+}
+
+void QueryCriteria::SetLimit(size_t limit) {
+    limit_ = limit;
 }
 
 bool QueryCriteria::HasDateRange() const {
@@ -46,33 +330,103 @@ bool QueryCriteria::HasDateRange() const {
 }
 
 bool QueryCriteria::HasCategoryFilter() const {
-    return !category_name_.empty();
+    return !category_names_.empty() || !category_ids_.empty();
 }
 
-std::string QueryCriteria::ToString() const {
-    std::ostringstream oss;
-    
-    oss << "QueryCriteria(";
-    
-    if (HasDateRange()) {
-        std::time_t start_t = std::chrono::system_clock::to_time_t(start_date_);
-        std::time_t end_t = std::chrono::system_clock::to_time_t(end_date_);
-        oss << "DateRange: [" << std::put_time(std::localtime(&start_t), "%F %T")
-            << " to " << std::put_time(std::localtime(&end_t), "%F %T") << "]";
+bool QueryCriteria::HasAmountRange() const {
+    return min_amount_ != kMinMoney || max_amount_ != kMaxMoney;
+}
+
+bool QueryCriteria::HasBillIdFilter() const {
+    return !bill_ids_.empty();
+}
+
+bool QueryCriteria::HasFilters() const {
+    return HasDateRange() || HasAmountRange() || HasCategoryFilter() || !category_type_.empty() ||
+           !content_contains_.empty() || HasBillIdFilter() || !where_.IsAll();
+}
+
+bool QueryCriteria::Matches(const QueryRow& row) const {
+    if (HasDateRange() && (row.time < start_date_ || row.time > end_date_)) return false;
+    if (row.amount < min_amount_ || row.amount > max_amount_) return false;
+    if (HasCategoryFilter()) {
+        const bool by_id = std::find(category_ids_.begin(), category_ids_.end(),
+                                     row.category_id) != category_ids_.end();
+        const bool by_name = !row.category_name.empty() &&
+                             std::find(category_names_.begin(), category_names_.end(),
+                                       row.category_name) != category_names_.end();
+        if (!by_id && !by_name) return false;
+    }
+    if (!category_type_.empty() && row.category_type != category_type_) return false;
+    if (!content_contains_.empty() &&
+        row.content.find(content_contains_) == std::string_view::npos) {
+        return false;
+    }
+    if (HasBillIdFilter() &&
+        std::find(bill_ids_.begin(), bill_ids_.end(), row.bill_id) == bill_ids_.end()) {
+        return false;
     }
-    
+    return where_.Matches(row);
+}
+
+QueryPredicate QueryCriteria::ToPredicate() const {
+    std::vector<QueryPredicate> terms;
+    if (HasDateRange()) terms.push_back(QueryPredicate::TimeRange(start_date_, end_date_));
+    if (HasAmountRange()) terms.push_back(QueryPredicate::AmountRange(min_amount_, max_amount_));
     if (HasCategoryFilter()) {
-        if (HasDateRange()) oss << ", ";
-        oss << "Category: " << category_name_;
+        std::vector<QueryPredicate> categories;
+        if (!category_ids_.empty()) categories.push_back(QueryPredicate::CategoryIds(category_ids_));
+        if (!category_names_.empty()) {
+            categories.push_back(QueryPredicate::CategoryNames(category_names_));
+        }
+        terms.push_back(categories.size() == 1 ? std::move(categories.front())
+                                               : QueryPredicate::Or(std::move(categories)));
     }
-    
-    if (!HasDateRange() && !HasCategoryFilter()) {
-        oss << "No filters";
+    if (!category_type_.empty()) terms.push_back(QueryPredicate::CategoryType(category_type_));
+    if (!content_contains_.empty()) {
+        terms.push_back(QueryPredicate::ContentContains(content_contains_));
     }
-    
+    if (HasBillIdFilter()) terms.push_back(QueryPredicate::BillIds(bill_ids_));
+    if (!where_.IsAll()) terms.push_back(where_);
+
+    if (terms.empty()) return QueryPredicate();
+    if (terms.size() == 1) return std::move(terms.front());
+    return QueryPredicate::And(std::move(terms));
+}
+
+std::string QueryCriteria::CacheKey() const {
+    std::string out;
+    AppendTime(out, start_date_);
+    AppendTime(out, end_date_);
+    AppendStrings(out, category_names_);
+    AppendIds(out, category_ids_);
+    AppendInt(out, min_amount_.Cents());
+    AppendInt(out, max_amount_.Cents());
+    AppendString(out, category_type_);
+    AppendString(out, content_contains_);
+    AppendIds(out, bill_ids_);
+    out += where_.CacheKey();
+    AppendInt(out, static_cast<int64_t>(sort_field_));
+    AppendInt(out, descending_ ? 1 : 0);
+    AppendInt(out, static_cast<int64_t>(limit_));
+    return out;
+}
+
+std::string QueryCriteria::ToString() const {
+    std::ostringstream oss;
+
+    oss << "QueryCriteria(";
+
+    const QueryPredicate predicate = ToPredicate();
+    oss << (predicate.IsAll() ? "No filters" : predicate.ToString());
+
+    oss << ", Sort: " << (sort_field_ == SortField::kTime ? "time" : "amount")
+        << (descending_ ? " desc" : " asc");
+    if (limit_ > 0) oss << ", Limit: " << limit_;
+
     oss << ")";
-    
+
     return oss.str();
 }
 
-}  // namespace accounting
\ No newline at end of file
+}  // namespace accounting
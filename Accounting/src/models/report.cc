@@ -2,6 +2,11 @@
 #include <sstream>
 #include <iomanip>
 #include <algorithm>
+#include <cstdio>
+#include <utility>
+
+#include "models/category.h"
+#include "utils/time_utils.h"
 
 namespace accounting {
 
@@ -9,8 +14,8 @@ Report::Report()
     : period_(Period::kMonthly),
       chart_type_(ChartType::kBar),
       category_summary_(),
-      total_income_(0.0),
-      total_expense_(0.0) {}
+      total_income_(),
+      total_expense_() {}
 
 Report::Report(Period period,
                ChartType chart_type,
@@ -18,57 +23,189 @@ Report::Report(Period period,
     : period_(period),
       chart_type_(chart_type),
       category_summary_(category_summary),
-      total_income_(0.0),
-      total_expense_(0.0) {}
+      total_income_(),
+      total_expense_() {}
 
 // 匹配函数：判断某笔账单是否符合查询条件
+// BillData 不带分类 id 和账单 id，按 id 的条件在这里不会命中；需要时先用 BillManager 过滤
 bool Report::MatchCriteria(const BillData& bill, const QueryCriteria& criteria) {
-    // 日期范围过滤
-    auto time = bill.GetTime();
-    if (criteria.HasDateRange()) {
-        if (time < criteria.GetStartDate() || time > criteria.GetEndDate()) {
-            return false;
+    QueryRow row;
+    row.amount = bill.GetMoney();
+    row.time = bill.GetTime();
+    row.category_name = bill.GetCategoryName();
+    row.category_type = bill.GetCategoryType();
+    row.content = bill.GetContent();
+    return criteria.Matches(row);
+}
+
+namespace {
+
+// 包含本地日期 day 的时间段 [first, next)，均为 1970-01-01 起的天数
+std::pair<int64_t, int64_t> BucketRange(Period period, int64_t day) {
+    int year = 0;
+    int month = 0;
+    int mday = 0;
+    switch (period) {
+        case Period::kDaily:
+            return {day, day + 1};
+        case Period::kWeekly: {
+            // 1970-01-01 是周四；按周一对齐
+            const int64_t first = day - (((day + 3) % 7) + 7) % 7;
+            return {first, first + 7};
         }
+        case Period::kMonthly:
+            time_utils::CivilFromDays(day, year, month, mday);
+            return {time_utils::DaysFromCivil(year, month, 1),
+                    time_utils::DaysFromCivil(year, month + 1, 1)};
+        case Period::kYearly:
+            time_utils::CivilFromDays(day, year, month, mday);
+            return {time_utils::DaysFromCivil(year, 1, 1), time_utils::DaysFromCivil(year + 1, 1, 1)};
+        case Period::kCustom:
+            break;
     }
+    return {day, day + 1};
+}
 
-    // 分类过滤
-    if (criteria.HasCategoryFilter()) {
-        if (bill.GetCategoryName() != criteria.GetCategoryName()) {
-            return false;
-        }
+std::string BucketLabel(Period period, int64_t first_day) {
+    int year = 0;
+    int month = 0;
+    int day = 0;
+    time_utils::CivilFromDays(first_day, year, month, day);
+    char buf[16];
+    if (period == Period::kYearly) {
+        std::snprintf(buf, sizeof(buf), "%04d", year);
+    } else if (period == Period::kMonthly) {
+        std::snprintf(buf, sizeof(buf), "%04d-%02d", year, month);
+    } else {
+        std::snprintf(buf, sizeof(buf), "%04d-%02d-%02d", year, month, day);
     }
+    return buf;
+}
+
+}  // namespace
 
-    return true;
+// ========================== ReportBuilder ==========================
+ReportBuilder::ReportBuilder(Period period) : period_(period) {}
+
+size_t ReportBuilder::CategorySlot(const std::string& category_name) {
+    // 若分类为空，归为"未分类"
+    static const std::string kUncategorized = "Uncategorized";
+    const std::string& key = category_name.empty() ? kUncategorized : category_name;
+    auto slot = category_slots_.try_emplace(key, category_totals_.size());
+    if (slot.second) {
+        category_names_.push_back(&slot.first->first);
+        category_totals_.emplace_back();
+    }
+    return slot.first->second;
 }
 
+void ReportBuilder::Add(int64_t local_day, Money amount, const std::string& category_name,
+                        const std::string& category_type) {
+    // 根据分类类型判断收入/支出
+    // 修复 bug：使用 category_type 而不是 amount 的正负号
+    // 如果 category_type 为其他值（如 "exorin"），暂时不计入
+    AddToSlot(local_day, amount, CategorySlot(category_name), category_type == "income",
+              category_type == "expense");
+}
+
+void ReportBuilder::Add(int64_t local_day, Money amount, int category_id,
+                        const Category* category) {
+    auto kind = category_kinds_.find(category_id);
+    if (kind == category_kinds_.end()) {
+        static const std::string kEmpty;
+        const std::string& name = category ? category->GetName() : kEmpty;
+        const std::string& type = category ? category->GetType() : kEmpty;
+        kind = category_kinds_
+                   .emplace(category_id,
+                            CategoryKind{CategorySlot(name), type == "income", type == "expense"})
+                   .first;
+    }
+    AddToSlot(local_day, amount, kind->second.slot, kind->second.income, kind->second.expense);
+}
+
+void ReportBuilder::AddToSlot(int64_t local_day, Money amount, size_t category_index,
+                              bool is_income, bool is_expense) {
+    category_totals_[category_index] += amount;
+    if (is_income) {
+        total_income_ += amount;
+    } else if (is_expense) {
+        total_expense_ += amount;
+    }
+
+    if (period_ == Period::kCustom) return;
+    if (buckets_.empty() || local_day < last_range_.first || local_day >= last_range_.second) {
+        last_range_ = BucketRange(period_, local_day);
+        auto inserted = bucket_slots_.try_emplace(last_range_.first, buckets_.size());
+        if (inserted.second) buckets_.push_back({last_range_.first, {}, Money(), Money()});
+        last_bucket_ = inserted.first->second;
+    }
+    BucketTotals& bucket = buckets_[last_bucket_];
+    if (bucket.categories.size() <= category_index) bucket.categories.resize(category_index + 1);
+    bucket.categories[category_index].total += amount;
+    bucket.categories[category_index].seen = true;
+    if (is_income) {
+        bucket.income += amount;
+    } else if (is_expense) {
+        bucket.expense += amount;
+    }
+}
+
+Report ReportBuilder::Build(ChartType chart_type) {
+    std::unordered_map<std::string, Money> category_summary;
+    category_summary.reserve(category_totals_.size());
+    for (size_t i = 0; i < category_totals_.size(); ++i) {
+        category_summary.emplace(*category_names_[i], category_totals_[i]);
+    }
+    Report report =
+        Report::FromTotals(period_, chart_type, category_summary, total_income_, total_expense_);
+
+    std::sort(buckets_.begin(), buckets_.end(),
+              [](const BucketTotals& a, const BucketTotals& b) { return a.first_day < b.first_day; });
+    report.series_.reserve(buckets_.size());
+    for (const auto& bucket : buckets_) {
+        ReportBucket out;
+        out.start = time_utils::LocalDayStart(bucket.first_day);
+        out.label = BucketLabel(period_, bucket.first_day);
+        // 只输出该时间段中出现过的分类
+        for (size_t i = 0; i < bucket.categories.size(); ++i) {
+            if (bucket.categories[i].seen) {
+                out.category_summary.emplace(*category_names_[i],
+                                             bucket.categories[i].total.ToDouble());
+            }
+        }
+        out.total_income = bucket.income;
+        out.total_expense = bucket.expense;
+        report.series_.push_back(std::move(out));
+    }
+    return report;
+}
+
+// ========================== Report ==========================
 // 报表生成逻辑
 Report Report::Generate(const std::vector<BillData>& bills,
                         const QueryCriteria& criteria,
                         Period period,
                         ChartType chart_type) {
-    std::unordered_map<std::string, double> category_summary;
-    double total_income = 0.0;
-    double total_expense = 0.0;
-
+    // 按分累加，结果与账单顺序无关；最后再换算成 double 输出
+    ReportBuilder builder(period);
+    const bool bucketed = period != Period::kCustom;
     for (const auto& bill : bills) {
         if (!MatchCriteria(bill, criteria)) continue;
+        const int64_t day = bucketed ? time_utils::LocalDayNumber(bill.GetTime()) : 0;
+        builder.Add(day, bill.GetMoney(), bill.GetCategoryName(), bill.GetCategoryType());
+    }
+    return builder.Build(chart_type);
+}
 
-        double amount = bill.GetAmount();
-        const std::string& category = bill.GetCategoryName();
-        const std::string& category_type = bill.GetCategoryType();  // 获取分类类型
-
-        // 若分类为空，归为"未分类"
-        std::string key = category.empty() ? "Uncategorized" : category;
-        category_summary[key] += amount;
-
-        // 根据分类类型判断收入/支出
-        // 修复 bug：使用 category_type 而不是 amount 的正负号
-        if (category_type == "income") {
-            total_income += amount;
-        } else if (category_type == "expense") {
-            total_expense += amount;
-        }
-        // 如果 category_type 为其他值（如 "exorin"），暂时不计入
+Report Report::FromTotals(Period period,
+                          ChartType chart_type,
+                          const std::unordered_map<std::string, Money>& category_totals,
+                          Money total_income,
+                          Money total_expense) {
+    std::unordered_map<std::string, double> category_summary;
+    category_summary.reserve(category_totals.size());
+    for (const auto& [category, total] : category_totals) {
+        category_summary.emplace(category, total.ToDouble());
     }
 
     Report report(period, chart_type, category_summary);
@@ -93,16 +230,21 @@ void Report::SetCategorySummary(const std::unordered_map<std::string, double>& s
     category_summary_ = summary;
 }
 
-double Report::GetTotalIncome() const { return total_income_; }
-double Report::GetTotalExpense() const { return total_expense_; }
+double Report::GetTotalIncome() const { return total_income_.ToDouble(); }
+double Report::GetTotalExpense() const { return total_expense_.ToDouble(); }
+Money Report::GetTotalIncomeMoney() const { return total_income_; }
+Money Report::GetTotalExpenseMoney() const { return total_expense_; }
+
+const std::vector<ReportBucket>& Report::GetSeries() const { return series_; }
 
 std::string Report::ToString() const {
     std::ostringstream oss;
     oss << std::fixed << std::setprecision(2);
     oss << "Report(Period=" << static_cast<int>(period_)
         << ", ChartType=" << static_cast<int>(chart_type_)
-        << ", TotalIncome=" << total_income_
-        << ", TotalExpense=" << total_expense_
+        << ", TotalIncome=" << total_income_.ToString()
+        << ", TotalExpense=" << total_expense_.ToString()
+        << ", Buckets=" << series_.size()
         << ", CategorySummary={";
 
     bool first = true;
@@ -0,0 +1,259 @@
+#include "storage/bill_json_reader.h"
+#include <limits>
+#include <optional>
+#include <string>
+
+namespace accounting {
+
+namespace {
+
+// 按嵌套层级推进的 SAX 处理器：
+//   层级 1: 外层数组          [ ... ]
+//   层级 2: [user_id, bills] 二元组
+//   层级 3: 账单数组          [ {bill}, ... ]
+//   层级 4: 账单对象          { "bill_id": ..., ... }
+class BillSaxHandler : public nlohmann::json_sax<json> {
+public:
+    explicit BillSaxHandler(std::map<int, std::vector<Bill>>* bills) : bills_(bills) {}
+
+    // 单用户模式：顶层就是账单数组，相当于从层级 2 的第二个元素开始
+    explicit BillSaxHandler(std::vector<Bill>* user_bills)
+        : single_user_(user_bills), depth_(2), pair_index_(1) {}
+
+    bool null() override {
+        if (skip_depth_ > 0) return true;
+        // category_id 允许为 null
+        if (depth_ == 4 && key_ == "category_id") return true;
+        return UnknownValue();
+    }
+
+    bool boolean(bool) override {
+        if (skip_depth_ > 0) return true;
+        return UnknownValue();
+    }
+
+    // 只有 id 字段需要换算成 int：超出 int 范围时为空，由 Number 按字段决定是否失败
+    bool number_integer(number_integer_t val) override {
+        const bool fits = val >= std::numeric_limits<int>::min() &&
+                          val <= std::numeric_limits<int>::max();
+        return Number(static_cast<double>(val),
+                      fits ? std::optional<int>(static_cast<int>(val)) : std::nullopt);
+    }
+
+    bool number_unsigned(number_unsigned_t val) override {
+        const bool fits = val <= static_cast<number_unsigned_t>(std::numeric_limits<int>::max());
+        return Number(static_cast<double>(val),
+                      fits ? std::optional<int>(static_cast<int>(val)) : std::nullopt);
+    }
+
+    bool number_float(number_float_t val, const string_t&) override {
+        // NaN 与两侧比较都为 false，同样视为超出范围
+        const bool fits = val >= static_cast<number_float_t>(std::numeric_limits<int>::min()) &&
+                          val <= static_cast<number_float_t>(std::numeric_limits<int>::max());
+        return Number(static_cast<double>(val),
+                      fits ? std::optional<int>(static_cast<int>(val)) : std::nullopt);
+    }
+
+    bool string(string_t& val) override {
+        if (skip_depth_ > 0) return true;
+        if (depth_ != 4) return false;
+        if (key_ == "content") {
+            content_ = std::move(val);
+            seen_ |= kContent;
+            return true;
+        }
+        if (key_ == "time") {
+            time_ = BillTimeFromString(val);
+            seen_ |= kTime;
+            return true;
+        }
+        return UnknownValue();
+    }
+
+    bool binary(binary_t&) override {
+        if (skip_depth_ > 0) return true;
+        return UnknownValue();
+    }
+
+    bool start_object(std::size_t) override {
+        if (skip_depth_ > 0 || (depth_ == 4 && IsUnknownKey())) {
+            ++skip_depth_;
+            return true;
+        }
+        if (depth_ != 3) return false;
+        depth_ = 4;
+        key_.clear();
+        seen_ = 0;
+        category_id_ = -1;
+        return true;
+    }
+
+    bool key(string_t& val) override {
+        if (skip_depth_ > 0) return true;
+        key_ = std::move(val);
+        return true;
+    }
+
+    bool end_object() override {
+        if (skip_depth_ > 0) {
+            --skip_depth_;
+            return true;
+        }
+        if (depth_ != 4) return false;
+        if ((seen_ & kRequired) != kRequired) return false;  // 与 from_json 的 at() 一致
+        depth_ = 3;
+        if (current_bills_) {
+            Bill bill(bill_id_, 0.0, nullptr, time_, content_);
+            bill.SetMoney(amount_);
+            bill.SetCategoryId(category_id_);
+            current_bills_->push_back(std::move(bill));
+        }
+        return true;
+    }
+
+    bool start_array(std::size_t) override {
+        if (skip_depth_ > 0 || (depth_ == 4 && IsUnknownKey())) {
+            ++skip_depth_;
+            return true;
+        }
+        switch (depth_) {
+            case 0:
+                depth_ = 1;
+                return true;
+            case 1:
+                depth_ = 2;
+                pair_index_ = 0;
+                return true;
+            case 2: {
+                if (pair_index_ != 1) return false;
+                depth_ = 3;
+                if (single_user_) {
+                    current_bills_ = single_user_;
+                    return true;
+                }
+                // 重复的 user_id 与 DOM 路径一致：保留第一次出现的数据
+                auto inserted = bills_->emplace(user_id_, std::vector<Bill>());
+                current_bills_ = inserted.second ? &inserted.first->second : nullptr;
+                return true;
+            }
+            default:
+                return false;
+        }
+    }
+
+    bool end_array() override {
+        if (skip_depth_ > 0) {
+            --skip_depth_;
+            return true;
+        }
+        switch (depth_) {
+            case 1:
+                depth_ = 0;
+                return true;
+            case 2:
+                if (pair_index_ != 2 || single_user_) return false;
+                depth_ = 1;
+                return true;
+            case 3:
+                depth_ = 2;
+                pair_index_ = 2;
+                current_bills_ = nullptr;
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    bool parse_error(std::size_t, const std::string&,
+                     const nlohmann::detail::exception&) override {
+        return false;
+    }
+
+private:
+    enum : unsigned {
+        kBillId = 1u << 0,
+        kAmount = 1u << 1,
+        kContent = 1u << 2,
+        kTime = 1u << 3,
+        kRequired = kBillId | kAmount | kContent | kTime,
+    };
+
+    bool IsUnknownKey() const {
+        return key_ != "bill_id" && key_ != "amount" && key_ != "category_id" &&
+               key_ != "content" && key_ != "time";
+    }
+
+    // 已知字段出现了错误类型的值时失败，未知字段直接忽略
+    bool UnknownValue() const {
+        return depth_ == 4 && IsUnknownKey();
+    }
+
+    // as_int 为空表示数值超出 int 范围：id 字段因此失败，而不是截断成别的 id
+    bool Number(double as_double, std::optional<int> as_int) {
+        if (skip_depth_ > 0) return true;
+        if (depth_ == 2) {
+            if (pair_index_ != 0 || !as_int) return false;
+            user_id_ = *as_int;
+            pair_index_ = 1;
+            return true;
+        }
+        if (depth_ != 4) return false;
+        if (key_ == "bill_id") {
+            if (!as_int) return false;
+            bill_id_ = *as_int;
+            seen_ |= kBillId;
+        } else if (key_ == "amount") {
+            // 与 from_json 一致：换算成分后超出范围时失败
+            if (!Money::TryFromDouble(as_double, amount_)) return false;
+            seen_ |= kAmount;
+        } else if (key_ == "category_id") {
+            if (!as_int) return false;
+            category_id_ = *as_int;
+        } else {
+            return UnknownValue();
+        }
+        return true;
+    }
+
+    std::map<int, std::vector<Bill>>* bills_ = nullptr;
+    std::vector<Bill>* single_user_ = nullptr;
+    std::vector<Bill>* current_bills_ = nullptr;
+
+    int depth_ = 0;
+    int skip_depth_ = 0;    // >0 表示正在跳过未知字段的嵌套值
+    int pair_index_ = 0;    // 二元组内已读取的元素个数
+    int user_id_ = 0;
+
+    // 当前账单对象的字段
+    std::string key_;
+    unsigned seen_ = 0;
+    int bill_id_ = 0;
+    Money amount_;
+    int category_id_ = -1;
+    std::chrono::system_clock::time_point time_;
+    std::string content_;
+};
+
+}  // namespace
+
+bool ReadBillsJson(std::istream& input, std::map<int, std::vector<Bill>>& bills,
+                   json::input_format_t format) {
+    try {
+        BillSaxHandler handler(&bills);
+        return json::sax_parse(input, &handler, format);
+    } catch (...) {
+        return false;
+    }
+}
+
+bool ReadUserBillsJson(std::istream& input, std::vector<Bill>& bills,
+                       json::input_format_t format) {
+    try {
+        BillSaxHandler handler(&bills);
+        return json::sax_parse(input, &handler, format);
+    } catch (...) {
+        return false;
+    }
+}
+
+}  // namespace accounting
@@ -0,0 +1,151 @@
+#include "storage/binary_storage.h"
+#include "storage/binary_bill_format.h"
+#include "storage/mapped_bill_snapshot.h"
+#include <cstring>
+#include <fstream>
+#include <limits>
+
+namespace accounting {
+
+namespace fmt = binary_bill_format;
+
+BinaryStorage::BinaryStorage(const std::string& base_path)
+    : base_path_(base_path), json_(base_path) {}
+
+// =================== 用户 / 分类 / 预算（委托 JSON） ===================
+std::pair<bool, std::vector<User>> BinaryStorage::LoadUsers() {
+    return json_.LoadUsers();
+}
+
+bool BinaryStorage::SaveUsers(const std::vector<User>& users) {
+    return json_.SaveUsers(users);
+}
+
+std::pair<bool, std::map<int, std::vector<Category>>> BinaryStorage::LoadCategoriesByUser() {
+    return json_.LoadCategoriesByUser();
+}
+
+bool BinaryStorage::SaveCategoriesByUser(const std::map<int, std::vector<Category>>& data) {
+    return json_.SaveCategoriesByUser(data);
+}
+
+std::pair<bool, std::map<int, Budget>> BinaryStorage::LoadBudgetsByUser() {
+    return json_.LoadBudgetsByUser();
+}
+
+bool BinaryStorage::SaveBudgetsByUser(const std::map<int, Budget>& data) {
+    return json_.SaveBudgetsByUser(data);
+}
+
+// =================== 账单（列式二进制） ===================
+template<typename T>
+static void WriteColumn(char* dst, const std::vector<T>& column) {
+    if (!column.empty()) std::memcpy(dst, column.data(), column.size() * sizeof(T));
+}
+
+std::pair<bool, std::map<int, std::vector<Bill>>> BinaryStorage::LoadBillsByUser() {
+    std::map<int, std::vector<Bill>> data;
+    auto snapshot = OpenBillSnapshot();
+    if (!snapshot.first) return {false, {}};
+    if (!snapshot.second) return {true, data};
+
+    for (int user_id : snapshot.second->GetUserIds()) {
+        if (!snapshot.second->MaterializeUser(user_id, data[user_id])) return {false, {}};
+    }
+    return {true, data};
+}
+
+std::pair<bool, std::shared_ptr<const MappedBillSnapshot>> BinaryStorage::OpenBillSnapshot() {
+    return MappedBillSnapshot::Open(base_path_ + "/bills.bin");
+}
+
+bool BinaryStorage::SaveBillsByUser(const std::map<int, std::vector<Bill>>& data) {
+    const std::string path = base_path_ + "/bills.bin";
+    const std::string tmp_path = path + ".tmp";
+    try {
+        fmt::FileHeader header{};
+        std::memcpy(header.magic, fmt::kMagic, sizeof(header.magic));
+        header.version = fmt::kVersion;
+        header.endian_tag = fmt::kEndianTag;
+        header.user_count = static_cast<uint32_t>(data.size());
+
+        // 先计算目录，确定每个用户块的偏移
+        std::vector<fmt::UserEntry> entries;
+        entries.reserve(data.size());
+        uint64_t offset = fmt::AlignUp(sizeof(header) + data.size() * sizeof(fmt::UserEntry), 8);
+        for (const auto& [user_id, bills] : data) {
+            uint64_t content_bytes = 0;
+            for (const auto& bill : bills) content_bytes += bill.GetContent().size();
+            if (content_bytes > std::numeric_limits<uint32_t>::max()) return false;
+
+            fmt::UserEntry entry{};
+            entry.user_id = user_id;
+            entry.bill_count = static_cast<uint32_t>(bills.size());
+            entry.block_offset = offset;
+            entry.content_bytes = content_bytes;
+            entries.push_back(entry);
+            offset += fmt::BlockLayout::For(bills.size(), content_bytes).size;
+        }
+
+        std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) return false;
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        if (!entries.empty()) {
+            file.write(reinterpret_cast<const char*>(entries.data()),
+                       static_cast<std::streamsize>(entries.size() * sizeof(fmt::UserEntry)));
+        }
+
+        std::vector<int64_t> times;
+        std::vector<int64_t> amounts;
+        std::vector<int32_t> bill_ids;
+        std::vector<int32_t> category_ids;
+        std::vector<uint32_t> content_offsets;
+        std::vector<char> block;
+
+        size_t u = 0;
+        for (const auto& [user_id, bills] : data) {
+            const auto& entry = entries[u++];
+            const auto layout = fmt::BlockLayout::For(entry.bill_count, entry.content_bytes);
+
+            times.clear();
+            amounts.clear();
+            bill_ids.clear();
+            category_ids.clear();
+            content_offsets.assign(1, 0);
+            for (const auto& bill : bills) {
+                times.push_back(std::chrono::system_clock::to_time_t(bill.GetTime()));
+                amounts.push_back(bill.GetMoney().Cents());
+                bill_ids.push_back(bill.GetBillId());
+                category_ids.push_back(bill.GetCategory() ? bill.GetCategory()->GetCategoryId()
+                                                          : bill.GetCategoryId());
+                content_offsets.push_back(content_offsets.back() +
+                                          static_cast<uint32_t>(bill.GetContent().size()));
+            }
+
+            block.assign(layout.size, 0);
+            WriteColumn(block.data() + layout.time, times);
+            WriteColumn(block.data() + layout.amount, amounts);
+            WriteColumn(block.data() + layout.bill_id, bill_ids);
+            WriteColumn(block.data() + layout.category_id, category_ids);
+            WriteColumn(block.data() + layout.content_offset, content_offsets);
+            char* content = block.data() + layout.content;
+            for (const auto& bill : bills) {
+                std::memcpy(content, bill.GetContent().data(), bill.GetContent().size());
+                content += bill.GetContent().size();
+            }
+
+            file.seekp(static_cast<std::streamoff>(entry.block_offset));
+            file.write(block.data(), static_cast<std::streamsize>(block.size()));
+        }
+
+        file.close();
+        if (!file) return false;
+        // 写完整个临时文件后再替换，避免中途失败留下半个快照
+        std::filesystem::rename(tmp_path, path);
+        return true;
+    } catch (...) {
+        return false;
+    }
+}
+
+}  // namespace accounting
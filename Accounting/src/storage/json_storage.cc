@@ -1,20 +1,123 @@
 #include "storage/json_storage.h"
+#include "storage/bill_json_reader.h"
+#include <algorithm>
+#include <cerrno>
 #include <fstream>
+#include <stdexcept>
 #include <nlohmann/json.hpp>
 
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 using json = nlohmann::json;
 
 namespace accounting {
 
-JsonStorage::JsonStorage(const std::string& base_path)
-    : base_path_(base_path) {
+// ===== 文件描述符读写与落盘 =====
+namespace {
+
+int OpenForAppend(const std::string& path) {
+#ifdef _WIN32
+    return ::_open(path.c_str(), _O_WRONLY | _O_APPEND | _O_CREAT | _O_BINARY, 0644);
+#else
+    return ::open(path.c_str(), O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+#endif
+}
+
+void CloseFd(int fd) {
+#ifdef _WIN32
+    ::_close(fd);
+#else
+    ::close(fd);
+#endif
+}
+
+bool WriteAll(int fd, const char* data, size_t size) {
+    while (size > 0) {
+#ifdef _WIN32
+        const int n = ::_write(fd, data, static_cast<unsigned>(size));
+#else
+        const ssize_t n = ::write(fd, data, size);
+        if (n < 0 && errno == EINTR) continue;
+#endif
+        if (n <= 0) return false;
+        data += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// 文件数据落盘（不只是进入操作系统缓存）
+bool SyncFd(int fd) {
+#if defined(_WIN32)
+    return ::_commit(fd) == 0;
+#elif defined(__APPLE__)
+    return ::fsync(fd) == 0;
+#else
+    return ::fdatasync(fd) == 0;
+#endif
+}
+
+bool SyncFile(const std::string& path) {
+#ifdef _WIN32
+    const int fd = ::_open(path.c_str(), _O_RDWR | _O_BINARY);
+#else
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+#endif
+    if (fd < 0) return false;
+    const bool ok = SyncFd(fd);
+    CloseFd(fd);
+    return ok;
+}
+
+// rename 之后同步所在目录，目录项本身也要落盘
+bool SyncDirectory(const std::string& path) {
+#ifdef _WIN32
+    (void)path;
+    return true;
+#else
+    const std::string dir = std::filesystem::path(path).parent_path().string();
+    const int fd = ::open(dir.empty() ? "." : dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) return false;
+    const bool ok = ::fsync(fd) == 0;
+    CloseFd(fd);
+    return ok;
+#endif
+}
+
+}  // namespace
+
+static json::input_format_t InputFormat(JsonStorageOptions::Encoding encoding) {
+    switch (encoding) {
+        case JsonStorageOptions::Encoding::kCbor:
+            return json::input_format_t::cbor;
+        case JsonStorageOptions::Encoding::kMessagePack:
+            return json::input_format_t::msgpack;
+        case JsonStorageOptions::Encoding::kText:
+            break;
+    }
+    return json::input_format_t::json;
+}
+
+JsonStorage::JsonStorage(const std::string& base_path,
+                         const JsonStorageOptions& options)
+    : base_path_(base_path), options_(options) {
     std::filesystem::create_directories(base_path_);
 }
 
+JsonStorage::~JsonStorage() {
+    if (bill_log_fd_ >= 0) CloseFd(bill_log_fd_);
+}
+
 // =================== 用户 ===================
 std::pair<bool, std::vector<User>> JsonStorage::LoadUsers() {
     std::vector<User> users;
-    const std::string path = base_path_ + "/users.json";
+    const std::string path = DataFile(base_path_, "users");
     if (!std::filesystem::exists(path)) return {true, users};
     bool ok = LoadFromJson(path, users);
     if (!ok) return {false, {}};
@@ -22,27 +125,45 @@ std::pair<bool, std::vector<User>> JsonStorage::LoadUsers() {
 }
 
 bool JsonStorage::SaveUsers(const std::vector<User>& users) {
-    return SaveToJson(base_path_ + "/users.json", users);
+    return SaveToJson(DataFile(base_path_, "users"), users);
 }
 
 // =================== 账单 ===================
 std::pair<bool, std::map<int, std::vector<Bill>>> JsonStorage::LoadBillsByUser() {
     std::map<int, std::vector<Bill>> data;
-    const std::string path = base_path_ + "/bills.json";
+    if (IsSharded()) {
+        for (int user_id : ListShardUserIds()) {
+            if (!LoadUserBills(user_id, data[user_id])) return {false, {}};
+        }
+        return {true, data};
+    }
+    const std::string path = DataFile(base_path_, "bills");
     if (!std::filesystem::exists(path)) return {true, data};
-    bool ok = LoadFromJson(path, data);
-    if (!ok) return {false, {}};
+    // 账单文件最大，流式解析避免构建完整 DOM
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open() || !ReadBillsJson(file, data, InputFormat(options_.encoding))) {
+        return {false, {}};
+    }
     return {true, data};
 }
 
 bool JsonStorage::SaveBillsByUser(const std::map<int, std::vector<Bill>>& data) {
-    return SaveToJson(base_path_ + "/bills.json", data);
+    if (IsSharded()) return SaveShards(data, "bills", true);
+    return SaveToJson(DataFile(base_path_, "bills"), data);
 }
 
 // =================== 分类 ===================
 std::pair<bool, std::map<int, std::vector<Category>>> JsonStorage::LoadCategoriesByUser() {
     std::map<int, std::vector<Category>> data;
-    const std::string path = base_path_ + "/categories.json";
+    if (IsSharded()) {
+        for (int user_id : ListShardUserIds()) {
+            auto res = LoadCategoriesForUser(user_id);
+            if (!res.first) return {false, {}};
+            if (!res.second.empty()) data[user_id] = std::move(res.second);
+        }
+        return {true, data};
+    }
+    const std::string path = DataFile(base_path_, "categories");
     if (!std::filesystem::exists(path)) return {true, data};
     bool ok = LoadFromJson(path, data);
     if (!ok) return {false, {}};
@@ -50,13 +171,22 @@ std::pair<bool, std::map<int, std::vector<Category>>> JsonStorage::LoadCategorie
 }
 
 bool JsonStorage::SaveCategoriesByUser(const std::map<int, std::vector<Category>>& data) {
-    return SaveToJson(base_path_ + "/categories.json", data);
+    if (IsSharded()) return SaveShards(data, "categories", true);
+    return SaveToJson(DataFile(base_path_, "categories"), data);
 }
 
 // =================== 预算 ===================
 std::pair<bool, std::map<int, Budget>> JsonStorage::LoadBudgetsByUser() {
     std::map<int, Budget> data;
-    const std::string path = base_path_ + "/budgets.json";
+    if (IsSharded()) {
+        for (int user_id : ListShardUserIds()) {
+            auto res = LoadBudgetForUser(user_id);
+            if (!res.first) return {false, {}};
+            if (res.second) data[user_id] = *res.second;
+        }
+        return {true, data};
+    }
+    const std::string path = DataFile(base_path_, "budgets");
     if (!std::filesystem::exists(path)) return {true, data};
     bool ok = LoadFromJson(path, data);
     if (!ok) return {false, {}};
@@ -64,18 +194,323 @@ std::pair<bool, std::map<int, Budget>> JsonStorage::LoadBudgetsByUser() {
 }
 
 bool JsonStorage::SaveBudgetsByUser(const std::map<int, Budget>& data) {
-    return SaveToJson(base_path_ + "/budgets.json", data);
+    if (IsSharded()) return SaveShards(data, "budget", true);
+    return SaveToJson(DataFile(base_path_, "budgets"), data);
+}
+
+// =================== 按用户读写（分片布局） ===================
+bool JsonStorage::SupportsPerUserLoad() const {
+    return IsSharded();
+}
+
+std::pair<bool, std::vector<Category>> JsonStorage::LoadCategoriesForUser(int user_id) {
+    if (!IsSharded()) return Storage::LoadCategoriesForUser(user_id);
+    std::vector<Category> categories;
+    const std::string path = DataFile(UserDir(user_id), "categories");
+    if (!std::filesystem::exists(path)) return {true, categories};
+    if (!LoadFromJson(path, categories)) return {false, {}};
+    return {true, categories};
+}
+
+std::pair<bool, std::vector<Bill>> JsonStorage::LoadBillsForUser(int user_id) {
+    if (!IsSharded()) return Storage::LoadBillsForUser(user_id);
+    std::vector<Bill> bills;
+    if (!LoadUserBills(user_id, bills)) return {false, {}};
+    return {true, bills};
+}
+
+std::pair<bool, std::shared_ptr<Budget>> JsonStorage::LoadBudgetForUser(int user_id) {
+    if (!IsSharded()) return Storage::LoadBudgetForUser(user_id);
+    const std::string path = DataFile(UserDir(user_id), "budget");
+    if (!std::filesystem::exists(path)) return {true, nullptr};
+    auto budget = std::make_shared<Budget>();
+    if (!LoadFromJson(path, *budget)) return {false, nullptr};
+    return {true, budget};
+}
+
+bool JsonStorage::SupportsPartialSave() const {
+    return IsSharded();
+}
+
+bool JsonStorage::SaveCategoriesForUsers(const std::map<int, std::vector<Category>>& data) {
+    if (!IsSharded()) return false;
+    return SaveShards(data, "categories", false);
+}
+
+bool JsonStorage::SaveBillsForUsers(const std::map<int, std::vector<Bill>>& data) {
+    if (!IsSharded()) return false;
+    return SaveShards(data, "bills", false);
+}
+
+bool JsonStorage::SaveBudgetsForUsers(const std::map<int, Budget>& data) {
+    if (!IsSharded()) return false;
+    return SaveShards(data, "budget", false);
+}
+
+std::string JsonStorage::DataFile(const std::string& dir, const std::string& name) const {
+    switch (options_.encoding) {
+        case JsonStorageOptions::Encoding::kCbor:
+            return dir + "/" + name + ".cbor";
+        case JsonStorageOptions::Encoding::kMessagePack:
+            return dir + "/" + name + ".msgpack";
+        case JsonStorageOptions::Encoding::kText:
+            break;
+    }
+    return dir + "/" + name + ".json";
+}
+
+std::string JsonStorage::UserDir(int user_id) const {
+    return base_path_ + "/users/" + std::to_string(user_id);
+}
+
+std::vector<int> JsonStorage::ListShardUserIds() const {
+    std::vector<int> ids;
+    const std::filesystem::path root = base_path_ + "/users";
+    std::error_code ec;
+    if (!std::filesystem::is_directory(root, ec)) return ids;
+    for (const auto& entry : std::filesystem::directory_iterator(root, ec)) {
+        if (!entry.is_directory()) continue;
+        const std::string name = entry.path().filename().string();
+        if (name.empty() || name.size() > 9 ||
+            name.find_first_not_of("0123456789") != std::string::npos) {
+            continue;
+        }
+        ids.push_back(std::stoi(name));
+    }
+    std::sort(ids.begin(), ids.end());
+    return ids;
+}
+
+bool JsonStorage::LoadUserBills(int user_id, std::vector<Bill>& bills) const {
+    const std::string path = DataFile(UserDir(user_id), "bills");
+    if (!std::filesystem::exists(path)) return true;
+    std::ifstream file(path, std::ios::binary);
+    return file.is_open() && ReadUserBillsJson(file, bills, InputFormat(options_.encoding));
+}
+
+template<typename T>
+bool JsonStorage::SaveShards(const std::map<int, T>& data, const std::string& name,
+                             bool replace_all) {
+    try {
+        for (const auto& [user_id, value] : data) {
+            const std::string dir = UserDir(user_id);
+            std::filesystem::create_directories(dir);
+            if (!SaveToJson(DataFile(dir, name), value)) return false;
+        }
+        if (replace_all) {
+            // 整体保存：不在 data 中的用户视为没有该类数据
+            for (int user_id : ListShardUserIds()) {
+                if (data.count(user_id)) continue;
+                std::filesystem::remove(DataFile(UserDir(user_id), name));
+            }
+        }
+        return true;
+    } catch (...) {
+        return false;
+    }
+}
+
+// =================== 账单变更日志 ===================
+// 每行一条记录，例如：
+//   {"op":"add","user_id":1,"bill":{...}}
+//   {"op":"delete","user_id":1,"bill_id":3}
+static json BillLogRecordToJson(const BillLogRecord& record) {
+    json j;
+    j["user_id"] = record.user_id;
+    switch (record.op) {
+        case BillLogRecord::Op::kAdd:
+            j["op"] = "add";
+            j["bill"] = record.bill;
+            break;
+        case BillLogRecord::Op::kUpdate:
+            j["op"] = "update";
+            j["bill"] = record.bill;
+            break;
+        case BillLogRecord::Op::kDelete:
+            j["op"] = "delete";
+            j["bill_id"] = record.bill_id;
+            break;
+    }
+    return j;
+}
+
+static BillLogRecord BillLogRecordFromJson(const json& j) {
+    BillLogRecord record;
+    record.user_id = j.at("user_id").get<int>();
+    const std::string op = j.at("op").get<std::string>();
+    if (op == "add" || op == "update") {
+        record.op = (op == "add") ? BillLogRecord::Op::kAdd : BillLogRecord::Op::kUpdate;
+        record.bill = j.at("bill").get<Bill>();
+        record.bill_id = record.bill.GetBillId();
+    } else if (op == "delete") {
+        record.op = BillLogRecord::Op::kDelete;
+        record.bill_id = j.at("bill_id").get<int>();
+    } else {
+        throw std::runtime_error("unknown bill log op: " + op);
+    }
+    return record;
+}
+
+bool JsonStorage::IsBillLogEnabled() const {
+    return options_.enable_bill_log;
+}
+
+bool JsonStorage::AppendBillLog(const BillLogRecord& record) {
+    if (!options_.enable_bill_log) return false;
+    try {
+        if (bill_log_fd_ < 0) {
+            bill_log_fd_ = OpenForAppend(base_path_ + "/bills.log");
+            if (bill_log_fd_ < 0) return false;
+        }
+        // 一条记录一次 write：崩溃时最多留下最后半行，LoadBillLog 会丢弃
+        const std::string line = BillLogRecordToJson(record).dump() + '\n';
+        if (!WriteAll(bill_log_fd_, line.data(), line.size())) return false;
+        return !options_.sync_bill_log || SyncFd(bill_log_fd_);
+    } catch (...) {
+        return false;
+    }
+}
+
+bool JsonStorage::SyncBillLog() {
+    return bill_log_fd_ < 0 || SyncFd(bill_log_fd_);
+}
+
+std::pair<bool, std::vector<BillLogRecord>> JsonStorage::LoadBillLog() {
+    std::vector<BillLogRecord> records;
+    const std::string path = base_path_ + "/bills.log";
+    // 日志不存在视为没有未合并的变更（即使未启用日志模式也会读取，避免丢失数据）
+    if (!std::filesystem::exists(path)) return {true, records};
+
+    std::ifstream file(path);
+    if (!file.is_open()) return {false, {}};
+
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty()) continue;
+        try {
+            records.push_back(BillLogRecordFromJson(json::parse(line)));
+        } catch (...) {
+            // 进程在写最后一行时崩溃会留下半条记录，丢弃即可；中间行损坏则视为错误
+            if (file.peek() == std::char_traits<char>::eof()) break;
+            return {false, {}};
+        }
+    }
+    return {true, records};
+}
+
+bool JsonStorage::ClearBillLog() {
+    try {
+        if (bill_log_fd_ >= 0) {
+            CloseFd(bill_log_fd_);
+            bill_log_fd_ = -1;
+        }
+        const std::string path = base_path_ + "/bills.log";
+        if (std::filesystem::exists(path)) std::filesystem::remove(path);
+        return true;
+    } catch (...) {
+        return false;
+    }
+}
+
+// =================== 账单按日汇总 ===================
+// 每项写成 [category_id, day, total_cents, count]，比对象格式紧凑
+void to_json(json& j, const BillRollupSnapshot& snapshot) {
+    json entries = json::array();
+    for (const auto& entry : snapshot.entries) {
+        entries.push_back({entry.category_id, entry.day, entry.total_cents, entry.count});
+    }
+    j = json{{"bill_count", snapshot.bill_count},
+             {"total_cents", snapshot.total_cents},
+             {"checksum", snapshot.checksum},
+             {"day_fingerprint", snapshot.day_fingerprint},
+             {"entries", std::move(entries)}};
+}
+
+void from_json(const json& j, BillRollupSnapshot& snapshot) {
+    snapshot.bill_count = j.at("bill_count").get<int64_t>();
+    snapshot.total_cents = j.at("total_cents").get<int64_t>();
+    snapshot.checksum = j.at("checksum").get<uint64_t>();
+    // 旧文件没有指纹，按 0 读入，使用前核对不通过时重新计算
+    snapshot.day_fingerprint = j.value("day_fingerprint", uint64_t{0});
+    snapshot.entries.clear();
+    for (const auto& item : j.at("entries")) {
+        BillRollupEntry entry;
+        entry.category_id = item.at(0).get<int>();
+        entry.day = item.at(1).get<int64_t>();
+        entry.total_cents = item.at(2).get<int64_t>();
+        entry.count = item.at(3).get<int64_t>();
+        snapshot.entries.push_back(entry);
+    }
+}
+
+bool JsonStorage::SupportsBillRollups() const {
+    return true;
+}
+
+std::pair<bool, std::map<int, BillRollupSnapshot>> JsonStorage::LoadBillRollups() {
+    std::map<int, BillRollupSnapshot> data;
+    if (IsSharded()) {
+        for (int user_id : ListShardUserIds()) {
+            auto res = LoadBillRollupForUser(user_id);
+            if (!res.first) return {false, {}};
+            if (res.second) data[user_id] = std::move(*res.second);
+        }
+        return {true, data};
+    }
+    const std::string path = DataFile(base_path_, "bill_rollups");
+    if (!std::filesystem::exists(path)) return {true, data};
+    if (!LoadFromJson(path, data)) return {false, {}};
+    return {true, data};
+}
+
+bool JsonStorage::SaveBillRollups(const std::map<int, BillRollupSnapshot>& data) {
+    if (IsSharded()) return SaveShards(data, "bill_rollup", true);
+    return SaveToJson(DataFile(base_path_, "bill_rollups"), data);
+}
+
+std::pair<bool, std::shared_ptr<BillRollupSnapshot>> JsonStorage::LoadBillRollupForUser(int user_id) {
+    if (!IsSharded()) return Storage::LoadBillRollupForUser(user_id);
+    const std::string path = DataFile(UserDir(user_id), "bill_rollup");
+    if (!std::filesystem::exists(path)) return {true, nullptr};
+    auto snapshot = std::make_shared<BillRollupSnapshot>();
+    if (!LoadFromJson(path, *snapshot)) return {false, nullptr};
+    return {true, snapshot};
+}
+
+bool JsonStorage::SaveBillRollupsForUsers(const std::map<int, BillRollupSnapshot>& data) {
+    if (!IsSharded()) return false;
+    return SaveShards(data, "bill_rollup", false);
 }
 
 // =================== 通用 JSON 读写 ===================
 template<typename T>
 bool JsonStorage::SaveToJson(const std::string& filename, const T& data) {
     try {
-        std::ofstream file(filename);
+        // 先写临时文件再替换，写到一半失败或崩溃时旧快照仍然完整
+        const std::string tmp_filename = filename + ".tmp";
+        std::ofstream file(tmp_filename, std::ios::binary | std::ios::trunc);
         if (!file.is_open()) return false;
         json j = data;
-        file << std::setw(4) << j;
-        return true;
+        switch (options_.encoding) {
+            case JsonStorageOptions::Encoding::kText:
+                file << std::setw(4) << j;
+                break;
+            case JsonStorageOptions::Encoding::kCbor:
+                json::to_cbor(j, file);
+                break;
+            case JsonStorageOptions::Encoding::kMessagePack:
+                json::to_msgpack(j, file);
+                break;
+        }
+        file.close();
+        if (!file) {
+            std::filesystem::remove(tmp_filename);
+            return false;
+        }
+        // 日志模式下快照写入后即删除日志，快照内容和目录项都必须先落盘
+        if (options_.enable_bill_log && !SyncFile(tmp_filename)) return false;
+        std::filesystem::rename(tmp_filename, filename);
+        return !options_.enable_bill_log || SyncDirectory(filename);
     } catch (...) {
         return false;
     }
@@ -84,10 +519,20 @@ bool JsonStorage::SaveToJson(const std::string& filename, const T& data) {
 template<typename T>
 bool JsonStorage::LoadFromJson(const std::string& filename, T& data) {
     try {
-        std::ifstream file(filename);
+        std::ifstream file(filename, std::ios::binary);
         if (!file.is_open()) return false;
         json j;
-        file >> j;
+        switch (options_.encoding) {
+            case JsonStorageOptions::Encoding::kText:
+                file >> j;
+                break;
+            case JsonStorageOptions::Encoding::kCbor:
+                j = json::from_cbor(file);
+                break;
+            case JsonStorageOptions::Encoding::kMessagePack:
+                j = json::from_msgpack(file);
+                break;
+        }
         data = j.get<T>();
         return true;
     } catch (...) {
@@ -0,0 +1,149 @@
+#include "storage/mapped_bill_snapshot.h"
+#include "storage/binary_bill_format.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace accounting {
+
+namespace fmt = binary_bill_format;
+
+std::pair<bool, std::shared_ptr<const MappedBillSnapshot>> MappedBillSnapshot::Open(
+    const std::string& path) {
+    if (!std::filesystem::exists(path)) return {true, nullptr};
+
+    std::shared_ptr<MappedBillSnapshot> snapshot(new MappedBillSnapshot());
+#ifndef _WIN32
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return {false, nullptr};
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        return {false, nullptr};
+    }
+    snapshot->size_ = static_cast<size_t>(st.st_size);
+    if (snapshot->size_ > 0) {
+        void* addr = ::mmap(nullptr, snapshot->size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr == MAP_FAILED) {
+            ::close(fd);
+            return {false, nullptr};
+        }
+        snapshot->data_ = static_cast<const char*>(addr);
+        snapshot->mapped_ = true;
+    }
+    ::close(fd);  // 映射建立后即可关闭描述符
+#else
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) return {false, nullptr};
+    snapshot->size_ = static_cast<size_t>(std::filesystem::file_size(path));
+    snapshot->buffer_.resize(snapshot->size_);
+    if (snapshot->size_ > 0 &&
+        !file.read(snapshot->buffer_.data(), static_cast<std::streamsize>(snapshot->size_))) {
+        return {false, nullptr};
+    }
+    snapshot->data_ = snapshot->buffer_.data();
+#endif
+
+    if (!snapshot->Parse()) return {false, nullptr};
+    return {true, snapshot};
+}
+
+MappedBillSnapshot::~MappedBillSnapshot() {
+#ifndef _WIN32
+    if (mapped_) ::munmap(const_cast<char*>(data_), size_);
+#endif
+}
+
+bool MappedBillSnapshot::Parse() {
+    fmt::FileHeader header;
+    if (size_ < sizeof(header)) return false;
+    std::memcpy(&header, data_, sizeof(header));
+    if (std::memcmp(header.magic, fmt::kMagic, sizeof(header.magic)) != 0 ||
+        (header.version != fmt::kVersion && header.version != fmt::kDoubleAmountVersion) ||
+        header.endian_tag != fmt::kEndianTag) {
+        return false;
+    }
+
+    const uint64_t dir_end = sizeof(header) + uint64_t(header.user_count) * sizeof(fmt::UserEntry);
+    if (dir_end > size_) return false;
+
+    for (uint32_t u = 0; u < header.user_count; ++u) {
+        fmt::UserEntry entry;
+        std::memcpy(&entry, data_ + sizeof(header) + u * sizeof(entry), sizeof(entry));
+
+        const auto layout = fmt::BlockLayout::For(entry.bill_count, entry.content_bytes);
+        if (entry.block_offset % 8 != 0 || entry.block_offset + layout.size > size_) return false;
+        const char* block = data_ + entry.block_offset;
+
+        // 块起始 8 字节对齐、映射起始按页对齐，列指针满足各自类型的对齐要求
+        UserColumns columns;
+        columns.count = entry.bill_count;
+        columns.time = reinterpret_cast<const int64_t*>(block + layout.time);
+        if (header.version == fmt::kDoubleAmountVersion) {
+            columns.double_amount = reinterpret_cast<const double*>(block + layout.amount);
+        } else {
+            columns.amount_cents = reinterpret_cast<const int64_t*>(block + layout.amount);
+        }
+        columns.bill_id = reinterpret_cast<const int32_t*>(block + layout.bill_id);
+        columns.category_id = reinterpret_cast<const int32_t*>(block + layout.category_id);
+        columns.content_offset = reinterpret_cast<const uint32_t*>(block + layout.content_offset);
+        columns.content = block + layout.content;
+        columns.content_bytes = entry.content_bytes;
+        if (columns.content_offset[0] != 0 ||
+            columns.content_offset[columns.count] > columns.content_bytes) {
+            return false;
+        }
+        users_[entry.user_id] = columns;
+    }
+    return true;
+}
+
+std::vector<int> MappedBillSnapshot::GetUserIds() const {
+    std::vector<int> ids;
+    ids.reserve(users_.size());
+    for (const auto& [user_id, _] : users_) ids.push_back(user_id);
+    return ids;
+}
+
+const MappedBillSnapshot::UserColumns* MappedBillSnapshot::FindUser(int user_id) const {
+    auto it = users_.find(user_id);
+    return it == users_.end() ? nullptr : &it->second;
+}
+
+Bill MappedBillSnapshot::MakeBill(const UserColumns& columns, size_t index) {
+    const uint32_t begin = columns.content_offset[index];
+    const uint32_t end = columns.content_offset[index + 1];
+    if (begin > end || end > columns.content_bytes) {
+        throw std::out_of_range("corrupt bill content offsets");
+    }
+    Bill bill(columns.bill_id[index], 0.0, nullptr,
+              std::chrono::system_clock::from_time_t(static_cast<std::time_t>(columns.time[index])),
+              std::string(columns.content + begin, end - begin));
+    bill.SetMoney(columns.Amount(index));
+    bill.SetCategoryId(columns.category_id[index]);
+    return bill;
+}
+
+bool MappedBillSnapshot::MaterializeUser(int user_id, std::vector<Bill>& out) const {
+    const UserColumns* columns = FindUser(user_id);
+    if (!columns) return true;
+    try {
+        out.reserve(out.size() + columns->count);
+        for (size_t i = 0; i < columns->count; ++i) {
+            out.push_back(MakeBill(*columns, i));
+        }
+    } catch (...) {
+        return false;
+    }
+    return true;
+}
+
+}  // namespace accounting
@@ -0,0 +1,27 @@
+#include "storage/storage_migration.h"
+#include "managers/bill_manager.h"
+#include "managers/category_manager.h"
+
+namespace accounting {
+
+bool MigrateStorage(const std::shared_ptr<Storage>& source,
+                    const std::shared_ptr<Storage>& target) {
+    if (!source || !target) return false;
+
+    auto users = source->LoadUsers();
+    if (!users.first || !target->SaveUsers(users.second)) return false;
+
+    auto budgets = source->LoadBudgetsByUser();
+    if (!budgets.first || !target->SaveBudgetsByUser(budgets.second)) return false;
+
+    CategoryManager category_manager(source);
+    if (!category_manager.LoadFromStorage()) return false;
+    auto categories = source->LoadCategoriesByUser();
+    if (!categories.first || !target->SaveCategoriesByUser(categories.second)) return false;
+
+    BillManager bill_manager;
+    if (!bill_manager.LoadFromStorage(source, category_manager)) return false;
+    return bill_manager.SaveToStorage(target);
+}
+
+}  // namespace accounting
@@ -0,0 +1,65 @@
+#include "storage/binary_storage.h"
+#include "storage/json_storage.h"
+#include "storage/storage_migration.h"
+#include <iostream>
+#include <memory>
+#include <string>
+
+using namespace accounting;
+
+// 存储格式转换工具：
+//   accounting_convert <源格式> <源目录> <目标格式> <目标目录>
+// 格式取值：json | cbor | msgpack（均可加 -sharded 后缀表示按用户分片布局）| binary
+static std::shared_ptr<Storage> MakeStorage(std::string format, const std::string& dir) {
+    if (format == "binary") return std::make_shared<BinaryStorage>(dir);
+
+    JsonStorageOptions options;
+    const std::string sharded_suffix = "-sharded";
+    if (format.size() > sharded_suffix.size() &&
+        format.compare(format.size() - sharded_suffix.size(), sharded_suffix.size(),
+                       sharded_suffix) == 0) {
+        options.layout = JsonStorageOptions::Layout::kSharded;
+        format.resize(format.size() - sharded_suffix.size());
+    }
+    if (format == "json") {
+        options.encoding = JsonStorageOptions::Encoding::kText;
+    } else if (format == "cbor") {
+        options.encoding = JsonStorageOptions::Encoding::kCbor;
+    } else if (format == "msgpack") {
+        options.encoding = JsonStorageOptions::Encoding::kMessagePack;
+    } else {
+        return nullptr;
+    }
+    return std::make_shared<JsonStorage>(dir, options);
+}
+
+static void PrintUsage(const char* program) {
+    std::cerr << "用法: " << program << " <格式> <源目录> <格式> <目标目录>\n"
+              << "格式: json | cbor | msgpack | json-sharded | cbor-sharded | msgpack-sharded | binary\n"
+              << "示例: " << program << " json data binary data_bin\n"
+              << "      " << program << " json data cbor data_backup\n";
+}
+
+int main(int argc, char* argv[]) {
+    if (argc != 5) {
+        PrintUsage(argv[0]);
+        return 2;
+    }
+
+    auto source = MakeStorage(argv[1], argv[2]);
+    auto target = MakeStorage(argv[3], argv[4]);
+    if (!source || !target) {
+        std::cerr << "[错误] 未知的存储格式\n";
+        PrintUsage(argv[0]);
+        return 2;
+    }
+
+    if (!MigrateStorage(source, target)) {
+        std::cerr << "[错误] 转换失败: " << argv[2] << " -> " << argv[4] << "\n";
+        return 1;
+    }
+
+    std::cout << "[√] 已将 " << argv[1] << " 数据 (" << argv[2] << ") 转换为 "
+              << argv[3] << " 数据 (" << argv[4] << ")\n";
+    return 0;
+}
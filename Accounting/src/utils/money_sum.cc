@@ -0,0 +1,129 @@
+#include "utils/money_sum.h"
+#include <algorithm>
+#include <type_traits>
+#include <vector>
+#include "utils/parallel.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace accounting {
+namespace money_sum {
+
+namespace {
+
+using TimePoint = std::chrono::system_clock::time_point;
+
+static_assert(sizeof(TimePoint) == sizeof(int64_t) && std::is_standard_layout<TimePoint>::value,
+              "time_point 需要是单个 64 位计数");
+
+// 累加器使用无符号数：回绕有定义，且与有符号补码加法结果相同
+constexpr size_t kLanes = 8;
+constexpr size_t kParallelBlock = size_t(1) << 16;  // 并行求和的块大小（行）
+
+uint64_t SumBlock(const int64_t* cents, size_t count) {
+    size_t i = 0;
+    uint64_t total = 0;
+#if defined(__AVX2__)
+    __m256i acc0 = _mm256_setzero_si256();
+    __m256i acc1 = _mm256_setzero_si256();
+    for (; i + 8 <= count; i += 8) {
+        acc0 = _mm256_add_epi64(acc0, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(cents + i)));
+        acc1 = _mm256_add_epi64(acc1, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(cents + i + 4)));
+    }
+    alignas(32) uint64_t lanes[4];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), _mm256_add_epi64(acc0, acc1));
+    total = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#else
+    // 多个独立累加器，去掉循环间依赖，便于编译器向量化
+    uint64_t acc[kLanes] = {};
+    for (; i + kLanes <= count; i += kLanes) {
+        for (size_t lane = 0; lane < kLanes; ++lane) acc[lane] += static_cast<uint64_t>(cents[i + lane]);
+    }
+    for (size_t lane = 0; lane < kLanes; ++lane) total += acc[lane];
+#endif
+    for (; i < count; ++i) total += static_cast<uint64_t>(cents[i]);
+    return total;
+}
+
+uint64_t SumBlockInTimeRange(const int64_t* cents, const TimePoint* times, size_t count,
+                             int64_t start, int64_t end) {
+    size_t i = 0;
+    uint64_t total = 0;
+#if defined(__AVX2__)
+    const __m256i lo = _mm256_set1_epi64x(start);
+    const __m256i hi = _mm256_set1_epi64x(end);
+    __m256i acc = _mm256_setzero_si256();
+    for (; i + 4 <= count; i += 4) {
+        const __m256i t = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(times + i));
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(cents + i));
+        // 区间外：start > t 或 t > end
+        const __m256i outside = _mm256_or_si256(_mm256_cmpgt_epi64(lo, t), _mm256_cmpgt_epi64(t, hi));
+        acc = _mm256_add_epi64(acc, _mm256_andnot_si256(outside, v));
+    }
+    alignas(32) uint64_t lanes[4];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), acc);
+    total = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#else
+    uint64_t acc[kLanes] = {};
+    for (; i + kLanes <= count; i += kLanes) {
+        for (size_t lane = 0; lane < kLanes; ++lane) {
+            const int64_t t = times[i + lane].time_since_epoch().count();
+            const uint64_t inside = static_cast<uint64_t>(t >= start) & static_cast<uint64_t>(t <= end);
+            acc[lane] += static_cast<uint64_t>(cents[i + lane]) & (0 - inside);
+        }
+    }
+    for (size_t lane = 0; lane < kLanes; ++lane) total += acc[lane];
+#endif
+    for (; i < count; ++i) {
+        const int64_t t = times[i].time_since_epoch().count();
+        if (t >= start && t <= end) total += static_cast<uint64_t>(cents[i]);
+    }
+    return total;
+}
+
+// 按 kParallelBlock 行一块求和后合并；块的划分与线程数无关
+template<typename F>
+int64_t SumBlocks(size_t count, F&& block_sum) {
+    const size_t blocks = (count + kParallelBlock - 1) / kParallelBlock;
+    std::vector<uint64_t> partial(blocks, 0);
+    ParallelFor(blocks, [&](size_t b) {
+        const size_t begin = b * kParallelBlock;
+        partial[b] = block_sum(begin, std::min(kParallelBlock, count - begin));
+    }, 1);
+    uint64_t total = 0;
+    for (uint64_t value : partial) total += value;
+    return static_cast<int64_t>(total);
+}
+
+}  // namespace
+
+int64_t SumCents(const int64_t* cents, size_t count) {
+    return static_cast<int64_t>(SumBlock(cents, count));
+}
+
+int64_t SumCentsInTimeRange(const int64_t* cents, const TimePoint* times, size_t count,
+                            const TimePoint& start, const TimePoint& end) {
+    return static_cast<int64_t>(SumBlockInTimeRange(cents, times, count,
+                                                    start.time_since_epoch().count(),
+                                                    end.time_since_epoch().count()));
+}
+
+int64_t ParallelSumCents(const int64_t* cents, size_t count) {
+    return SumBlocks(count, [cents](size_t begin, size_t n) {
+        return SumBlock(cents + begin, n);
+    });
+}
+
+int64_t ParallelSumCentsInTimeRange(const int64_t* cents, const TimePoint* times, size_t count,
+                                    const TimePoint& start, const TimePoint& end) {
+    const int64_t lo = start.time_since_epoch().count();
+    const int64_t hi = end.time_since_epoch().count();
+    return SumBlocks(count, [cents, times, lo, hi](size_t begin, size_t n) {
+        return SumBlockInTimeRange(cents + begin, times + begin, n, lo, hi);
+    });
+}
+
+}  // namespace money_sum
+}  // namespace accounting
@@ -0,0 +1,195 @@
+#include "utils/time_utils.h"
+
+namespace accounting {
+namespace time_utils {
+
+// ===== 日历换算（Howard Hinnant 的 days_from_civil / civil_from_days） =====
+int64_t DaysFromCivil(int year, int month, int day) {
+    // 月份越界时先进位到年份，日期越界由线性加法自然进位
+    int64_t y = year + (month - 1 >= 0 ? (month - 1) / 12 : (month - 12) / 12);
+    int64_t m = ((month - 1) % 12 + 12) % 12 + 1;
+    y -= m <= 2;
+    const int64_t era = (y >= 0 ? y : y - 399) / 400;
+    const int64_t yoe = y - era * 400;                                  // [0, 399]
+    const int64_t doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + day - 1;  // [0, 365]
+    const int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;          // [0, 146096]
+    return era * 146097 + doe - 719468;
+}
+
+void CivilFromDays(int64_t days, int& year, int& month, int& day) {
+    days += 719468;
+    const int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+    const int64_t doe = days - era * 146097;
+    const int64_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const int64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const int64_t mp = (5 * doy + 2) / 153;
+    day = static_cast<int>(doy - (153 * mp + 2) / 5 + 1);
+    month = static_cast<int>(mp < 10 ? mp + 3 : mp - 9);
+    year = static_cast<int>(yoe + era * 400 + (month <= 2));
+}
+
+static int64_t FloorDiv(int64_t a, int64_t b) {
+    return a / b - ((a % b != 0) && ((a < 0) != (b < 0)));
+}
+
+// ===== 时区偏移缓存 =====
+namespace {
+
+constexpr int64_t kBucketSeconds = 15 * 60;
+constexpr size_t kCacheSize = 1024;  // 直接映射，约覆盖 10 天的连续时间
+
+struct OffsetCacheEntry {
+    int64_t bucket = INT64_MIN;
+    int64_t offset = 0;
+};
+
+int64_t ComputeOffset(std::time_t t) {
+    std::tm tm{};
+#ifdef _WIN32
+    if (localtime_s(&tm, &t) != 0) return 0;
+#else
+    if (!localtime_r(&t, &tm)) return 0;
+#endif
+    const int64_t local = DaysFromCivil(tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday) * 86400 +
+                          tm.tm_hour * 3600 + tm.tm_min * 60 + tm.tm_sec;
+    return local - static_cast<int64_t>(t);
+}
+
+}  // namespace
+
+int64_t LocalUtcOffset(std::time_t t) {
+    thread_local OffsetCacheEntry cache[kCacheSize];
+    const int64_t bucket = FloorDiv(static_cast<int64_t>(t), kBucketSeconds);
+    OffsetCacheEntry& entry = cache[static_cast<size_t>(bucket) % kCacheSize];
+    if (entry.bucket != bucket) {
+        entry.bucket = bucket;
+        entry.offset = ComputeOffset(static_cast<std::time_t>(bucket * kBucketSeconds));
+    }
+    return entry.offset;
+}
+
+// ===== 本地时间 <-> time_point =====
+std::chrono::system_clock::time_point LocalToTimePoint(const CivilTime& local) {
+    const int64_t local_seconds = DaysFromCivil(local.year, local.month, local.day) * 86400 +
+                                  int64_t(local.hour) * 3600 + int64_t(local.minute) * 60 +
+                                  local.second;
+    // 先用本地时间近似 UTC 取偏移，再用修正后的 UTC 取一次，处理夏令时切换附近的时间
+    int64_t utc = local_seconds - LocalUtcOffset(static_cast<std::time_t>(local_seconds));
+    utc = local_seconds - LocalUtcOffset(static_cast<std::time_t>(utc));
+    return std::chrono::system_clock::from_time_t(static_cast<std::time_t>(utc));
+}
+
+CivilTime TimePointToLocal(const std::chrono::system_clock::time_point& tp) {
+    const std::time_t t = std::chrono::system_clock::to_time_t(tp);
+    const int64_t local = static_cast<int64_t>(t) + LocalUtcOffset(t);
+    const int64_t days = FloorDiv(local, 86400);
+    const int64_t secs = local - days * 86400;
+
+    CivilTime out;
+    CivilFromDays(days, out.year, out.month, out.day);
+    out.hour = static_cast<int>(secs / 3600);
+    out.minute = static_cast<int>(secs / 60 % 60);
+    out.second = static_cast<int>(secs % 60);
+    return out;
+}
+
+int64_t LocalDayNumber(const std::chrono::system_clock::time_point& tp) {
+    const std::time_t t = std::chrono::system_clock::to_time_t(tp);
+    return FloorDiv(static_cast<int64_t>(t) + LocalUtcOffset(t), 86400);
+}
+
+std::chrono::system_clock::time_point LocalDayStart(int64_t days) {
+    CivilTime local;
+    CivilFromDays(days, local.year, local.month, local.day);
+    return LocalToTimePoint(local);
+}
+
+// ===== 解析 / 格式化 =====
+static bool ReadDigits(const char* p, int count, int& value) {
+    value = 0;
+    for (int i = 0; i < count; ++i) {
+        if (p[i] < '0' || p[i] > '9') return false;
+        value = value * 10 + (p[i] - '0');
+    }
+    return true;
+}
+
+bool ParseDateTime(const char* text, size_t length, CivilTime& out) {
+    // 年份：可选负号 + 4 到 9 位数字（常见的 4 位年份不带负号，长度为 10 或 19）
+    const bool negative = length > 0 && text[0] == '-';
+    size_t year_end = negative ? 1 : 0;
+    while (year_end < length && text[year_end] >= '0' && text[year_end] <= '9') ++year_end;
+    const size_t year_digits = year_end - (negative ? 1 : 0);
+    if (year_digits < 4 || year_digits > 9) return false;
+    const size_t rest = length - year_end;
+    if (rest != 6 && rest != 15) return false;
+
+    CivilTime t;
+    if (!ReadDigits(text + year_end - year_digits, static_cast<int>(year_digits), t.year)) {
+        return false;
+    }
+    if (negative) t.year = -t.year;
+    const char* p = text + year_end;
+    if (p[0] != '-' || !ReadDigits(p + 1, 2, t.month) || p[3] != '-' ||
+        !ReadDigits(p + 4, 2, t.day)) {
+        return false;
+    }
+    if (rest == 15) {
+        if (p[6] != ' ' ||
+            !ReadDigits(p + 7, 2, t.hour) || p[9] != ':' ||
+            !ReadDigits(p + 10, 2, t.minute) || p[12] != ':' ||
+            !ReadDigits(p + 13, 2, t.second)) {
+            return false;
+        }
+    }
+    if (t.month < 1 || t.month > 12 || t.day < 1 || t.day > 31 ||
+        t.hour > 23 || t.minute > 59 || t.second > 60) {
+        return false;
+    }
+    out = t;
+    return true;
+}
+
+static char* WriteDigits(char* p, int64_t value, int count) {
+    for (int i = count - 1; i >= 0; --i) {
+        p[i] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    }
+    return p + count;
+}
+
+std::string FormatDateTime(const std::chrono::system_clock::time_point& tp) {
+    return FormatDateTime(TimePointToLocal(tp));
+}
+
+std::string FormatDateTime(const CivilTime& t) {
+    // 年份最多带负号和 10 位数字
+    char buf[30];
+    char* p = buf;
+    if (t.year >= 0 && t.year <= 9999) {
+        p = WriteDigits(p, t.year, 4);
+    } else {
+        int64_t year = t.year;
+        if (year < 0) {
+            *p++ = '-';
+            year = -year;
+        }
+        int digits = 4;
+        for (int64_t x = year; x >= 10000; x /= 10) ++digits;
+        p = WriteDigits(p, year, digits);
+    }
+    *p++ = '-';
+    p = WriteDigits(p, t.month, 2);
+    *p++ = '-';
+    p = WriteDigits(p, t.day, 2);
+    *p++ = ' ';
+    p = WriteDigits(p, t.hour, 2);
+    *p++ = ':';
+    p = WriteDigits(p, t.minute, 2);
+    *p++ = ':';
+    p = WriteDigits(p, t.second, 2);
+    return std::string(buf, static_cast<size_t>(p - buf));
+}
+
+}  // namespace time_utils
+}  // namespace accounting
@@ -1,15 +1,29 @@
 #include <gtest/gtest.h>
+#include <algorithm>
 #include <chrono>
+#include <cstring>
 #include <filesystem>
+#include <fstream>
+#include <limits>
+#include <map>
 #include <memory>
+#include <set>
+#include <sstream>
 #include <vector>
 #include "core/account_manager.h"
+#include "managers/bill_manager.h"
 #include "managers/category_manager.h"
+#include "managers/report_manager.h"
 #include "models/bill.h"
 #include "models/category.h"
 #include "models/user.h"
 #include "storage/storage.h"
 #include "storage/json_storage.h"
+#include "storage/binary_storage.h"
+#include "storage/binary_bill_format.h"
+#include "storage/bill_json_reader.h"
+#include "storage/storage_migration.h"
+#include "utils/time_utils.h"
 
 using namespace accounting;
 
@@ -51,6 +65,1094 @@ TEST_F(JsonStorageTest, TestSaveLoadCategories) {
     ASSERT_EQ(loaded_categories[0].GetName(), "餐饮") << "分类名称不对";
 }
 
+// 测试：账单变更日志模式下，增删改通过日志重放恢复，达到阈值后合并进快照
+TEST(JsonStorageBillLogTest, TestReplayAndCheckpoint) {
+    const std::string dir = "./test_data/test_bill_log";
+    std::filesystem::remove_all(dir);
+
+    JsonStorageOptions options;
+    options.enable_bill_log = true;
+    auto storage = std::make_shared<JsonStorage>(dir, options);
+    CategoryManager category_manager(storage);
+
+    BillManager bill_manager;
+    ASSERT_TRUE(bill_manager.LoadFromStorage(storage, category_manager));
+    bill_manager.SetCheckpointInterval(0);  // 关闭自动合并
+
+    for (int i = 0; i < 3; ++i) {
+        Bill bill;
+        bill.SetAmount(10.0 * (i + 1));
+        bill.SetContent("bill " + std::to_string(i));
+        ASSERT_TRUE(bill_manager.AddBill(1, bill));
+    }
+    Bill updated = bill_manager.GetBillsByUser(1)[0];
+    updated.SetAmount(99.0);
+    ASSERT_TRUE(bill_manager.UpdateBill(1, updated));
+    ASSERT_TRUE(bill_manager.DeleteBill(1, 2));
+
+    // 日志模式下保存不写快照；日志已落盘，不再有未保存的修改
+    ASSERT_TRUE(bill_manager.SaveToStorage(storage));
+    EXPECT_FALSE(bill_manager.IsDirty());
+    EXPECT_FALSE(std::filesystem::exists(dir + "/bills.json"));
+    EXPECT_TRUE(std::filesystem::exists(dir + "/bills.log"));
+
+    // 重新加载：快照为空，全部由日志恢复
+    auto storage2 = std::make_shared<JsonStorage>(dir, options);
+    BillManager reloaded;
+    ASSERT_TRUE(reloaded.LoadFromStorage(storage2, category_manager));
+    auto bills = reloaded.GetBillsByUser(1);
+    ASSERT_EQ(bills.size(), 2);
+    EXPECT_EQ(bills[0].GetAmount(), 99.0);
+    EXPECT_EQ(bills[1].GetBillId(), 3);
+
+    // 达到阈值后自动合并：写出 bills.json 并清空日志
+    reloaded.SetCheckpointInterval(1);
+    Bill extra;
+    extra.SetAmount(5.0);
+    ASSERT_TRUE(reloaded.AddBill(1, extra));
+    EXPECT_TRUE(std::filesystem::exists(dir + "/bills.json"));
+    EXPECT_FALSE(std::filesystem::exists(dir + "/bills.json.tmp"));  // 临时文件已替换为快照
+    EXPECT_FALSE(std::filesystem::exists(dir + "/bills.log"));
+
+    // 非日志模式也能读取快照
+    auto plain = std::make_shared<JsonStorage>(dir);
+    BillManager from_snapshot;
+    ASSERT_TRUE(from_snapshot.LoadFromStorage(plain, category_manager));
+    EXPECT_EQ(from_snapshot.GetBillsByUser(1).size(), 3);
+
+    // 每条记录写入后即落盘的模式：日志格式与重放结果不变
+    JsonStorageOptions synced_options = options;
+    synced_options.sync_bill_log = true;
+    auto synced = std::make_shared<JsonStorage>(dir, synced_options);
+    BillManager synced_manager;
+    ASSERT_TRUE(synced_manager.LoadFromStorage(synced, category_manager));
+    synced_manager.SetCheckpointInterval(0);
+    ASSERT_TRUE(synced_manager.AddBill(1, extra));
+    EXPECT_TRUE(std::filesystem::exists(dir + "/bills.log"));
+    ASSERT_TRUE(synced_manager.SaveToStorage(synced));
+    BillManager after_sync;
+    ASSERT_TRUE(after_sync.LoadFromStorage(std::make_shared<JsonStorage>(dir, options),
+                                           category_manager));
+    EXPECT_EQ(after_sync.GetBillsByUser(1).size(), 4);
+
+    // 按用户加载时，只在日志中的修改先合并进快照再释放，重新加载后仍在
+    BillManager lazy;
+    lazy.SetLazyLoading(true);
+    auto lazy_storage = std::make_shared<JsonStorage>(dir, options);
+    ASSERT_TRUE(lazy.LoadFromStorage(lazy_storage, category_manager));
+    lazy.SetCheckpointInterval(0);
+    ASSERT_TRUE(lazy.LoadUser(1));
+    ASSERT_TRUE(lazy.AddBill(1, extra));
+    ASSERT_TRUE(lazy.SaveToStorage(lazy_storage));
+    EXPECT_FALSE(lazy.IsDirty());
+    EXPECT_TRUE(lazy.EvictUser(1));
+    EXPECT_FALSE(std::filesystem::exists(dir + "/bills.log"));
+    ASSERT_TRUE(lazy.LoadUser(1));
+    EXPECT_EQ(lazy.GetBillsByUser(1).size(), 5);
+
+    std::filesystem::remove_all(dir);
+}
+
+TEST(BillManagerIndexTest, TestBulkUpdateAndDelete) {
+    BillManager bill_manager;
+    const int kCount = 1000;
+    for (int i = 1; i <= kCount; ++i) {
+        Bill bill;
+        bill.SetBillId(i);
+        bill.SetAmount(i);
+        ASSERT_TRUE(bill_manager.AddBill(1, bill));
+    }
+    Bill duplicate;
+    duplicate.SetBillId(500);
+    EXPECT_FALSE(bill_manager.AddBill(1, duplicate));
+
+    // 删除所有偶数 id，被移动到空位的账单之后仍能按 id 找到
+    for (int i = 2; i <= kCount; i += 2) ASSERT_TRUE(bill_manager.DeleteBill(1, i));
+    EXPECT_FALSE(bill_manager.DeleteBill(1, 2));
+    for (int i = 1; i <= kCount; i += 2) {
+        Bill updated;
+        updated.SetBillId(i);
+        updated.SetAmount(-i);
+        ASSERT_TRUE(bill_manager.UpdateBill(1, updated));
+    }
+    Bill missing;
+    missing.SetBillId(kCount + 1);
+    EXPECT_FALSE(bill_manager.UpdateBill(1, missing));
+
+    auto bills = bill_manager.GetBillsByUser(1);
+    ASSERT_EQ(bills.size(), kCount / 2);
+    std::set<int> ids;
+    for (const auto& bill : bills) {
+        EXPECT_EQ(bill.GetBillId() % 2, 1);
+        EXPECT_EQ(bill.GetAmount(), -bill.GetBillId());
+        ids.insert(bill.GetBillId());
+    }
+    EXPECT_EQ(ids.size(), kCount / 2);
+
+    // 自动分配的 id 接在已用过的最大 id 之后
+    ASSERT_TRUE(bill_manager.AddBill(1, Bill()));
+    EXPECT_EQ(bill_manager.GetBillsByUser(1).back().GetBillId(), kCount + 1);
+}
+
+TEST(BillManagerIndexTest, TestTimeRangeQuery) {
+    BillManager bill_manager;
+    auto t0 = std::chrono::system_clock::from_time_t(1700000000);
+    // 乱序插入，时间索引需要保持有序
+    for (int day : {5, 1, 9, 3, 7, 3}) {
+        Bill bill;
+        bill.SetTime(t0 + std::chrono::hours(24 * day));
+        bill.SetAmount(day);
+        ASSERT_TRUE(bill_manager.AddBill(1, bill));
+    }
+    auto in_range = [&](int first_day, int last_day) {
+        std::vector<int> days;
+        for (const auto& bill : bill_manager.GetBillsInTimeRange(
+                 1, t0 + std::chrono::hours(24 * first_day), t0 + std::chrono::hours(24 * last_day))) {
+            days.push_back(static_cast<int>(bill.GetAmount()));
+        }
+        return days;
+    };
+    EXPECT_EQ(in_range(3, 7), std::vector<int>({3, 3, 5, 7}));
+    EXPECT_EQ(in_range(0, 100), std::vector<int>({1, 3, 3, 5, 7, 9}));
+    EXPECT_TRUE(in_range(10, 20).empty());
+    EXPECT_TRUE(in_range(7, 3).empty());
+
+    // 建立索引后的修改同步到索引
+    Bill moved = bill_manager.GetBillsByUser(1)[0];  // day 5
+    moved.SetTime(t0 + std::chrono::hours(24 * 8));
+    moved.SetAmount(8);
+    ASSERT_TRUE(bill_manager.UpdateBill(1, moved));
+    ASSERT_TRUE(bill_manager.DeleteBill(1, bill_manager.GetBillsByUser(1)[1].GetBillId()));  // day 1
+    Bill added;
+    added.SetTime(t0 + std::chrono::hours(24 * 4));
+    added.SetAmount(4);
+    ASSERT_TRUE(bill_manager.AddBill(1, added));
+    EXPECT_EQ(in_range(0, 100), std::vector<int>({3, 3, 4, 7, 8, 9}));
+
+    QueryCriteria criteria;
+    criteria.SetStartDate(t0 + std::chrono::hours(24 * 4));
+    criteria.SetEndDate(t0 + std::chrono::hours(24 * 8));
+    EXPECT_EQ(bill_manager.QueryBillsByCriteria(1, criteria).size(), 3);
+}
+
+TEST(BillManagerIndexTest, TestCategoryIndex) {
+    BillManager bill_manager;
+    auto t0 = std::chrono::system_clock::from_time_t(1700000000);
+    for (int i = 0; i < 12; ++i) {
+        Bill bill;
+        bill.SetTime(t0 + std::chrono::hours(24 * (12 - i)));
+        bill.SetCategoryId(i % 3);
+        bill.SetAmount(i);
+        ASSERT_TRUE(bill_manager.AddBill(1, bill));
+    }
+    auto amounts = [](const std::vector<Bill>& bills) {
+        std::vector<int> out;
+        for (const auto& bill : bills) out.push_back(static_cast<int>(bill.GetAmount()));
+        return out;
+    };
+    // 同一分类内按时间升序
+    EXPECT_EQ(amounts(bill_manager.GetBillsByCategory(1, 1)), std::vector<int>({10, 7, 4, 1}));
+    EXPECT_EQ(amounts(bill_manager.GetBillsByCategoryInTimeRange(
+                  1, 0, t0 + std::chrono::hours(24 * 3), t0 + std::chrono::hours(24 * 9))),
+              std::vector<int>({9, 6, 3}));
+    EXPECT_TRUE(bill_manager.GetBillsByCategory(1, 5).empty());
+
+    // 修改分类、删除后索引同步
+    Bill moved = bill_manager.GetBillsByUser(1)[1];  // amount 1, 分类 1
+    moved.SetCategoryId(2);
+    ASSERT_TRUE(bill_manager.UpdateBill(1, moved));
+    ASSERT_TRUE(bill_manager.DeleteBill(1, bill_manager.GetBillsByUser(1)[4].GetBillId()));  // amount 4
+    EXPECT_EQ(amounts(bill_manager.GetBillsByCategory(1, 1)), std::vector<int>({10, 7}));
+    EXPECT_EQ(amounts(bill_manager.GetBillsByCategory(1, 2)), std::vector<int>({11, 8, 5, 2, 1}));
+}
+
+// 测试：遍历接口与返回 vector 的查询结果一致，分页只取对应区间
+TEST(BillManagerIndexTest, TestForEachBillViews) {
+    BillManager bill_manager;
+    auto t0 = std::chrono::system_clock::from_time_t(1700000000);
+    for (int i = 0; i < 10; ++i) {
+        Bill bill;
+        bill.SetTime(t0 + std::chrono::hours(10 - i));
+        bill.SetCategoryId(i % 2);
+        bill.SetAmount(i);
+        bill.SetContent("备注" + std::to_string(i));
+        ASSERT_TRUE(bill_manager.AddBill(1, bill));
+    }
+
+    std::vector<int> seen;
+    bill_manager.ForEachBill(1, [&seen](const BillView& bill) {
+        EXPECT_EQ(bill.content, "备注" + std::to_string(static_cast<int>(bill.amount.ToDouble())));
+        seen.push_back(static_cast<int>(bill.amount.ToDouble()));
+    });
+    EXPECT_EQ(seen, std::vector<int>({0, 1, 2, 3, 4, 5, 6, 7, 8, 9}));
+
+    seen.clear();
+    bill_manager.ForEachBillInTimeRange(1, t0 + std::chrono::hours(3), t0 + std::chrono::hours(6),
+                                        [&seen](const BillView& bill) {
+                                            seen.push_back(static_cast<int>(bill.amount.ToDouble()));
+                                        });
+    EXPECT_EQ(seen, std::vector<int>({7, 6, 5, 4}));
+
+    seen.clear();
+    bill_manager.ForEachBillInCategory(1, 1, [&seen](const BillView& bill) {
+        seen.push_back(static_cast<int>(bill.amount.ToDouble()));
+    });
+    EXPECT_EQ(seen, std::vector<int>({9, 7, 5, 3, 1}));
+
+    // 视图转回账单时与存储共享同一个分类对象，不复制
+    auto shared = std::make_shared<const Category>(1, "餐饮", "expense", "#FF6B6B");
+    Bill with_category(0, 3.0, shared, t0, "");
+    ASSERT_TRUE(bill_manager.AddBill(3, with_category));
+    bill_manager.ForEachBill(3, [&shared](const BillView& bill) {
+        EXPECT_EQ(bill.ToBill().GetCategory(), shared);
+    });
+    EXPECT_EQ(BillView::FromBill(with_category).ToBill().GetCategory(), shared);
+
+    EXPECT_EQ(bill_manager.CountBills(1), 10u);
+    EXPECT_EQ(bill_manager.CountBills(2), 0u);
+    auto page = bill_manager.GetBillsByUser(1, 8, 5);
+    ASSERT_EQ(page.size(), 2u);
+    EXPECT_EQ(page[0].GetAmount(), 8);
+    EXPECT_TRUE(bill_manager.GetBillsByUser(1, 10, 5).empty());
+}
+
+// 测试：游标分页按 (时间, id) 升序逐页返回，翻页期间的增删不会导致重复或遗漏
+TEST(BillManagerIndexTest, TestKeysetPaging) {
+    BillManager bill_manager;
+    auto t0 = std::chrono::system_clock::from_time_t(1700000000);
+    for (int i = 0; i < 25; ++i) {
+        Bill bill;
+        bill.SetTime(t0 + std::chrono::hours(i / 3));  // 每 3 个账单时间相同
+        bill.SetAmount(i);
+        ASSERT_TRUE(bill_manager.AddBill(1, bill));
+    }
+
+    std::vector<int> ids;
+    auto time = std::chrono::system_clock::time_point::min();
+    int bill_id = std::numeric_limits<int>::min();
+    for (int round = 0;; ++round) {
+        auto page = bill_manager.GetBillsAfter(1, time, bill_id, 4);
+        if (page.empty()) break;
+        EXPECT_LE(page.size(), 4u);
+        for (const auto& bill : page) ids.push_back(bill.GetBillId());
+        time = page.back().GetTime();
+        bill_id = page.back().GetBillId();
+        if (round == 1) {
+            // 删除已翻过的账单、在游标之前和之后各添加一个
+            ASSERT_TRUE(bill_manager.DeleteBill(1, 1));
+            Bill before;
+            before.SetTime(t0);
+            ASSERT_TRUE(bill_manager.AddBill(1, before));  // id 26，排在游标之前
+            Bill after;
+            after.SetTime(t0 + std::chrono::hours(100));
+            ASSERT_TRUE(bill_manager.AddBill(1, after));   // id 27，排在最后
+        }
+    }
+    std::vector<int> expected;
+    for (int id = 1; id <= 25; ++id) expected.push_back(id);
+    expected.push_back(27);
+    EXPECT_EQ(ids, expected);
+    EXPECT_TRUE(bill_manager.GetBillsAfter(2, std::chrono::system_clock::time_point::min(),
+                                           0, 4).empty());
+}
+
+// 测试：查询计划按选择性选择访问路径，各路径结果与逐行过滤再排序一致
+TEST(BillManagerIndexTest, TestQueryPlanner) {
+    BillManager bill_manager;
+    auto t0 = std::chrono::system_clock::from_time_t(1700000000);
+    std::vector<std::shared_ptr<const Category>> categories;
+    for (int id = 0; id < 5; ++id) {
+        categories.push_back(std::make_shared<const Category>(
+            id, "分类" + std::to_string(id), id == 0 ? "income" : "expense", "#000000"));
+    }
+    for (int i = 0; i < 200; ++i) {
+        Bill bill;
+        bill.SetTime(t0 + std::chrono::hours((i * 7) % 50));  // 时间有重复
+        bill.SetCategoryId(i % 5);
+        bill.SetCategory(categories[i % 5]);
+        bill.SetAmount((i * 13) % 40);
+        bill.SetContent(i % 4 == 0 ? "午饭" : "其他");
+        ASSERT_TRUE(bill_manager.AddBill(1, bill));
+    }
+    const std::vector<Bill> all = bill_manager.GetBillsByUser(1);
+
+    // 逐行过滤 + 稳定排序的参照结果
+    auto brute_force = [&all](const QueryCriteria& criteria) {
+        std::vector<Bill> out;
+        for (const auto& bill : all) {
+            QueryRow row;
+            row.bill_id = bill.GetBillId();
+            row.amount = bill.GetMoney();
+            row.time = bill.GetTime();
+            row.category_id = bill.GetCategoryId();
+            row.category_name = bill.GetCategory()->GetName();
+            row.category_type = bill.GetCategory()->GetType();
+            row.content = bill.GetContent();
+            if (criteria.Matches(row)) out.push_back(bill);
+        }
+        std::sort(out.begin(), out.end(), [&criteria](const Bill& a, const Bill& b) {
+            const bool by_time = criteria.GetSortField() == QueryCriteria::SortField::kTime;
+            const int64_t ka = by_time ? a.GetTime().time_since_epoch().count() : a.GetMoney().Cents();
+            const int64_t kb = by_time ? b.GetTime().time_since_epoch().count() : b.GetMoney().Cents();
+            if (ka != kb) return criteria.IsDescending() ? ka > kb : ka < kb;
+            return a.GetBillId() < b.GetBillId();
+        });
+        if (criteria.GetLimit() > 0 && out.size() > criteria.GetLimit()) {
+            out.resize(criteria.GetLimit());
+        }
+        return out;
+    };
+    auto ids = [](const std::vector<Bill>& bills) {
+        std::vector<int> out;
+        for (const auto& bill : bills) out.push_back(bill.GetBillId());
+        return out;
+    };
+    auto check = [&](const QueryCriteria& criteria, BillManager::QueryAccessPath path) {
+        EXPECT_EQ(bill_manager.PlanQuery(1, criteria), path) << criteria.ToString();
+        EXPECT_EQ(ids(bill_manager.QueryBillsByCriteria(1, criteria)), ids(brute_force(criteria)))
+            << criteria.ToString();
+    };
+
+    // 指定账单 id
+    QueryCriteria by_id;
+    by_id.AddBillId(5);
+    by_id.AddBillId(150);
+    by_id.AddBillId(999);
+    check(by_id, BillManager::QueryAccessPath::kBillId);
+
+    // 单个分类 + 金额范围 + 备注，按金额降序取前 7 条
+    QueryCriteria by_category;
+    by_category.AddCategoryId(3);
+    by_category.SetAmountRange(Money::FromCents(500), Money::FromCents(3000));
+    by_category.SetContentContains("其他");
+    by_category.SetSort(QueryCriteria::SortField::kAmount, true);
+    by_category.SetLimit(7);
+    check(by_category, BillManager::QueryAccessPath::kCategoryIndex);
+
+    // 窄时间范围
+    QueryCriteria by_time;
+    by_time.SetStartDate(t0 + std::chrono::hours(10));
+    by_time.SetEndDate(t0 + std::chrono::hours(12));
+    check(by_time, BillManager::QueryAccessPath::kTimeIndex);
+
+    // 按时间降序取前 9 条（边界上有同一时间的多条账单）
+    QueryCriteria latest;
+    latest.SetSort(QueryCriteria::SortField::kTime, true);
+    latest.SetLimit(9);
+    check(latest, BillManager::QueryAccessPath::kTimeIndex);
+
+    // 只按类型 / 或 / 非过滤时只能全表扫描
+    QueryCriteria scan;
+    scan.SetCategoryType("expense");
+    scan.SetWhere(QueryPredicate::Or(
+        {QueryPredicate::ContentContains("午饭"),
+         QueryPredicate::Not(QueryPredicate::AmountRange(Money::FromCents(0), Money::FromCents(2000)))}));
+    scan.SetSort(QueryCriteria::SortField::kAmount, false);
+    check(scan, BillManager::QueryAccessPath::kScan);
+
+    // 没有 CategoryManager 时分类名称无法解析，退回扫描并按名称匹配
+    QueryCriteria by_names;
+    by_names.AddCategoryName("分类1");
+    by_names.AddCategoryName("分类4");
+    check(by_names, BillManager::QueryAccessPath::kScan);
+    EXPECT_EQ(bill_manager.QueryBillsByCriteria(1, by_names).size(), 80u);
+
+    // ForEachBillMatching 与 QueryBillsByCriteria 顺序一致
+    std::vector<int> seen;
+    bill_manager.ForEachBillMatching(1, by_category, [&seen](const BillView& bill) {
+        seen.push_back(bill.bill_id);
+    });
+    EXPECT_EQ(seen, ids(brute_force(by_category)));
+}
+
+// 测试：分类汇总随增删改同步，不过滤的报表与逐个账单生成的报表一致
+TEST(BillManagerIndexTest, TestCategoryTotals) {
+    BillManager bill_manager;
+    ReportManager report_manager(&bill_manager);
+    auto food = std::make_shared<const Category>(1, "餐饮", "expense", "#ff0000");
+    auto salary = std::make_shared<const Category>(2, "工资", "income", "#00ff00");
+    auto t0 = std::chrono::system_clock::from_time_t(1700000000);
+    for (int i = 0; i < 10; ++i) {
+        Bill bill;
+        bill.SetTime(t0 + std::chrono::hours(i));
+        bill.SetCategoryId(i % 3 == 0 ? 2 : 1);
+        bill.SetCategory(i % 3 == 0 ? salary : food);
+        bill.SetMoney(Money::FromCents(100 * i + 1));
+        ASSERT_TRUE(bill_manager.AddBill(1, bill));
+    }
+    Bill uncategorized;
+    uncategorized.SetMoney(Money::FromCents(7));
+    ASSERT_TRUE(bill_manager.AddBill(1, uncategorized));
+
+    auto totals = [&bill_manager]() {
+        std::map<int, std::pair<int64_t, size_t>> out;
+        bill_manager.ForEachCategoryTotal(
+            1, [&out](int category_id, const Category*, const BillManager::CategoryTotal& total) {
+                out[category_id] = {total.total.Cents(), total.count};
+            });
+        return out;
+    };
+    auto brute_force = [&bill_manager]() {
+        std::map<int, std::pair<int64_t, size_t>> out;
+        for (const auto& bill : bill_manager.GetBillsByUser(1)) {
+            auto& entry = out[bill.GetCategoryId()];
+            entry.first += bill.GetMoney().Cents();
+            ++entry.second;
+        }
+        return out;
+    };
+    auto expect_report_matches = [&]() {
+        std::vector<BillData> bill_data;
+        for (const auto& bill : bill_manager.GetBillsByUser(1)) {
+            bill_data.emplace_back(bill.GetMoney(),
+                                   bill.GetCategory() ? bill.GetCategory()->GetName() : "",
+                                   bill.GetCategory() ? bill.GetCategory()->GetType() : "",
+                                   bill.GetTime(), bill.GetContent());
+        }
+        Report expected = Report::Generate(bill_data, QueryCriteria(), Period::kCustom,
+                                           ChartType::kBar);
+        Report report = report_manager.GenerateReport(1, QueryCriteria(), Period::kCustom,
+                                                      ChartType::kBar);
+        EXPECT_EQ(report.GetTotalIncomeMoney(), expected.GetTotalIncomeMoney());
+        EXPECT_EQ(report.GetTotalExpenseMoney(), expected.GetTotalExpenseMoney());
+        EXPECT_EQ(report.GetCategorySummary(), expected.GetCategorySummary());
+    };
+
+    EXPECT_EQ(totals(), brute_force());
+    expect_report_matches();
+
+    // 建立汇总之后的增删改、批量添加按差值更新
+    Bill moved = bill_manager.GetBillsByUser(1)[3];
+    moved.SetCategoryId(1);
+    moved.SetCategory(food);
+    moved.SetMoney(Money::FromCents(5));
+    ASSERT_TRUE(bill_manager.UpdateBill(1, moved));
+    ASSERT_TRUE(bill_manager.DeleteBill(1, 5));
+    ASSERT_TRUE(bill_manager.DeleteBill(1, 11));  // 唯一的无分类账单
+    std::vector<Bill> batch(3);
+    for (auto& bill : batch) {
+        bill.SetCategoryId(2);
+        bill.SetCategory(salary);
+        bill.SetMoney(Money::FromCents(1000));
+    }
+    bill_manager.AddBills(1, batch);
+    EXPECT_EQ(totals(), brute_force());
+    EXPECT_EQ(totals().count(-1), 0u);  // 分类下账单全部删除后不再出现
+    expect_report_matches();
+    EXPECT_EQ(report_manager.GetLastReport(1)->GetTotalIncomeMoney().Cents(), 1 + 601 + 901 + 3000);
+}
+
+// 测试：按日汇总随账单保存、重新加载后直接使用；与账单或时区不一致时重新计算。
+// 按整天的报表与逐个账单生成的报表一致
+TEST(BillRollupStorageTest, TestSaveLoadAndReports) {
+    const std::string dir = "./test_data/test_bill_rollups";
+    std::filesystem::remove_all(dir);
+    auto storage = std::make_shared<JsonStorage>(dir);
+    CategoryManager category_manager(storage);
+    User user(1, "rollup_user");
+    category_manager.AddCategory(user, Category(1, "餐饮", "expense", "#ff0000"));
+    category_manager.AddCategory(user, Category(2, "工资", "income", "#00ff00"));
+
+    BillManager bill_manager;
+    ASSERT_TRUE(bill_manager.LoadFromStorage(storage, category_manager));
+    const int64_t first_day = 19500;
+    auto t0 = time_utils::LocalDayStart(first_day);
+    for (int i = 0; i < 90; ++i) {
+        Bill bill;
+        bill.SetTime(t0 + std::chrono::hours(i * 9));
+        bill.SetCategoryId(i % 4 == 0 ? 2 : 1);
+        bill.SetMoney(Money::FromCents(1000 + i));
+        ASSERT_TRUE(bill_manager.AddBill(1, bill));
+    }
+    const auto expected = bill_manager.SumInDays(1, first_day + 5, first_day + 20);
+    ASSERT_GT(expected.count, 0u);
+    ASSERT_TRUE(bill_manager.SaveToStorage(storage));
+    EXPECT_TRUE(std::filesystem::exists(dir + "/bill_rollups.json"));
+
+    // 报表：按整天过滤、按周分段，与逐个账单生成的结果一致
+    ReportManager report_manager(&bill_manager);
+    QueryCriteria criteria;
+    criteria.SetStartDate(time_utils::LocalDayStart(first_day + 3));
+    criteria.SetEndDate(time_utils::LocalDayStart(first_day + 17) -
+                        std::chrono::system_clock::duration(1));
+    std::vector<BillData> bill_data;
+    for (const auto& bill : bill_manager.QueryBillsByCriteria(1, criteria)) {
+        bill_data.emplace_back(bill.GetMoney(), bill.GetCategory()->GetName(),
+                               bill.GetCategory()->GetType(), bill.GetTime(), bill.GetContent());
+    }
+    Report from_bills =
+        Report::Generate(bill_data, QueryCriteria(), Period::kWeekly, ChartType::kLine);
+    Report from_rollups = report_manager.GenerateReport(1, criteria, Period::kWeekly,
+                                                        ChartType::kLine);
+    EXPECT_EQ(from_rollups.GetTotalIncomeMoney(), from_bills.GetTotalIncomeMoney());
+    EXPECT_EQ(from_rollups.GetTotalExpenseMoney(), from_bills.GetTotalExpenseMoney());
+    EXPECT_EQ(from_rollups.GetCategorySummary(), from_bills.GetCategorySummary());
+    ASSERT_EQ(from_rollups.GetSeries().size(), from_bills.GetSeries().size());
+    for (size_t i = 0; i < from_bills.GetSeries().size(); ++i) {
+        EXPECT_EQ(from_rollups.GetSeries()[i].label, from_bills.GetSeries()[i].label);
+        EXPECT_EQ(from_rollups.GetSeries()[i].category_summary,
+                  from_bills.GetSeries()[i].category_summary);
+    }
+
+    // 重新加载后结果不变
+    auto reload = [&]() {
+        auto manager = std::make_unique<BillManager>();
+        EXPECT_TRUE(manager->LoadFromStorage(std::make_shared<JsonStorage>(dir), category_manager));
+        return manager;
+    };
+    auto reloaded = reload();
+    EXPECT_EQ(reloaded->SumInDays(1, first_day + 5, first_day + 20).total, expected.total);
+
+    // 保存的汇总确实被直接使用：把一天的汇总挪到别的日期（校验和不变）后，查询结果随之改变
+    auto stored = storage->LoadBillRollups();
+    ASSERT_TRUE(stored.first);
+    ASSERT_EQ(stored.second.count(1), 1u);
+    BillRollupSnapshot tampered = stored.second.at(1);
+    for (auto& entry : tampered.entries) {
+        if (entry.day == first_day + 5) entry.day = first_day + 100;
+    }
+    tampered.day_fingerprint = BillRollup::DayFingerprint(tampered.entries);
+    ASSERT_TRUE(storage->SaveBillRollups({{1, tampered}}));
+    EXPECT_NE(reload()->SumInDays(1, first_day + 5, first_day + 20).total, expected.total);
+
+    // 终点精确到秒（CLI 旧写法的 23:59:59）、之后当天没有账单时同样按整天使用汇总
+    {
+        auto tampered_manager = reload();
+        ReportManager tampered_reports(tampered_manager.get());
+        QueryCriteria cli_criteria;
+        cli_criteria.SetStartDate(time_utils::LocalDayStart(first_day + 3));
+        cli_criteria.SetEndDate(time_utils::LocalDayStart(first_day + 17) - std::chrono::seconds(1));
+        Report tampered_report = tampered_reports.GenerateReport(1, cli_criteria, Period::kCustom,
+                                                                 ChartType::kBar);
+        EXPECT_NE(tampered_report.GetTotalExpenseMoney(), from_bills.GetTotalExpenseMoney());
+    }
+
+    // 本地日期边界与写入时不同（时区规则变化）时丢弃保存的汇总
+    BillRollupSnapshot other_zone = tampered;
+    other_zone.day_fingerprint += 1;
+    ASSERT_TRUE(storage->SaveBillRollups({{1, other_zone}}));
+    EXPECT_EQ(reload()->SumInDays(1, first_day + 5, first_day + 20).total, expected.total);
+
+    // 校验和与账单不一致时丢弃保存的汇总，重新计算
+    tampered.checksum += 1;
+    ASSERT_TRUE(storage->SaveBillRollups({{1, tampered}}));
+    reloaded = reload();
+    EXPECT_EQ(reloaded->SumInDays(1, first_day + 5, first_day + 20).total, expected.total);
+    EXPECT_EQ(reloaded->SumCategoryInDays(1, 2, first_day, first_day + 1000).count, 23u);
+
+    // 终点之后当天还有账单时不能按整天汇总，该账单不计入
+    Bill late;
+    late.SetTime(time_utils::LocalDayStart(first_day + 17) - std::chrono::milliseconds(500));
+    late.SetCategoryId(1);
+    late.SetMoney(Money::FromCents(777));
+    ASSERT_TRUE(reloaded->AddBill(1, late));
+    ReportManager late_reports(reloaded.get());
+    QueryCriteria cli_criteria;
+    cli_criteria.SetStartDate(time_utils::LocalDayStart(first_day + 3));
+    cli_criteria.SetEndDate(time_utils::LocalDayStart(first_day + 17) - std::chrono::seconds(1));
+    EXPECT_EQ(late_reports.GenerateReport(1, cli_criteria, Period::kCustom, ChartType::kBar)
+                  .GetTotalExpenseMoney(),
+              from_bills.GetTotalExpenseMoney());
+
+    std::filesystem::remove_all(dir);
+}
+
+// 测试：带过滤条件的报表直接在账单视图上按分类 id 汇总，与复制成 BillData 后生成的结果一致
+TEST(ReportManagerTest, TestDirectAggregationMatchesBillData) {
+    BillManager bill_manager;
+    ReportManager report_manager(&bill_manager);
+    auto food = std::make_shared<const Category>(1, "餐饮", "expense", "#ff0000");
+    auto salary = std::make_shared<const Category>(2, "工资", "income", "#00ff00");
+    auto t0 = std::chrono::system_clock::from_time_t(1700000000);
+    for (int i = 0; i < 60; ++i) {
+        Bill bill;
+        bill.SetTime(t0 + std::chrono::hours(i * 7));
+        if (i % 5 != 4) {  // 每 5 个账单有 1 个无分类
+            bill.SetCategoryId(i % 3 == 0 ? 2 : 1);
+            bill.SetCategory(i % 3 == 0 ? salary : food);
+        }
+        bill.SetMoney(Money::FromCents(37 * i + 3));
+        ASSERT_TRUE(bill_manager.AddBill(1, bill));
+    }
+
+    QueryCriteria criteria;
+    criteria.SetAmountRange(Money::FromCents(100), Money::FromCents(1800));
+    std::vector<BillData> bill_data;
+    for (const auto& bill : bill_manager.QueryBillsByCriteria(1, criteria)) {
+        bill_data.emplace_back(bill.GetMoney(),
+                               bill.GetCategory() ? bill.GetCategory()->GetName() : "",
+                               bill.GetCategory() ? bill.GetCategory()->GetType() : "",
+                               bill.GetTime(), bill.GetContent());
+    }
+    for (Period period : {Period::kCustom, Period::kDaily, Period::kWeekly}) {
+        Report expected = Report::Generate(bill_data, QueryCriteria(), period, ChartType::kBar);
+        Report report = report_manager.GenerateReport(1, criteria, period, ChartType::kBar);
+        EXPECT_EQ(report.GetTotalIncomeMoney(), expected.GetTotalIncomeMoney());
+        EXPECT_EQ(report.GetTotalExpenseMoney(), expected.GetTotalExpenseMoney());
+        EXPECT_EQ(report.GetCategorySummary(), expected.GetCategorySummary());
+        ASSERT_EQ(report.GetSeries().size(), expected.GetSeries().size());
+        for (size_t i = 0; i < expected.GetSeries().size(); ++i) {
+            EXPECT_EQ(report.GetSeries()[i].label, expected.GetSeries()[i].label);
+            EXPECT_EQ(report.GetSeries()[i].category_summary,
+                      expected.GetSeries()[i].category_summary);
+        }
+    }
+    EXPECT_EQ(report_manager.GetLastReport(1)->GetCategorySummary().count("Uncategorized"), 1u);
+}
+
+// 测试：相同条件的报表直接取缓存；账单修改后缓存按版本号失效；缓存数量受 LRU 上限约束
+TEST(ReportCacheTest, TestHitInvalidateAndEvict) {
+    BillManager bill_manager;
+    ReportCacheOptions options;
+    options.max_entries = 2;
+    ReportManager report_manager(&bill_manager, options);
+    auto food = std::make_shared<const Category>(1, "餐饮", "expense", "#ff0000");
+    auto t0 = std::chrono::system_clock::from_time_t(1700000000);
+    for (int i = 0; i < 5; ++i) {
+        Bill bill;
+        bill.SetTime(t0 + std::chrono::hours(i));
+        bill.SetCategoryId(1);
+        bill.SetCategory(food);
+        bill.SetMoney(Money::FromCents(100));
+        ASSERT_TRUE(bill_manager.AddBill(1, bill));
+    }
+
+    QueryCriteria criteria;
+    criteria.SetAmountRange(Money::FromCents(1), Money::FromCents(1000));
+    Report first = report_manager.GenerateReport(1, criteria, Period::kDaily, ChartType::kBar);
+    EXPECT_EQ(first.GetTotalExpenseMoney().Cents(), 500);
+    EXPECT_EQ(report_manager.CachedReportCount(), 1u);
+    EXPECT_GT(report_manager.CachedReportBytes(), 0u);
+
+    // 相同条件命中缓存；条件相同但对象不同也算相同
+    QueryCriteria same;
+    same.SetAmountRange(Money::FromCents(1), Money::FromCents(1000));
+    EXPECT_EQ(same.CacheKey(), criteria.CacheKey());
+    Report again = report_manager.GenerateReport(1, same, Period::kDaily, ChartType::kBar);
+    EXPECT_EQ(again.GetCategorySummary(), first.GetCategorySummary());
+    EXPECT_EQ(report_manager.CachedReportCount(), 1u);
+
+    // 修改账单后版本号变化，下一次生成反映新账单
+    const uint64_t version = bill_manager.DataVersion(1);
+    Bill extra;
+    extra.SetTime(t0);
+    extra.SetCategoryId(1);
+    extra.SetCategory(food);
+    extra.SetMoney(Money::FromCents(50));
+    ASSERT_TRUE(bill_manager.AddBill(1, extra));
+    EXPECT_GT(bill_manager.DataVersion(1), version);
+    EXPECT_EQ(bill_manager.DataVersion(2), bill_manager.DataVersion(3));  // 其他用户不受影响
+    EXPECT_EQ(report_manager.GenerateReport(1, criteria, Period::kDaily, ChartType::kBar)
+                  .GetTotalExpenseMoney().Cents(), 550);
+    EXPECT_EQ(report_manager.CachedReportCount(), 1u);
+
+    // 不同条件、周期得到不同的缓存项；超过上限时淘汰最久未用的
+    QueryCriteria narrower;
+    narrower.SetAmountRange(Money::FromCents(1), Money::FromCents(60));
+    EXPECT_NE(narrower.CacheKey(), criteria.CacheKey());
+    EXPECT_EQ(report_manager.GenerateReport(1, narrower, Period::kDaily, ChartType::kBar)
+                  .GetTotalExpenseMoney().Cents(), 50);
+    report_manager.GenerateReport(1, criteria, Period::kMonthly, ChartType::kBar);
+    EXPECT_EQ(report_manager.CachedReportCount(), 2u);
+    EXPECT_EQ(report_manager.GetLastReport(1)->GetPeriod(), Period::kMonthly);
+
+    report_manager.ClearReports(1);
+    EXPECT_EQ(report_manager.CachedReportCount(), 0u);
+    EXPECT_EQ(report_manager.CachedReportBytes(), 0u);
+    EXPECT_FALSE(report_manager.GetLastReport(1).has_value());
+}
+
+// 测试：二进制列式账单快照与 JSON 互相转换后数据一致
+TEST(BillJsonReaderTest, TestMatchesDomLoader) {
+    const std::string text = R"([
+        [1, [
+            {"bill_id": 1, "amount": 12.5, "category_id": 3, "time": "2024-01-02 03:04:05", "content": "午餐"},
+            {"amount": 8, "bill_id": 2, "category_id": null, "time": "2024-01-03 00:00:00", "content": "",
+             "extra": {"nested": [1, 2, {"x": null}]}}
+        ]],
+        [2, []]
+    ])";
+
+    std::map<int, std::vector<Bill>> sax;
+    std::istringstream input(text);
+    ASSERT_TRUE(ReadBillsJson(input, sax));
+    auto dom = json::parse(text).get<std::map<int, std::vector<Bill>>>();
+
+    ASSERT_EQ(sax.size(), dom.size());
+    ASSERT_EQ(sax[1].size(), 2);
+    EXPECT_TRUE(sax[2].empty());
+    for (size_t i = 0; i < dom[1].size(); ++i) {
+        EXPECT_EQ(sax[1][i].GetBillId(), dom[1][i].GetBillId());
+        EXPECT_EQ(sax[1][i].GetAmount(), dom[1][i].GetAmount());
+        EXPECT_EQ(sax[1][i].GetCategoryId(), dom[1][i].GetCategoryId());
+        EXPECT_EQ(sax[1][i].GetTime(), dom[1][i].GetTime());
+        EXPECT_EQ(sax[1][i].GetContent(), dom[1][i].GetContent());
+    }
+
+    // 超出 int 范围的金额照常读取，只有 id 需要换算成 int
+    std::map<int, std::vector<Bill>> large;
+    std::istringstream large_input(
+        R"([[1, [{"bill_id": 1, "amount": 3e9, "content": "", "time": "2024-01-01 00:00:00"}]]])");
+    ASSERT_TRUE(ReadBillsJson(large_input, large));
+    EXPECT_EQ(large[1][0].GetMoney().Cents(), 300000000000);
+
+    // 缺少必填字段、类型错误、id 超出 int 范围或 JSON 不完整时失败
+    for (const char* bad : {R"([[1, [{"bill_id": 1, "amount": 1.0, "time": "2024-01-01 00:00:00"}]]])",
+                            R"([[1, [{"bill_id": "1", "amount": 1.0, "content": "", "time": ""}]]])",
+                            R"([[1, [{"bill_id": 3000000000, "amount": 1, "content": "", "time": ""}]]])",
+                            R"([[1, [{"bill_id": 1, "amount": 1, "category_id": -3e9, "content": "", "time": ""}]]])",
+                            R"([[1e10, []]])",
+                            R"([[1, [{"bill_id": 1, "amount": 1e300, "content": "", "time": ""}]]])",
+                            R"([[1, [{"bill_id": 1)"}) {
+        std::map<int, std::vector<Bill>> out;
+        std::istringstream bad_input(bad);
+        EXPECT_FALSE(ReadBillsJson(bad_input, out)) << bad;
+    }
+}
+
+TEST(BinaryStorageTest, TestConvertRoundTrip) {
+    const std::string json_dir = "./test_data/test_binary_json";
+    const std::string bin_dir = "./test_data/test_binary_bin";
+    const std::string back_dir = "./test_data/test_binary_back";
+    for (const auto& dir : {json_dir, bin_dir, back_dir}) std::filesystem::remove_all(dir);
+
+    auto json_storage = std::make_shared<JsonStorage>(json_dir);
+    std::map<int, std::vector<Category>> categories;
+    categories[1] = {Category(1, "餐饮", "expense", "#FF6B6B")};
+    ASSERT_TRUE(json_storage->SaveCategoriesByUser(categories));
+
+    auto t0 = std::chrono::system_clock::from_time_t(1700000000);
+    std::map<int, std::vector<Bill>> bills;
+    bills[1].emplace_back(1, 12.5, std::make_shared<Category>(categories[1][0]), t0, "午餐");
+    bills[1].emplace_back(2, 3.0, nullptr, t0 + std::chrono::hours(1), "");
+    bills[2].emplace_back(7, 100.0, nullptr, t0 + std::chrono::hours(2), "other user");
+    ASSERT_TRUE(json_storage->SaveBillsByUser(bills));
+
+    auto bin_storage = std::make_shared<BinaryStorage>(bin_dir);
+    ASSERT_TRUE(MigrateStorage(json_storage, bin_storage));
+    EXPECT_TRUE(std::filesystem::exists(bin_dir + "/bills.bin"));
+
+    auto loaded = bin_storage->LoadBillsByUser();
+    ASSERT_TRUE(loaded.first);
+    ASSERT_EQ(loaded.second[1].size(), 2);
+    ASSERT_EQ(loaded.second[2].size(), 1);
+    EXPECT_EQ(loaded.second[1][0].GetContent(), "午餐");
+    EXPECT_EQ(loaded.second[1][0].GetCategoryId(), 1);
+    EXPECT_EQ(loaded.second[1][0].GetAmount(), 12.5);
+    EXPECT_EQ(loaded.second[1][0].GetTime(), t0);
+    EXPECT_EQ(loaded.second[1][1].GetCategoryId(), -1);
+    EXPECT_EQ(loaded.second[2][0].GetBillId(), 7);
+
+    auto back_storage = std::make_shared<JsonStorage>(back_dir);
+    ASSERT_TRUE(MigrateStorage(bin_storage, back_storage));
+    auto back = back_storage->LoadBillsByUser();
+    ASSERT_TRUE(back.first);
+    ASSERT_EQ(back.second[1].size(), 2);
+    EXPECT_EQ(back.second[1][1].GetTime(), t0 + std::chrono::hours(1));
+    EXPECT_EQ(back.second[2][0].GetContent(), "other user");
+
+    for (const auto& dir : {json_dir, bin_dir, back_dir}) std::filesystem::remove_all(dir);
+}
+
+TEST(JsonStorageEncodingTest, TestCborAndMessagePackRoundTrip) {
+    const std::string dir = "./test_data/test_json_encoding";
+    std::filesystem::remove_all(dir);
+
+    auto t0 = std::chrono::system_clock::from_time_t(1700000000);
+    std::map<int, std::vector<Category>> categories;
+    categories[1] = {Category(1, "餐饮", "expense", "#FF6B6B")};
+    std::map<int, std::vector<Bill>> bills;
+    bills[1].emplace_back(1, 12.5, std::make_shared<Category>(categories[1][0]), t0, "午餐");
+    bills[1].emplace_back(2, -3.0, nullptr, t0 + std::chrono::hours(1), "");
+
+    for (auto encoding : {JsonStorageOptions::Encoding::kCbor,
+                          JsonStorageOptions::Encoding::kMessagePack}) {
+        JsonStorageOptions options;
+        options.encoding = encoding;
+        auto storage = std::make_shared<JsonStorage>(dir, options);
+        ASSERT_TRUE(storage->SaveCategoriesByUser(categories));
+        ASSERT_TRUE(storage->SaveBillsByUser(bills));
+
+        auto loaded_categories = storage->LoadCategoriesByUser();
+        ASSERT_TRUE(loaded_categories.first);
+        ASSERT_EQ(loaded_categories.second[1].size(), 1);
+        EXPECT_EQ(loaded_categories.second[1][0].GetName(), "餐饮");
+
+        auto loaded = storage->LoadBillsByUser();
+        ASSERT_TRUE(loaded.first);
+        ASSERT_EQ(loaded.second[1].size(), 2);
+        EXPECT_EQ(loaded.second[1][0].GetCategoryId(), 1);
+        EXPECT_EQ(loaded.second[1][0].GetAmount(), 12.5);
+        EXPECT_EQ(loaded.second[1][1].GetAmount(), -3.0);
+        EXPECT_EQ(loaded.second[1][1].GetTime(), t0 + std::chrono::hours(1));
+    }
+    EXPECT_TRUE(std::filesystem::exists(dir + "/bills.cbor"));
+    EXPECT_TRUE(std::filesystem::exists(dir + "/bills.msgpack"));
+    EXPECT_FALSE(std::filesystem::exists(dir + "/bills.json"));
+
+    // 编码不匹配时读取失败，而不是得到空数据
+    std::filesystem::copy_file(dir + "/bills.cbor", dir + "/bills.json");
+    EXPECT_FALSE(JsonStorage(dir).LoadBillsByUser().first);
+
+    std::filesystem::remove_all(dir);
+}
+
+// 测试：bills.bin 按分存储金额，超出 double 精确范围的金额原样往返；版本 1 的 double 金额文件仍可读取
+TEST(BinaryStorageTest, TestAmountStoredAsCents) {
+    namespace fmt = binary_bill_format;
+    const std::string dir = "./test_data/test_binary_cents";
+    std::filesystem::remove_all(dir);
+
+    auto t0 = std::chrono::system_clock::from_time_t(1700000000);
+    const Money large = Money::FromCents((int64_t(1) << 53) + 1);  // double 无法精确表示
+    std::map<int, std::vector<Bill>> bills;
+    bills[1].emplace_back(1, 0.0, nullptr, t0, "large");
+    bills[1][0].SetMoney(large);
+    auto storage = std::make_shared<BinaryStorage>(dir);
+    ASSERT_TRUE(storage->SaveBillsByUser(bills));
+    auto loaded = storage->LoadBillsByUser();
+    ASSERT_TRUE(loaded.first);
+    ASSERT_EQ(loaded.second[1].size(), 1);
+    EXPECT_EQ(loaded.second[1][0].GetMoney(), large);
+
+    // 改写成版本 1：金额列换成 double（元）
+    bills[1][0].SetMoney(Money::FromCents(1250));
+    ASSERT_TRUE(storage->SaveBillsByUser(bills));
+    const std::string path = dir + "/bills.bin";
+    std::vector<char> bytes(std::filesystem::file_size(path));
+    {
+        std::ifstream in(path, std::ios::binary);
+        in.read(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    }
+    fmt::FileHeader header;
+    fmt::UserEntry entry;
+    std::memcpy(&header, bytes.data(), sizeof(header));
+    std::memcpy(&entry, bytes.data() + sizeof(header), sizeof(entry));
+    header.version = fmt::kDoubleAmountVersion;
+    std::memcpy(bytes.data(), &header, sizeof(header));
+    const double yuan = 12.5;
+    const auto layout = fmt::BlockLayout::For(entry.bill_count, entry.content_bytes);
+    std::memcpy(bytes.data() + entry.block_offset + layout.amount, &yuan, sizeof(yuan));
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    }
+    loaded = storage->LoadBillsByUser();
+    ASSERT_TRUE(loaded.first);
+    ASSERT_EQ(loaded.second[1].size(), 1);
+    EXPECT_EQ(loaded.second[1][0].GetMoney(), Money::FromCents(1250));
+    EXPECT_EQ(loaded.second[1][0].GetContent(), "large");
+
+    std::filesystem::remove_all(dir);
+}
+
+TEST(BinaryStorageTest, TestLazySnapshotBillManager) {
+    const std::string dir = "./test_data/test_binary_lazy";
+    std::filesystem::remove_all(dir);
+
+    auto storage = std::make_shared<BinaryStorage>(dir);
+    std::map<int, std::vector<Category>> categories;
+    categories[1] = {Category(1, "餐饮", "expense", "#FF6B6B")};
+    ASSERT_TRUE(storage->SaveCategoriesByUser(categories));
+
+    auto t0 = std::chrono::system_clock::from_time_t(1700000000);
+    std::map<int, std::vector<Bill>> bills;
+    bills[1].emplace_back(1, 12.5, std::make_shared<Category>(categories[1][0]), t0, "午餐");
+    bills[1].emplace_back(2, 3.0, nullptr, t0 + std::chrono::hours(1), "公交");
+    bills[2].emplace_back(7, 100.0, nullptr, t0, "other user");
+    ASSERT_TRUE(storage->SaveBillsByUser(bills));
+
+    CategoryManager category_manager(storage);
+    ASSERT_TRUE(category_manager.LoadFromStorage());
+    BillManager manager;
+    ASSERT_TRUE(manager.LoadFromStorage(storage, category_manager));
+
+    // 未修改的用户直接从快照读取，分类指针已恢复
+    auto user1 = manager.GetBillsByUser(1);
+    ASSERT_EQ(user1.size(), 2);
+    ASSERT_NE(user1[0].GetCategory(), nullptr);
+    EXPECT_EQ(user1[0].GetCategory()->GetName(), "餐饮");
+
+    QueryCriteria criteria;
+    criteria.SetCategoryName("餐饮");
+    auto matched = manager.QueryBillsByCriteria(1, criteria);
+    ASSERT_EQ(matched.size(), 1);
+    EXPECT_EQ(matched[0].GetContent(), "午餐");
+
+    // 修改用户 1 后与未修改的用户 2 一起写回
+    ASSERT_TRUE(manager.AddBill(1, Bill(0, 8.0, nullptr, t0, "晚餐")));
+    ASSERT_TRUE(manager.DeleteBill(1, 2));
+    EXPECT_EQ(manager.GetBillsByUser(1).back().GetBillId(), 3);
+    ASSERT_TRUE(manager.SaveToStorage(storage));
+
+    BillManager reloaded;
+    ASSERT_TRUE(reloaded.LoadFromStorage(storage, category_manager));
+    auto user1_after = reloaded.GetBillsByUser(1);
+    ASSERT_EQ(user1_after.size(), 2);
+    EXPECT_EQ(user1_after[1].GetContent(), "晚餐");
+    ASSERT_EQ(reloaded.GetBillsByUser(2).size(), 1);
+    EXPECT_EQ(reloaded.GetBillsByUser(2)[0].GetContent(), "other user");
+
+    std::filesystem::remove_all(dir);
+}
+
+TEST(ShardedJsonStorageTest, TestPerUserLoadAndSave) {
+    const std::string dir = "./test_data/test_sharded";
+    const std::string flat_dir = "./test_data/test_sharded_flat";
+    for (const auto& d : {dir, flat_dir}) std::filesystem::remove_all(d);
+
+    JsonStorageOptions options;
+    options.layout = JsonStorageOptions::Layout::kSharded;
+    auto storage = std::make_shared<JsonStorage>(dir, options);
+
+    std::map<int, std::vector<Category>> categories;
+    categories[1] = {Category(1, "餐饮", "expense", "#FF6B6B")};
+    ASSERT_TRUE(storage->SaveCategoriesByUser(categories));
+    auto t0 = std::chrono::system_clock::from_time_t(1700000000);
+    std::map<int, std::vector<Bill>> bills;
+    bills[1].emplace_back(1, 12.5, std::make_shared<Category>(categories[1][0]), t0, "午餐");
+    bills[2].emplace_back(1, 100.0, nullptr, t0, "other user");
+    ASSERT_TRUE(storage->SaveBillsByUser(bills));
+    EXPECT_TRUE(std::filesystem::exists(dir + "/users/1/bills.json"));
+    EXPECT_TRUE(std::filesystem::exists(dir + "/users/2/bills.json"));
+    EXPECT_EQ(storage->LoadBillsForUser(2).second.size(), 1);
+
+    CategoryManager category_manager(storage);
+    ASSERT_TRUE(category_manager.LoadFromStorage());
+    BillManager manager;
+    ASSERT_TRUE(manager.LoadFromStorage(storage, category_manager));
+
+    // 启动时不读取账单：加载后再改动的用户 2 文件在 LoadUser 时才被读到
+    std::map<int, std::vector<Bill>> user2;
+    user2[2].emplace_back(5, 1.0, nullptr, t0, "changed");
+    ASSERT_TRUE(storage->SaveBillsForUsers(user2));
+    ASSERT_TRUE(manager.LoadUser(2));
+    ASSERT_EQ(manager.GetBillsByUser(2).size(), 1);
+    EXPECT_EQ(manager.GetBillsByUser(2)[0].GetContent(), "changed");
+
+    // 只修改用户 1：保存时不重写用户 2 的文件
+    std::filesystem::remove(dir + "/users/2/bills.json");
+    ASSERT_TRUE(manager.AddBill(1, Bill(0, 8.0, nullptr, t0, "晚餐")));
+    ASSERT_TRUE(manager.SaveToStorage(storage));
+    EXPECT_FALSE(std::filesystem::exists(dir + "/users/2/bills.json"));
+    auto user1 = storage->LoadBillsForUser(1);
+    ASSERT_TRUE(user1.first);
+    ASSERT_EQ(user1.second.size(), 2);
+    EXPECT_EQ(user1.second[0].GetCategoryId(), 1);
+
+    // 分片布局与单文件布局互相转换
+    ASSERT_TRUE(manager.AddBill(3, Bill(0, 2.0, nullptr, t0, "new user")));
+    ASSERT_TRUE(manager.SaveToStorage(storage));
+    auto flat = std::make_shared<JsonStorage>(flat_dir);
+    ASSERT_TRUE(MigrateStorage(storage, flat));
+    auto flat_bills = flat->LoadBillsByUser();
+    ASSERT_TRUE(flat_bills.first);
+    EXPECT_EQ(flat_bills.second[1].size(), 2);
+    EXPECT_EQ(flat_bills.second[3].size(), 1);
+    EXPECT_EQ(flat->LoadCategoriesByUser().second[1].size(), 1);
+
+    for (const auto& d : {dir, flat_dir}) std::filesystem::remove_all(d);
+}
+
+// 测试：按用户加载时，卸载的用户保留按日汇总：保存时不丢弃，未加载时直接用于统计而不读取账单
+TEST(ShardedJsonStorageTest, TestEvictedUserKeepsRollup) {
+    const std::string dir = "./test_data/test_sharded_rollups";
+    std::filesystem::remove_all(dir);
+
+    JsonStorageOptions options;
+    options.layout = JsonStorageOptions::Layout::kSharded;
+    auto storage = std::make_shared<JsonStorage>(dir, options);
+    auto t0 = time_utils::LocalDayStart(19500);
+    std::map<int, std::vector<Bill>> bills;
+    for (int i = 0; i < 20; ++i) {
+        bills[1].emplace_back(i + 1, 1.0 + i, nullptr, t0 + std::chrono::hours(i * 7), "");
+    }
+    bills[2].emplace_back(1, 100.0, nullptr, t0, "other user");
+    ASSERT_TRUE(storage->SaveBillsByUser(bills));
+
+    CategoryManager category_manager(storage);
+    ASSERT_TRUE(category_manager.LoadFromStorage());
+    BillManager manager;
+    ASSERT_TRUE(manager.LoadFromStorage(storage, category_manager));
+    ASSERT_TRUE(manager.LoadUser(1));
+    const auto expected = manager.SumInDays(1, 19501, 19504);
+    ASSERT_GT(expected.count, 0u);
+    ASSERT_TRUE(manager.EvictUser(1));
+
+    // 之后只有用户 2 的汇总变化，用户 1 的汇总仍在存储中
+    ASSERT_TRUE(manager.LoadUser(2));
+    EXPECT_EQ(manager.SumInDays(2, 19500, 19500).count, 1u);
+    ASSERT_TRUE(manager.SaveToStorage(storage));
+    auto stored = storage->LoadBillRollups();
+    ASSERT_TRUE(stored.first);
+    EXPECT_EQ(stored.second.count(1), 1u);
+    EXPECT_EQ(stored.second.count(2), 1u);
+
+    // 未加载的用户 1 直接使用卸载时留下的汇总（账单文件已不可读也不影响结果）
+    std::filesystem::remove(dir + "/users/1/bills.json");
+    EXPECT_FALSE(manager.IsUserLoaded(1));
+    EXPECT_EQ(manager.SumInDays(1, 19501, 19504).total, expected.total);
+    EXPECT_EQ(manager.SumCategoryInDays(1, -1, 19501, 19504).count, expected.count);
+
+    std::filesystem::remove_all(dir);
+}
+
+// 测试：分片布局下汇总按用户保存，LoadUser 时读取该用户的汇总，保存时只写汇总有变化的用户
+TEST(ShardedJsonStorageTest, TestRollupsStoredPerUser) {
+    const std::string dir = "./test_data/test_sharded_rollup_shards";
+    std::filesystem::remove_all(dir);
+
+    JsonStorageOptions options;
+    options.layout = JsonStorageOptions::Layout::kSharded;
+    auto storage = std::make_shared<JsonStorage>(dir, options);
+    auto t0 = time_utils::LocalDayStart(19500);
+    std::map<int, std::vector<Bill>> bills;
+    for (int i = 0; i < 20; ++i) {
+        bills[1].emplace_back(i + 1, 1.0 + i, nullptr, t0 + std::chrono::hours(i * 7), "");
+    }
+    bills[2].emplace_back(1, 100.0, nullptr, t0, "other user");
+    ASSERT_TRUE(storage->SaveBillsByUser(bills));
+
+    CategoryManager category_manager(storage);
+    ASSERT_TRUE(category_manager.LoadFromStorage());
+    BillManager manager;
+    ASSERT_TRUE(manager.LoadFromStorage(storage, category_manager));
+    ASSERT_TRUE(manager.LoadUser(1));
+    ASSERT_TRUE(manager.LoadUser(2));
+    const auto expected = manager.SumInDays(1, 19501, 19504);
+    ASSERT_GT(expected.count, 0u);
+    EXPECT_EQ(manager.SumInDays(2, 19500, 19500).count, 1u);
+    ASSERT_TRUE(manager.SaveToStorage(storage));
+    EXPECT_TRUE(std::filesystem::exists(dir + "/users/1/bill_rollup.json"));
+    EXPECT_TRUE(std::filesystem::exists(dir + "/users/2/bill_rollup.json"));
+    EXPECT_FALSE(std::filesystem::exists(dir + "/bill_rollups.json"));
+
+    // 只修改用户 1：保存时不重写用户 2 的汇总
+    std::filesystem::remove(dir + "/users/2/bill_rollup.json");
+    ASSERT_TRUE(manager.AddBill(1, Bill(0, 5.0, nullptr, t0 + std::chrono::hours(30), "")));
+    ASSERT_TRUE(manager.SaveToStorage(storage));
+    EXPECT_FALSE(std::filesystem::exists(dir + "/users/2/bill_rollup.json"));
+    auto saved = storage->LoadBillRollupForUser(1);
+    ASSERT_TRUE(saved.first);
+    ASSERT_NE(saved.second, nullptr);
+    EXPECT_EQ(saved.second->bill_count, 21);
+
+    // 重新加载后 LoadUser 直接使用该用户保存的汇总：把一天的汇总挪走后查询结果随之改变
+    BillRollupSnapshot tampered = *saved.second;
+    for (auto& entry : tampered.entries) {
+        if (entry.day == 19502) entry.day = 19600;
+    }
+    tampered.day_fingerprint = BillRollup::DayFingerprint(tampered.entries);
+    ASSERT_TRUE(storage->SaveBillRollupsForUsers({{1, tampered}}));
+    BillManager reloaded;
+    ASSERT_TRUE(reloaded.LoadFromStorage(std::make_shared<JsonStorage>(dir, options),
+                                         category_manager));
+    ASSERT_TRUE(reloaded.LoadUser(1));
+    EXPECT_NE(reloaded.SumInDays(1, 19501, 19504).total, manager.SumInDays(1, 19501, 19504).total);
+
+    std::filesystem::remove_all(dir);
+}
+
 // ==================== CategoryManager 测试 ====================
 class CategoryManagerTest : public ::testing::Test {
 protected:
@@ -159,6 +1261,400 @@ TEST_F(AccountManagerTest, TestUserCategoryIntegration) {
     ASSERT_EQ(bills[0].GetContent(), "午餐") << "账单内容不对";
 }
 
+// 测试：日期范围内的支出合计与按同一日期范围查询到的账单之和一致
+TEST_F(AccountManagerTest, TestTotalExpenseMatchesDateRangeBills) {
+    ASSERT_TRUE(account_manager->RegisterUser("range_user", "password123"));
+    auto user_ptr = account_manager->Login("range_user", "password123");
+    ASSERT_TRUE(user_ptr != nullptr);
+    const int user_id = user_ptr->GetUserId();
+    ASSERT_TRUE(account_manager->AddCategory(*user_ptr, Category(1, "餐饮", "expense", "#FF6B6B")));
+    auto category = account_manager->GetCategory(*user_ptr, 1);
+
+    std::chrono::system_clock::time_point day10, day15;
+    ASSERT_TRUE(account_manager->ParseDateStringToTimePoint("2024-03-10", day10));
+    ASSERT_TRUE(account_manager->ParseDateStringToTimePoint("2024-03-15", day15));
+    // 起始日期前一刻、起始日期 0 点、区间中、结束日期 0 点、结束日期当天
+    const std::vector<std::chrono::system_clock::time_point> times = {
+        day10 - std::chrono::hours(1), day10, day10 + std::chrono::hours(60), day15,
+        day15 + std::chrono::hours(8)};
+    double amount = 1.0;
+    for (const auto& time : times) {
+        ASSERT_TRUE(account_manager->AddBill(user_id, Bill(0, amount, category, time, "")));
+        amount *= 2;
+    }
+
+    auto sum_bills = [](const std::vector<Bill>& bills) {
+        double total = 0.0;
+        for (const auto& bill : bills) total += bill.GetAmount();
+        return total;
+    };
+    const std::vector<std::pair<std::string, std::string>> ranges = {
+        {"2024-03-10", "2024-03-15"}, {"2024-03-15", "2024-03-15"}, {"2024-03-09", "2024-03-16"}};
+    for (const auto& [start, end] : ranges) {
+        EXPECT_DOUBLE_EQ(account_manager->GetTotalExpense(user_id, start, end),
+                         sum_bills(account_manager->GetBillsByDateRange(user_id, start, end)));
+        EXPECT_DOUBLE_EQ(
+            account_manager->GetTotalExpenseByCategory(user_id, 1, start, end),
+            sum_bills(account_manager->GetBillsByCategoryAndDate(user_id, 1, start, end)));
+    }
+    EXPECT_DOUBLE_EQ(account_manager->GetTotalExpense(user_id, "2024-03-10", "2024-03-15"), 14.0);
+}
+
+// ==================== 增量保存测试 ====================
+// 记录每类数据的写入次数，并声明支持按用户保存
+class CountingStorage : public JsonStorage {
+public:
+    using JsonStorage::JsonStorage;
+
+    bool SupportsPartialSave() const override { return true; }
+
+    bool SaveUsers(const std::vector<User>& users) override {
+        ++user_saves;
+        return JsonStorage::SaveUsers(users);
+    }
+    bool SaveBillsByUser(const std::map<int, std::vector<Bill>>& data) override {
+        ++full_bill_saves;
+        return JsonStorage::SaveBillsByUser(data);
+    }
+    bool SaveBudgetsByUser(const std::map<int, Budget>& data) override {
+        ++full_budget_saves;
+        return JsonStorage::SaveBudgetsByUser(data);
+    }
+    bool SaveCategoriesForUsers(const std::map<int, std::vector<Category>>& data) override {
+        for (const auto& [user_id, _] : data) category_users.push_back(user_id);
+        return true;
+    }
+    bool SaveBillsForUsers(const std::map<int, std::vector<Bill>>& data) override {
+        for (const auto& [user_id, _] : data) bill_users.push_back(user_id);
+        return true;
+    }
+    bool SaveBudgetsForUsers(const std::map<int, Budget>& data) override {
+        for (const auto& [user_id, _] : data) budget_users.push_back(user_id);
+        return true;
+    }
+
+    int user_saves = 0;
+    int full_bill_saves = 0;
+    int full_budget_saves = 0;
+    std::vector<int> category_users;
+    std::vector<int> bill_users;
+    std::vector<int> budget_users;
+};
+
+TEST(IncrementalSaveTest, TestOnlyDirtyUsersWritten) {
+    const std::string dir = "./test_data/test_incremental_save";
+    std::filesystem::remove_all(dir);
+
+    auto storage = std::make_shared<CountingStorage>(dir);
+    AccountManager manager(storage);
+    ASSERT_TRUE(manager.Initialize());
+
+    // 未修改时不写入任何数据
+    ASSERT_TRUE(manager.SaveAll());
+    EXPECT_EQ(storage->user_saves, 0);
+    EXPECT_EQ(storage->full_bill_saves, 0);
+    EXPECT_TRUE(storage->bill_users.empty());
+
+    // 只修改用户 2 的预算和用户 3 的账单
+    ASSERT_TRUE(manager.SetBudget(2, Budget()));
+    ASSERT_TRUE(manager.AddBill(3, Bill(0, 10.0, nullptr, std::chrono::system_clock::now(), "x")));
+    ASSERT_TRUE(manager.SaveAll());
+    EXPECT_EQ(storage->user_saves, 0);
+    EXPECT_EQ(storage->full_bill_saves, 0);
+    EXPECT_EQ(storage->full_budget_saves, 0);
+    EXPECT_TRUE(storage->category_users.empty());
+    EXPECT_EQ(storage->budget_users, std::vector<int>({2}));
+    EXPECT_EQ(storage->bill_users, std::vector<int>({3}));
+
+    // 保存后再次保存不重复写入
+    ASSERT_TRUE(manager.SaveAll());
+    EXPECT_EQ(storage->bill_users.size(), 1);
+
+    // 注册用户只影响用户表
+    ASSERT_TRUE(manager.RegisterUser("alice", "pw"));
+    ASSERT_TRUE(manager.SaveAll());
+    EXPECT_EQ(storage->user_saves, 1);
+    EXPECT_EQ(storage->budget_users.size(), 1);
+
+    std::filesystem::remove_all(dir);
+}
+
+TEST(LazyAccountManagerTest, TestHydrateOnLoginAndEvict) {
+    const std::string dir = "./test_data/test_lazy_account_manager";
+    std::filesystem::remove_all(dir);
+
+    JsonStorageOptions storage_options;
+    storage_options.layout = JsonStorageOptions::Layout::kSharded;
+    auto storage = std::make_shared<JsonStorage>(dir, storage_options);
+    auto t0 = std::chrono::system_clock::from_time_t(1700000000);
+    {
+        AccountManager seed(storage);
+        ASSERT_TRUE(seed.Initialize());
+        ASSERT_TRUE(seed.RegisterUser("alice", "password1"));
+        ASSERT_TRUE(seed.RegisterUser("bob", "password2"));
+        auto alice = seed.Login("alice", "password1");
+        ASSERT_TRUE(seed.AddCategory(*alice, Category(1, "餐饮", "expense", "#FF6B6B")));
+        Bill bill(0, 12.5, std::make_shared<Category>(seed.GetCategories(*alice)[0]), t0, "午餐");
+        ASSERT_TRUE(seed.AddBill(alice->GetUserId(), bill));
+        ASSERT_TRUE(seed.SaveAll());
+    }
+
+    AccountManagerOptions options;
+    options.lazy_load = true;
+    options.max_resident_users = 1;
+    AccountManager manager(storage, options);
+    ASSERT_TRUE(manager.Initialize());
+    EXPECT_TRUE(manager.GetResidentUsers().empty());
+
+    auto alice = manager.LoginEx("alice", "password1");
+    ASSERT_TRUE(alice.IsSuccess());
+    const int alice_id = alice.GetData()->GetUserId();
+    EXPECT_EQ(manager.GetResidentUsers(), std::vector<int>({alice_id}));
+    auto bills = manager.GetBills(alice_id);
+    ASSERT_EQ(bills.size(), 1);
+    ASSERT_NE(bills[0].GetCategory(), nullptr);
+    EXPECT_EQ(bills[0].GetCategory()->GetName(), "餐饮");
+
+    // bob 登录后 alice 最久未访问且没有未保存修改，被释放
+    auto bob = manager.LoginEx("bob", "password2");
+    ASSERT_TRUE(bob.IsSuccess());
+    const int bob_id = bob.GetData()->GetUserId();
+    EXPECT_EQ(manager.GetResidentUsers(), std::vector<int>({bob_id}));
+
+    // 有未保存修改的用户不会被释放；保存后再次释放
+    ASSERT_TRUE(manager.AddBill(bob_id, Bill(0, 3.0, nullptr, t0, "公交")));
+    ASSERT_TRUE(manager.LoginEx("alice", "password1").IsSuccess());
+    EXPECT_EQ(manager.GetResidentUsers(), std::vector<int>({alice_id, bob_id}));
+    ASSERT_TRUE(manager.SaveAll());
+    ASSERT_TRUE(manager.LoginEx("alice", "password1").IsSuccess());
+    ASSERT_TRUE(manager.LoginEx("bob", "password2").IsSuccess());
+    EXPECT_EQ(manager.GetResidentUsers(), std::vector<int>({bob_id}));
+
+    // 释放后的用户数据仍可读取，重新登录后与保存的一致
+    EXPECT_EQ(manager.GetBills(alice_id).size(), 1);
+    ASSERT_TRUE(manager.LoginEx("alice", "password1").IsSuccess());
+    EXPECT_EQ(manager.GetBills(alice_id)[0].GetContent(), "午餐");
+    EXPECT_EQ(manager.GetBills(bob_id).size(), 1);
+
+    std::filesystem::remove_all(dir);
+}
+
+TEST(LazyAccountManagerTest, TestDirtyUserIsNotPartiallyEvicted) {
+    const std::string dir = "./test_data/test_lazy_dirty_evict";
+    std::filesystem::remove_all(dir);
+
+    JsonStorageOptions storage_options;
+    storage_options.layout = JsonStorageOptions::Layout::kSharded;
+    auto storage = std::make_shared<JsonStorage>(dir, storage_options);
+    auto t0 = std::chrono::system_clock::from_time_t(1700000000);
+    auto food = std::make_shared<Category>(1, "餐饮", "expense", "#FF6B6B");
+    {
+        AccountManager seed(storage);
+        ASSERT_TRUE(seed.Initialize());
+        ASSERT_TRUE(seed.RegisterUser("alice", "password1"));
+        ASSERT_TRUE(seed.RegisterUser("bob", "password2"));
+        auto alice = seed.Login("alice", "password1");
+        ASSERT_TRUE(seed.AddCategory(*alice, *food));
+        Budget budget(1000.0, {});
+        budget.SetCategoryLimit(1, 10.0);
+        ASSERT_TRUE(seed.SetBudget(alice->GetUserId(), budget));
+        ASSERT_TRUE(seed.SaveAll());
+    }
+
+    AccountManagerOptions options;
+    options.lazy_load = true;
+    options.max_resident_users = 1;
+    AccountManager manager(storage, options);
+    ASSERT_TRUE(manager.Initialize());
+
+    auto alice = manager.Login("alice", "password1");
+    ASSERT_TRUE(alice);
+    const int alice_id = alice->GetUserId();
+    ASSERT_TRUE(manager.AddBill(alice_id, Bill(0, 5.0, food, t0, "早餐")));
+
+    // alice 的账单未保存：bob 登录时分类、预算也不能单独释放
+    auto bob = manager.Login("bob", "password2");
+    ASSERT_TRUE(bob);
+    EXPECT_EQ(manager.GetResidentUsers(), std::vector<int>({bob->GetUserId(), alice_id}));
+    ASSERT_TRUE(manager.Login("alice", "password1"));
+    // 与 CLI 一样按 id 取分类构造账单，分类缺失时预算检查会跳过分类限额
+    auto category = manager.GetCategory(*alice, 1);
+    ASSERT_NE(category, nullptr);
+    Bill dinner(0, 50.0, nullptr, t0, "聚餐");
+    dinner.SetCategory(category);
+    EXPECT_FALSE(manager.CanAddBill(alice_id, dinner));
+    auto bills = manager.GetBills(alice_id);
+    ASSERT_EQ(bills.size(), 1);
+    ASSERT_NE(bills[0].GetCategory(), nullptr);
+    EXPECT_EQ(bills[0].GetCategory()->GetName(), "餐饮");
+
+    // 保存后整体释放，再次登录时全部重新加载
+    ASSERT_TRUE(manager.SaveAll());
+    ASSERT_TRUE(manager.Login("bob", "password2"));
+    EXPECT_EQ(manager.GetResidentUsers(), std::vector<int>({bob->GetUserId()}));
+    ASSERT_TRUE(manager.Login("alice", "password1"));
+    category = manager.GetCategory(*alice, 1);
+    ASSERT_NE(category, nullptr);
+    dinner.SetCategory(category);
+    EXPECT_FALSE(manager.CanAddBill(alice_id, dinner));
+
+    std::filesystem::remove_all(dir);
+}
+
+TEST(ParallelInitializeTest, TestMatchesSequentialLoad) {
+    const std::string dir = "./test_data/test_parallel_initialize";
+    std::filesystem::remove_all(dir);
+
+    JsonStorageOptions storage_options;
+    storage_options.enable_bill_log = true;
+    auto storage = std::make_shared<JsonStorage>(dir, storage_options);
+    auto t0 = std::chrono::system_clock::from_time_t(1700000000);
+    {
+        AccountManager seed(storage);
+        ASSERT_TRUE(seed.Initialize());
+        for (const std::string name : {"alice", "bob", "carol"}) {
+            ASSERT_TRUE(seed.RegisterUser(name, "password1"));
+            auto user = seed.Login(name, "password1");
+            ASSERT_TRUE(seed.AddCategory(*user, Category(1, "餐饮", "expense", "#FF6B6B")));
+            auto category = std::make_shared<Category>(seed.GetCategories(*user)[0]);
+            for (int i = 0; i < 50; ++i) {
+                ASSERT_TRUE(seed.AddBill(user->GetUserId(),
+                                         Bill(0, i, category, t0 + std::chrono::hours(i), name)));
+            }
+        }
+        ASSERT_TRUE(seed.SaveAll());
+        // 保存后再追加的账单只在日志中，两种初始化都需要重放
+        auto alice = seed.Login("alice", "password1");
+        ASSERT_TRUE(seed.AddBill(alice->GetUserId(), Bill(0, 99.0, nullptr, t0, "日志")));
+    }
+
+    AccountManagerOptions sequential_options;
+    sequential_options.parallel_initialize = false;
+    AccountManager sequential(storage, sequential_options);
+    AccountManager parallel(storage);
+    ASSERT_TRUE(sequential.Initialize());
+    ASSERT_TRUE(parallel.Initialize());
+
+    for (const std::string name : {"alice", "bob", "carol"}) {
+        auto expected_user = sequential.Login(name, "password1");
+        auto actual_user = parallel.Login(name, "password1");
+        ASSERT_TRUE(expected_user && actual_user);
+        auto expected = sequential.GetBills(expected_user->GetUserId());
+        auto actual = parallel.GetBills(actual_user->GetUserId());
+        ASSERT_EQ(actual.size(), expected.size());
+        for (size_t i = 0; i < actual.size(); ++i) {
+            EXPECT_EQ(actual[i].GetBillId(), expected[i].GetBillId());
+            EXPECT_EQ(actual[i].GetCategoryId(), expected[i].GetCategoryId());
+            EXPECT_EQ(actual[i].GetCategory() != nullptr, expected[i].GetCategory() != nullptr);
+        }
+    }
+    auto alice = parallel.Login("alice", "password1");
+    EXPECT_EQ(parallel.GetBills(alice->GetUserId()).size(), 51);
+    EXPECT_NE(parallel.GetBills(alice->GetUserId())[0].GetCategory(), nullptr);
+
+    std::filesystem::remove_all(dir);
+}
+
+// 测试：同一分类的账单共享 CategoryManager 中的分类对象，重命名后账单随之更新
+TEST(SharedCategoryTest, TestBillsShareCategoryObject) {
+    const std::string dir = "./test_data/test_shared_category";
+    std::filesystem::remove_all(dir);
+
+    auto storage = std::make_shared<JsonStorage>(dir);
+    auto t0 = std::chrono::system_clock::from_time_t(1700000000);
+    int user_id = 0;
+    {
+        AccountManager seed(storage);
+        ASSERT_TRUE(seed.Initialize());
+        ASSERT_TRUE(seed.RegisterUser("alice", "password1"));
+        auto user = seed.Login("alice", "password1");
+        user_id = user->GetUserId();
+        ASSERT_TRUE(seed.AddCategory(*user, Category(1, "餐饮", "expense", "#FF6B6B")));
+        // 传入分类副本，写入后也换成共享对象
+        auto copy = std::make_shared<Category>(seed.GetCategories(*user)[0]);
+        ASSERT_TRUE(seed.AddBill(user_id, Bill(0, 1.0, copy, t0, "a")));
+        ASSERT_TRUE(seed.AddBill(user_id, Bill(0, 2.0, copy, t0, "b")));
+        auto bills = seed.GetBills(user_id);
+        ASSERT_EQ(bills.size(), 2);
+        EXPECT_EQ(bills[0].GetCategory(), seed.GetCategory(*user, 1));
+        ASSERT_TRUE(seed.SaveAll());
+    }
+
+    AccountManager manager(storage);
+    ASSERT_TRUE(manager.Initialize());
+    auto user = manager.Login("alice", "password1");
+    auto shared = manager.GetCategory(*user, 1);
+    ASSERT_NE(shared, nullptr);
+    auto bills = manager.GetBills(user_id);
+    ASSERT_EQ(bills.size(), 2);
+    EXPECT_EQ(bills[0].GetCategory(), shared);
+    EXPECT_EQ(bills[1].GetCategory(), shared);
+
+    Category renamed = *shared;
+    renamed.SetName("外卖");
+    ASSERT_TRUE(manager.UpdateCategory(*user, renamed));
+    EXPECT_EQ(bills[0].GetCategory()->GetName(), "外卖");
+    EXPECT_EQ(manager.GetBills(user_id)[1].GetCategory()->GetName(), "外卖");
+
+    std::filesystem::remove_all(dir);
+}
+
+TEST(SharedCategoryTest, TestRenameReachesBillsAfterRelogin) {
+    const std::string dir = "./test_data/test_shared_category_relogin";
+    std::filesystem::remove_all(dir);
+
+    JsonStorageOptions storage_options;
+    storage_options.layout = JsonStorageOptions::Layout::kSharded;
+    auto storage = std::make_shared<JsonStorage>(dir, storage_options);
+    auto t0 = std::chrono::system_clock::from_time_t(1700000000);
+    {
+        AccountManager seed(storage);
+        ASSERT_TRUE(seed.Initialize());
+        ASSERT_TRUE(seed.RegisterUser("alice", "password1"));
+        ASSERT_TRUE(seed.RegisterUser("bob", "password2"));
+        auto user = seed.Login("alice", "password1");
+        ASSERT_TRUE(seed.AddCategory(*user, Category(1, "餐饮", "expense", "#FF6B6B")));
+        ASSERT_TRUE(seed.SaveAll());
+    }
+
+    AccountManagerOptions options;
+    options.lazy_load = true;
+    options.max_resident_users = 1;
+    AccountManager manager(storage, options);
+    ASSERT_TRUE(manager.Initialize());
+    auto user = manager.Login("alice", "password1");
+    ASSERT_TRUE(user);
+    const int user_id = user->GetUserId();
+    ASSERT_TRUE(manager.AddBill(user_id, Bill(0, 1.0, nullptr, t0, "a")));
+    Bill bill = manager.GetBills(user_id)[0];
+    bill.SetCategory(manager.GetCategory(*user, 1));
+    ASSERT_TRUE(manager.UpdateBill(user_id, bill));
+
+    // alice 有未保存的账单，bob 登录后仍整体常驻；改名要同步到 alice 的账单
+    ASSERT_TRUE(manager.Login("bob", "password2"));
+    ASSERT_TRUE(manager.Login("alice", "password1"));
+    Category renamed = *manager.GetCategory(*user, 1);
+    renamed.SetName("外卖");
+    ASSERT_TRUE(manager.UpdateCategory(*user, renamed));
+    auto bills = manager.GetBills(user_id);
+    ASSERT_EQ(bills.size(), 1);
+    EXPECT_EQ(bills[0].GetCategory(), manager.GetCategory(*user, 1));
+    EXPECT_EQ(bills[0].GetCategory()->GetName(), "外卖");
+
+    // 保存后释放、重新登录，再次改名同样生效
+    ASSERT_TRUE(manager.SaveAll());
+    ASSERT_TRUE(manager.Login("bob", "password2"));
+    ASSERT_TRUE(manager.Login("alice", "password1"));
+    renamed.SetName("堂食");
+    ASSERT_TRUE(manager.UpdateCategory(*user, renamed));
+    bills = manager.GetBills(user_id);
+    ASSERT_EQ(bills.size(), 1);
+    EXPECT_EQ(bills[0].GetCategory(), manager.GetCategory(*user, 1));
+    EXPECT_EQ(bills[0].GetCategory()->GetName(), "堂食");
+
+    std::filesystem::remove_all(dir);
+}
+
 // ==================== Main 函数 ====================
 int main(int argc, char** argv) {
     ::testing::InitGoogleTest(&argc, argv);
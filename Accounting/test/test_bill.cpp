@@ -1,12 +1,24 @@
 #include <gtest/gtest.h>
 #include "core/account_manager.h"
+#include "managers/bill_columns.h"
+#include "managers/bill_rollup.h"
 #include "managers/category_manager.h"
 #include "models/bill.h"
 #include "models/category.h"
+#include "models/money.h"
+#include "models/report.h"
 #include "models/user.h"
 #include "storage/storage.h"
 #include "storage/json_storage.h"
+#include "utils/money_sum.h"
+#include "utils/time_utils.h"
 #include <chrono>
+#include <cstring>
+#include <ctime>
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <set>
 #include <vector>
 
 using namespace accounting;
@@ -343,4 +355,368 @@ TEST_F(AccountManagerTest, TestAddDeleteQueryBills) {
     // 再次查询账单，确保账单已被删除
     all_bills = account_manager->GetBills(user.GetUserId());
     ASSERT_EQ(all_bills.size(), 0) << "删除账单后，账单数量不匹配";
-}
\ No newline at end of file
+}
+// 测试用例 11: 账单时间字符串的解析与格式化与 C 库（localtime / mktime）结果一致
+TEST(BillTimeTest, TestMatchesCLibrary) {
+    for (std::time_t t : {std::time_t(0), std::time_t(-86400 * 400 + 1234),
+                          std::time_t(951782400),      // 2000-02-29 附近
+                          std::time_t(1710054000),     // 2024-03 夏令时切换附近
+                          std::time_t(1730613600), std::time_t(1700000000)}) {
+        auto tp = std::chrono::system_clock::from_time_t(t);
+
+        std::tm tm = *std::localtime(&t);
+        char expected[32];
+        std::strftime(expected, sizeof(expected), "%Y-%m-%d %H:%M:%S", &tm);
+        EXPECT_EQ(BillTimeToString(tp), expected);
+
+        tm.tm_isdst = -1;
+        EXPECT_EQ(BillTimeFromString(expected),
+                  std::chrono::system_clock::from_time_t(std::mktime(&tm))) << expected;
+    }
+
+    // 格式不符时返回纪元时间
+    EXPECT_EQ(BillTimeFromString("2024/01/01 00:00:00"), std::chrono::system_clock::time_point());
+    EXPECT_EQ(BillTimeFromString("2024-01-01 24:00:00"), std::chrono::system_clock::time_point());
+
+    // 0-9999 以外的年份不截断，格式化后可原样读回
+    for (int year : {0, 9999, 10000, 123456, -1, -10000}) {
+        time_utils::CivilTime local;
+        local.year = year;
+        local.month = 2;
+        local.day = 28;
+        local.hour = 13;
+        const std::string text = time_utils::FormatDateTime(local);
+        time_utils::CivilTime parsed;
+        ASSERT_TRUE(time_utils::ParseDateTime(text.data(), text.size(), parsed)) << text;
+        EXPECT_EQ(parsed.year, year) << text;
+        EXPECT_EQ(time_utils::FormatDateTime(parsed), text);
+    }
+    time_utils::CivilTime far;
+    far.year = 10000;
+    EXPECT_EQ(time_utils::FormatDateTime(far), "10000-01-01 00:00:00");
+    far.year = -1;
+    EXPECT_EQ(time_utils::FormatDateTime(far), "-0001-01-01 00:00:00");
+    time_utils::CivilTime ignored;
+    for (const char* bad : {"999-01-01", "+2024-01-01", "1234567890-01-01", "-2024-01-01 00:00"}) {
+        EXPECT_FALSE(time_utils::ParseDateTime(bad, std::strlen(bad), ignored)) << bad;
+    }
+}
+
+// 测试用例 12: 列式账单存储的增删改与按行构造
+TEST(BillColumnsTest, TestRowOperations) {
+    auto food = std::make_shared<Category>(1, "餐饮", "expense", "#FF6B6B");
+    auto t0 = std::chrono::system_clock::from_time_t(1700000000);
+    BillColumns columns;
+    for (int i = 1; i <= 4; ++i) {
+        Bill bill(i, i * 1.5, i % 2 ? food : nullptr, t0 + std::chrono::hours(i),
+                  std::string(3000, static_cast<char>('a' + i)));
+        columns.Append(bill);
+    }
+    ASSERT_EQ(columns.Size(), 4);
+    EXPECT_EQ(columns.AmountCents()[2], 450);
+    EXPECT_EQ(columns.CategoryIds()[1], -1);
+
+    // 同一分类 id 的行共享分类指针
+    Bill second = columns.Materialize(2);
+    ASSERT_NE(second.GetCategory(), nullptr);
+    EXPECT_EQ(second.GetCategory()->GetName(), "餐饮");
+    EXPECT_EQ(second.GetContent(), std::string(3000, 'd'));
+
+    // 删除用最后一行填补；废弃文本过多时压缩文本区，内容不变
+    columns.SwapRemove(0);
+    Bill updated = columns.Materialize(1);
+    updated.SetContent("short");
+    columns.Assign(1, updated);
+    updated = columns.Materialize(0);
+    updated.SetContent("x");
+    columns.Assign(0, updated);
+    ASSERT_EQ(columns.Size(), 3);
+    EXPECT_EQ(columns.BillIds(), std::vector<int>({4, 2, 3}));
+    EXPECT_EQ(columns.Content(0), "x");
+    EXPECT_EQ(columns.Content(1), "short");
+    EXPECT_EQ(columns.Content(2), std::string(3000, 'd'));
+
+    // 取消分类关联后保留分类 id
+    columns.SetCategory(1, nullptr);
+    Bill unlinked = columns.Materialize(2);
+    EXPECT_EQ(unlinked.GetCategory(), nullptr);
+    EXPECT_EQ(unlinked.GetCategoryId(), 1);
+}
+
+// 测试用例 13: 定点金额的换算、JSON 往返与求和内核
+TEST(MoneyTest, TestExactArithmeticAndSum) {
+    // 0.1 + 0.2 按分累加不产生误差
+    EXPECT_EQ(Money::FromDouble(0.1) + Money::FromDouble(0.2), Money::FromDouble(0.3));
+    EXPECT_EQ(Money::FromDouble(0.29).Cents(), 29);
+    EXPECT_EQ(Money::FromDouble(-12.345).Cents(), -1235);
+    EXPECT_EQ(Money::FromCents(-5).ToString(), "-0.05");
+    EXPECT_EQ(Money::FromCents(1250).ToString(), "12.50");
+
+    Money parsed;
+    ASSERT_TRUE(Money::Parse("12.345", parsed));
+    EXPECT_EQ(parsed.Cents(), 1235);
+    ASSERT_TRUE(Money::Parse("-7", parsed));
+    EXPECT_EQ(parsed.Cents(), -700);
+    EXPECT_FALSE(Money::Parse("1.2.3", parsed));
+    EXPECT_FALSE(Money::Parse("", parsed));
+
+    // JSON 中仍是十进制数，读回后分值不变
+    for (int64_t cents : {0, 1, 29, 1250, -999, 123456789}) {
+        json j = Money::FromCents(cents);
+        EXPECT_TRUE(j.is_number());
+        EXPECT_EQ(json::parse(j.dump()).get<Money>().Cents(), cents);
+    }
+    EXPECT_EQ(json::parse("8").get<Money>().Cents(), 800);
+
+    // 超出 int64 分范围的金额：读取时抛出，直接换算时取边界值，不回绕
+    for (const char* text : {"92233720368547759", "18446744073709551615", "-92233720368547759",
+                             "1e300", "-1e17"}) {
+        EXPECT_THROW(json::parse(text).get<Money>(), std::out_of_range) << text;
+    }
+    EXPECT_EQ(json::parse("92233720368547758").get<Money>().Cents(), 9223372036854775800);
+    EXPECT_FALSE(Money::TryFromDouble(std::numeric_limits<double>::quiet_NaN(), parsed));
+    EXPECT_FALSE(Money::TryFromDouble(1e17, parsed));
+    EXPECT_EQ(Money::FromDouble(1e300).Cents(), std::numeric_limits<int64_t>::max());
+    EXPECT_EQ(Money::FromDouble(-1e300).Cents(), -std::numeric_limits<int64_t>::max());
+    EXPECT_EQ(Money::FromDouble(std::numeric_limits<double>::quiet_NaN()).Cents(), 0);
+
+    // 求和结果与分块、是否并行无关，且等于逐个顺序累加
+    std::vector<int64_t> cents;
+    std::vector<std::chrono::system_clock::time_point> times;
+    auto t0 = std::chrono::system_clock::from_time_t(1700000000);
+    int64_t expected = 0;
+    int64_t expected_in_range = 0;
+    for (int i = 0; i < 200003; ++i) {
+        cents.push_back((i * 7919) % 100003 - 50000);
+        times.push_back(t0 + std::chrono::seconds(i));
+        expected += cents.back();
+        if (i >= 1000 && i <= 150000) expected_in_range += cents.back();
+    }
+    EXPECT_EQ(money_sum::SumCents(cents.data(), cents.size()), expected);
+    EXPECT_EQ(money_sum::ParallelSumCents(cents.data(), cents.size()), expected);
+    EXPECT_EQ(money_sum::SumCentsInTimeRange(cents.data(), times.data(), cents.size(),
+                                             times[1000], times[150000]),
+              expected_in_range);
+    EXPECT_EQ(money_sum::ParallelSumCentsInTimeRange(cents.data(), times.data(), cents.size(),
+                                                     times[1000], times[150000]),
+              expected_in_range);
+}
+
+// 测试用例 14: 批量添加账单，逐行返回结果且索引与逐个添加一致
+TEST_F(AccountManagerTest, TestAddBillsBatch) {
+    Budget budget;
+    budget.SetTotalLimit(500.0);
+    budget.SetCategoryLimit(1, 200.0);  // "Food" 分类的预算为 200 元
+    account_manager->SetBudget(user.GetUserId(), budget);
+
+    auto food = std::make_shared<Category>(category_manager->GetCategoriesForUser(user)[0]);
+    auto transport = std::make_shared<Category>(category_manager->GetCategoriesForUser(user)[1]);
+    auto t0 = std::chrono::system_clock::now() - std::chrono::hours(1000);
+
+    // 先逐个添加一个较晚的账单并建立时间索引，批量中的账单需要与之归并
+    Bill existing(0, 10.0, food, t0 + std::chrono::hours(500), "existing");
+    ASSERT_TRUE(account_manager->AddBill(user.GetUserId(), existing));
+    ASSERT_EQ(account_manager->GetBillsByCategory(user.GetUserId(), 1).size(), 1);
+
+    std::vector<Bill> batch;
+    for (int i = 0; i < 100; ++i) {
+        batch.emplace_back(0, 1.0 + i, i % 2 ? transport : food,
+                           t0 + std::chrono::hours(999 - i * 7), "row" + std::to_string(i));
+    }
+    batch[10].SetAmount(-1.0);   // 金额非法
+    batch[20].SetAmount(300.0);  // 超过 "Food" 分类预算
+    batch[30].SetBillId(1);      // 与已有账单 id 重复
+
+    auto results = account_manager->AddBillsEx(user.GetUserId(), std::move(batch));
+    ASSERT_EQ(results.size(), 100);
+    EXPECT_EQ(results[10].GetErrorCode(), ErrorCode::InvalidBill);
+    EXPECT_EQ(results[20].GetErrorCode(), ErrorCode::BudgetExceeded);
+    EXPECT_EQ(results[30].GetErrorCode(), ErrorCode::StorageError);
+    size_t succeeded = 0;
+    for (const auto& result : results) succeeded += result.IsSuccess();
+    EXPECT_EQ(succeeded, 97);
+
+    auto all = account_manager->GetBills(user.GetUserId());
+    ASSERT_EQ(all.size(), 98);
+    std::set<int> ids;
+    for (const auto& bill : all) ids.insert(bill.GetBillId());
+    EXPECT_EQ(ids.size(), all.size());
+
+    // 时间索引和分类索引按 (时间, id) 有序且包含批量添加的账单
+    auto food_bills = account_manager->GetBillsByCategory(user.GetUserId(), 1);
+    EXPECT_EQ(food_bills.size(), 48);  // 50 行中去掉 10、20、30，再加上已有的 1 个
+    EXPECT_TRUE(std::is_sorted(food_bills.begin(), food_bills.end(),
+                               [](const Bill& a, const Bill& b) {
+                                   return a.GetTime() < b.GetTime();
+                               }));
+    auto transport_bills = account_manager->GetBillsByCategory(user.GetUserId(), 2);
+    EXPECT_EQ(transport_bills.size(), 50);
+    ASSERT_NE(transport_bills[0].GetCategory(), nullptr);
+    EXPECT_EQ(transport_bills[0].GetCategory()->GetName(), "Transport");
+}
+
+// 测试用例 15: 游标分页遍历全部账单，不重复、不遗漏
+TEST_F(AccountManagerTest, TestGetBillsAfterCursor) {
+    auto food = std::make_shared<Category>(category_manager->GetCategoriesForUser(user)[0]);
+    auto t0 = std::chrono::system_clock::now() - std::chrono::hours(100);
+    std::vector<Bill> batch;
+    for (int i = 0; i < 23; ++i) {
+        batch.emplace_back(0, 1.0 + i, food, t0 + std::chrono::hours(23 - i), "row");
+    }
+    account_manager->AddBillsEx(user.GetUserId(), std::move(batch));
+
+    std::vector<int> ids;
+    BillCursor cursor;
+    int pages = 0;
+    while (true) {
+        auto page = account_manager->GetBillsAfter(user.GetUserId(), cursor, 5);
+        ++pages;
+        for (const auto& bill : page.items) ids.push_back(bill.GetBillId());
+        cursor = page.next_cursor;
+        if (!page.has_more) break;
+    }
+    EXPECT_EQ(pages, 5);
+    // 时间越早的账单 id 越大
+    std::vector<int> expected;
+    for (int id = 23; id >= 1; --id) expected.push_back(id);
+    EXPECT_EQ(ids, expected);
+    EXPECT_TRUE(account_manager->GetBillsAfter(user.GetUserId(), cursor, 5).items.empty());
+}
+
+// 测试用例 16: 报表按天 / 周 / 月 / 年划分时间段，各时间段合计之和等于总计
+TEST(ReportTest, TestPeriodBuckets) {
+    auto at = [](int year, int month, int day, int hour) {
+        time_utils::CivilTime local;
+        local.year = year;
+        local.month = month;
+        local.day = day;
+        local.hour = hour;
+        return time_utils::LocalToTimePoint(local);
+    };
+    // 2023-12-31 是周日，2024-01-01 是周一；2024 为闰年
+    std::vector<BillData> bills = {
+        BillData(Money::FromCents(100), "餐饮", "expense", at(2023, 12, 31, 23), "跨年夜"),
+        BillData(Money::FromCents(200), "餐饮", "expense", at(2024, 1, 1, 0), "元旦"),
+        BillData(Money::FromCents(5000), "工资", "income", at(2024, 1, 31, 12), "一月工资"),
+        BillData(Money::FromCents(300), "交通", "expense", at(2024, 2, 29, 8), "闰日"),
+        BillData(Money::FromCents(400), "餐饮", "expense", at(2024, 3, 1, 8), ""),
+        BillData(Money::FromCents(50), "", "", at(2024, 1, 1, 12), "未分类"),
+    };
+    auto labels = [](const Report& report) {
+        std::vector<std::string> out;
+        for (const auto& bucket : report.GetSeries()) out.push_back(bucket.label);
+        return out;
+    };
+
+    Report daily = Report::Generate(bills, QueryCriteria(), Period::kDaily, ChartType::kLine);
+    EXPECT_EQ(labels(daily), std::vector<std::string>({"2023-12-31", "2024-01-01", "2024-01-31",
+                                                       "2024-02-29", "2024-03-01"}));
+    const ReportBucket& new_year = daily.GetSeries()[1];
+    EXPECT_EQ(new_year.start, at(2024, 1, 1, 0));
+    EXPECT_EQ(new_year.total_expense, Money::FromCents(200));
+    EXPECT_EQ(new_year.category_summary.size(), 2u);
+    EXPECT_DOUBLE_EQ(new_year.category_summary.at("Uncategorized"), 0.5);
+
+    Report weekly = Report::Generate(bills, QueryCriteria(), Period::kWeekly, ChartType::kLine);
+    EXPECT_EQ(labels(weekly), std::vector<std::string>({"2023-12-25", "2024-01-01", "2024-01-29",
+                                                        "2024-02-26"}));
+
+    Report monthly = Report::Generate(bills, QueryCriteria(), Period::kMonthly, ChartType::kBar);
+    EXPECT_EQ(labels(monthly),
+              std::vector<std::string>({"2023-12", "2024-01", "2024-02", "2024-03"}));
+    EXPECT_EQ(monthly.GetSeries()[1].total_income, Money::FromCents(5000));
+    EXPECT_EQ(monthly.GetSeries()[1].total_expense, Money::FromCents(200));
+
+    Report yearly = Report::Generate(bills, QueryCriteria(), Period::kYearly, ChartType::kPie);
+    EXPECT_EQ(labels(yearly), std::vector<std::string>({"2023", "2024"}));
+    Money expense;
+    for (const auto& bucket : yearly.GetSeries()) expense += bucket.total_expense;
+    EXPECT_EQ(expense, yearly.GetTotalExpenseMoney());
+    EXPECT_DOUBLE_EQ(yearly.GetSeries()[1].category_summary.at("餐饮"), 6.0);
+
+    EXPECT_TRUE(Report::Generate(bills, QueryCriteria(), Period::kCustom, ChartType::kBar)
+                    .GetSeries()
+                    .empty());
+}
+
+// 测试用例 17: 按日汇总的区间合计与逐个账单累加一致，保存的汇总只在与账单、时区一致时使用
+TEST(BillRollupTest, TestRangeSumsAndSnapshot) {
+    auto t0 = time_utils::LocalDayStart(19000);  // 本地 0 点
+    std::vector<Bill> bills;
+    for (int i = 0; i < 60; ++i) {
+        Bill bill;
+        bill.SetBillId(i + 1);
+        bill.SetTime(t0 + std::chrono::hours(i * 13));  // 约每两天 4 笔，跨越 33 天
+        bill.SetCategoryId(i % 3);
+        bill.SetMoney(Money::FromCents(100 + i));
+        bills.push_back(bill);
+    }
+    BillColumns columns(bills);
+    BillRollup rollup(columns);
+    EXPECT_EQ(rollup.BillCount(), 60u);
+
+    auto brute_force = [&columns](int category_id, int64_t first_day, int64_t last_day) {
+        int64_t cents = 0;
+        size_t count = 0;
+        for (size_t row = 0; row < columns.Size(); ++row) {
+            const int64_t day = time_utils::LocalDayNumber(columns.Times()[row]);
+            if (day < first_day || day > last_day) continue;
+            if (category_id >= 0 && columns.CategoryIds()[row] != category_id) continue;
+            cents += columns.AmountCents()[row];
+            ++count;
+        }
+        return std::make_pair(cents, count);
+    };
+    auto expect_consistent = [&]() {
+        for (int64_t first = 18998; first <= 19035; first += 3) {
+            for (int64_t last = first - 1; last <= 19036; last += 5) {
+                for (int category_id = 0; category_id < 3; ++category_id) {
+                    auto total = rollup.SumCategory(category_id, first, last);
+                    auto expected = brute_force(category_id, first, last);
+                    EXPECT_EQ(total.total.Cents(), expected.first);
+                    EXPECT_EQ(total.count, expected.second);
+                }
+                auto all = rollup.SumAll(first, last);
+                EXPECT_EQ(all.total.Cents(), brute_force(-1, first, last).first);
+            }
+        }
+    };
+    expect_consistent();
+
+    // 删除、修改（换日期和分类）后按差值更新，前缀和重新补算
+    auto remove_row = [&](size_t row) {
+        rollup.Remove(columns.BillIds()[row], columns.Times()[row], columns.CategoryIds()[row],
+                      columns.AmountCents()[row]);
+    };
+    remove_row(10);
+    columns.SwapRemove(10);
+    Bill moved = columns.Materialize(3);
+    remove_row(3);
+    moved.SetTime(t0 + std::chrono::hours(24 * 40));
+    moved.SetCategoryId(7);
+    columns.Assign(3, moved);
+    rollup.Add(moved.GetBillId(), moved.GetTime(), moved.GetCategoryId(), moved.GetMoney().Cents());
+    expect_consistent();
+    EXPECT_EQ(rollup.SumCategory(7).count, 1u);
+
+    std::vector<int64_t> days;
+    rollup.ForEachDay(0, 19000, 19004, [&days](int64_t day, const BillRollup::Total&) {
+        days.push_back(day);
+    });
+    EXPECT_TRUE(std::is_sorted(days.begin(), days.end()));
+    EXPECT_FALSE(days.empty());
+
+    // 快照：账单一致时恢复出相同的汇总；账单变化（金额不变、只换日期）时拒绝
+    BillRollupSnapshot snapshot = rollup.ToSnapshot();
+    BillRollup restored;
+    ASSERT_TRUE(BillRollup::FromSnapshot(snapshot, columns, restored));
+    EXPECT_EQ(restored.SumAll(19001, 19020).total, rollup.SumAll(19001, 19020).total);
+    // 写入时的本地日期边界与当前时区不同（如时区或夏令时规则变化）时拒绝
+    BillRollupSnapshot other_zone = snapshot;
+    other_zone.day_fingerprint ^= 1;
+    EXPECT_FALSE(BillRollup::FromSnapshot(other_zone, columns, restored));
+    Bill shifted = columns.Materialize(0);
+    shifted.SetTime(shifted.GetTime() + std::chrono::hours(24));
+    columns.Assign(0, shifted);
+    EXPECT_FALSE(BillRollup::FromSnapshot(snapshot, columns, restored));
+}